@@ -0,0 +1,143 @@
+// bench_allocations.cpp — Heap allocations per report, default vs arena
+// A counting global operator new tallies every heap allocation made on the
+// calling thread. Each report runs once with the default resource and once
+// with a core::MonotonicArena that is reset between calls, next to the old
+// find_all-based summary as a baseline. Notes give allocations per call.
+#include "../src/core/memory_resource.hpp"
+#include "../src/service/report_service.hpp"
+#include "bench_harness.hpp"
+#include <cstdlib>
+#include <filesystem>
+#include <new>
+
+namespace {
+thread_local std::size_t heap_allocations = 0;
+} // namespace
+
+// Plain and aligned forms: new_delete_resource() uses the aligned one.
+// GCC flags malloc/free inside a replaced operator new/delete as mismatched.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+void *operator new(std::size_t size) {
+  heap_allocations++;
+  if (void *p = std::malloc(size ? size : 1))
+    return p;
+  throw std::bad_alloc();
+}
+void *operator new(std::size_t size, std::align_val_t align) {
+  heap_allocations++;
+  auto a = static_cast<std::size_t>(align);
+  if (void *p = std::aligned_alloc(a, (size + a - 1) / a * a))
+    return p;
+  throw std::bad_alloc();
+}
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+void operator delete(void *p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t, std::align_val_t) noexcept {
+  std::free(p);
+}
+#pragma GCC diagnostic pop
+
+namespace {
+
+// Invoice and payment snapshots written directly, ~1/3 of invoices open
+std::string build_dataset(std::size_t invoices) {
+  using namespace billing;
+  auto dir = std::filesystem::temp_directory_path() /
+             ("billing_bench_alloc_" + std::to_string(invoices));
+  std::filesystem::remove_all(dir);
+  std::filesystem::create_directories(dir);
+  std::time_t now = std::time(nullptr);
+
+  repository::RecordStore<repository::InvoiceCodec> inv;
+  repository::RecordStore<repository::PaymentCodec> pay;
+  for (std::size_t i = 1; i <= invoices; ++i) {
+    models::Invoice v{};
+    v.id = static_cast<int64_t>(i);
+    v.customer_id = static_cast<int64_t>(1 + i % 100);
+    v.invoice_number = "INV-2024-" + std::to_string(100000 + i);
+    v.currency = "USD";
+    v.total_amount = 100.0 + static_cast<double>(i % 900);
+    v.due_date = now - static_cast<std::time_t>((i * 7919) % (86400 * 150));
+    v.line_items.push_back({"Subscription, monthly plan", 1, v.total_amount});
+    bool paid = i % 3 != 0;
+    v.status = paid ? models::InvoiceStatus::PAID
+                    : models::InvoiceStatus::PENDING;
+    v.amount_paid = paid ? v.total_amount : 0.0;
+    inv.put(v);
+    if (paid) {
+      models::Payment p{};
+      p.id = v.id;
+      p.invoice_id = v.id;
+      p.customer_id = v.customer_id;
+      p.status = models::PaymentStatus::COMPLETED;
+      p.amount = v.total_amount;
+      p.completed_at = v.due_date - 86400;
+      p.currency = "USD";
+      pay.put(p);
+    }
+  }
+  inv.checkpoint((dir / "invoices.bin").string());
+  pay.checkpoint((dir / "payments.bin").string());
+  return dir.string();
+}
+
+} // namespace
+
+void run_allocation_bench(billing::bench::BenchSuite &suite) {
+  using namespace billing;
+  std::size_t n = suite.n(200000);
+  std::string tag = " [invoices=" + std::to_string(n) + "]";
+  auto dir = build_dataset(n);
+  {
+    repository::CustomerRepository customers(dir);
+    repository::InvoiceRepository invoices(dir);
+    repository::PaymentRepository payments(dir);
+    service::ReportService reports(invoices, customers, payments, dir);
+    core::MonotonicArena arena(64 * 1024);
+
+    // Warms up once, then counts the allocations of one more call
+    auto row = [&](const std::string &label, auto fn) {
+      fn();
+      std::size_t before = heap_allocations;
+      fn();
+      std::size_t allocs = heap_allocations - before;
+      suite.measure(label + tag, n, fn);
+      suite.note("heap allocations per call: " + std::to_string(allocs));
+    };
+
+    row("summary, find_all (old)", [&] {
+      double total = 0;
+      for (auto &p : payments.find_all())
+        if (p.status == models::PaymentStatus::COMPLETED)
+          total += p.amount;
+      for (auto &inv : invoices.find_all())
+        total += inv.amount_due();
+      bench::do_not_optimize(total);
+    });
+    row("generate_summary, default", [&] {
+      bench::do_not_optimize(reports.generate_summary().total_revenue);
+    });
+    row("generate_summary, arena", [&] {
+      arena.reset();
+      bench::do_not_optimize(reports.generate_summary(&arena).total_revenue);
+    });
+    row("aging_report, default", [&] {
+      bench::do_not_optimize(reports.aging_report().grand_total_overdue);
+    });
+    row("aging_report, arena", [&] {
+      arena.reset();
+      bench::do_not_optimize(reports.aging_report(&arena).grand_total_overdue);
+    });
+    row("sma_forecast, default",
+        [&] { bench::do_not_optimize(reports.sma_forecast().size()); });
+    row("sma_forecast, arena", [&] {
+      arena.reset();
+      bench::do_not_optimize(reports.sma_forecast(3, 3, &arena).size());
+    });
+    suite.note("arena chunks: " + std::to_string(arena.chunk_count()) +
+               ", reserved bytes: " + std::to_string(arena.bytes_reserved()));
+  }
+  std::filesystem::remove_all(dir);
+}
@@ -0,0 +1,127 @@
+// bench_batch_billing.cpp — invoice generation: one create_invoice per
+// request vs the staged batch_create pipeline. The per-request path takes
+// the invoice-number, scheduler and observer locks and makes one log commit
+// per invoice; the pipeline takes each once per chunk. Stage rows report
+// busy time summed over a stage's workers and the deepest its input queue
+// got, which shows where the pipeline is bound.
+#include "../src/repository/customer_repository.hpp"
+#include "../src/repository/invoice_repository.hpp"
+#include "../src/repository/write_batch.hpp"
+#include "../src/service/billing_engine.hpp"
+#include "bench_harness.hpp"
+#include <cstdio>
+#include <filesystem>
+#include <vector>
+
+namespace {
+
+using namespace billing;
+
+constexpr int64_t CUSTOMERS = 10000;
+
+struct CountingObserver : service::BillingObserver {
+  std::size_t created = 0;
+  void on_invoice_created(const models::Invoice &) override { created++; }
+  void on_invoice_paid(const models::Invoice &) override {}
+  void on_invoice_overdue(const models::Invoice &) override {}
+};
+
+std::filesystem::path fresh_dir(const std::string &name) {
+  auto dir = std::filesystem::temp_directory_path() / name;
+  std::filesystem::remove_all(dir);
+  std::filesystem::create_directories(dir);
+  return dir;
+}
+
+void seed_customers(repository::CustomerRepository &repo) {
+  static const char *states[] = {"CA", "NY", "TX", "WA"};
+  repository::WriteBatch batch;
+  for (int64_t id = 1; id <= CUSTOMERS; ++id) {
+    models::Customer c{};
+    c.id = id;
+    c.name = "Customer " + std::to_string(id);
+    c.email = "c" + std::to_string(id) + "@example.com";
+    c.country = "US";
+    c.state = states[id % 4];
+    c.tier = static_cast<models::CustomerTier>(id % 4);
+    c.created_at = std::time(nullptr) - (id % 700) * 86400;
+    batch.save(c);
+  }
+  batch.commit(repo);
+}
+
+// A few invoices per customer, consecutive like a billing run produces
+std::vector<service::InvoiceRequest> make_requests(std::size_t n) {
+  std::vector<service::InvoiceRequest> reqs(n);
+  for (std::size_t i = 0; i < n; ++i) {
+    auto &r = reqs[i];
+    r.customer_id = 1 + static_cast<int64_t>((i / 4) % CUSTOMERS);
+    r.type = models::InvoiceType::ONE_TIME;
+    r.line_items = {{"Seats", 1 + static_cast<int>(i % 5), 25.0},
+                    {"Support", 1, 99.0}};
+  }
+  return reqs;
+}
+
+std::string fmt(const char *pattern, double a, double b, double c) {
+  char buf[128];
+  std::snprintf(buf, sizeof(buf), pattern, a, b, c);
+  return buf;
+}
+
+} // namespace
+
+void run_batch_billing_bench(billing::bench::BenchSuite &suite) {
+  using namespace billing;
+  auto dir = fresh_dir("billing_bench_batch");
+  {
+    repository::CustomerRepository customers(dir.string());
+    seed_customers(customers);
+  }
+  service::DiscountEngine disc;
+  service::TaxEngine tax;
+
+  {
+    std::size_t n = suite.n(20000);
+    auto reqs = make_requests(n);
+    auto inv_dir = fresh_dir("billing_bench_batch_seq");
+    repository::CustomerRepository customers(dir.string());
+    repository::InvoiceRepository invoices(inv_dir.string());
+    service::BillingEngine engine(invoices, customers, disc, tax);
+    CountingObserver obs;
+    engine.add_observer(&obs);
+    suite.measure("create_invoice per request [n=" + std::to_string(n) + "]",
+                  n, [&] {
+                    for (auto &r : reqs)
+                      engine.create_invoice(r);
+                  });
+    std::filesystem::remove_all(inv_dir);
+  }
+
+  std::size_t n = suite.n(1000000);
+  auto reqs = make_requests(n);
+  for (int price_workers : {1, 4}) {
+    auto inv_dir = fresh_dir("billing_bench_batch_pipe");
+    repository::CustomerRepository customers(dir.string());
+    repository::InvoiceRepository invoices(inv_dir.string());
+    service::BillingEngine engine(invoices, customers, disc, tax);
+    CountingObserver obs;
+    engine.add_observer(&obs);
+    service::BatchOptions opts;
+    opts.price_workers = price_workers;
+    suite.measure("batch_create pipeline [n=" + std::to_string(n) +
+                      ", price_workers=" + std::to_string(price_workers) +
+                      "]",
+                  n, [&] { engine.batch_create(reqs, opts); });
+    auto stats = engine.last_batch_stats();
+    suite.note("created " + std::to_string(stats.created) + ", observed " +
+               std::to_string(obs.created));
+    for (auto &s : stats.stages)
+      suite.note(s.name + ": " +
+                 fmt("%.1f ms busy, %.2fM items/s per worker, max queue %.0f",
+                     s.busy_ms, s.items_per_sec() / 1e6,
+                     static_cast<double>(s.max_queue_depth)));
+    std::filesystem::remove_all(inv_dir);
+  }
+  std::filesystem::remove_all(dir);
+}
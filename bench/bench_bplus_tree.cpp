@@ -0,0 +1,110 @@
+// bench_bplus_tree.cpp — BPlusTree node layout and in-node search
+// Compares the original order-4 tree (one node type, linear scans) against
+// the current order-64 tree on random int64 keys.
+#include "../src/core/bplus_tree.hpp"
+#include "bench_harness.hpp"
+#include "legacy/bplus_tree_v1.hpp"
+#include <algorithm>
+#include <memory>
+#include <numeric>
+#include <random>
+
+namespace {
+
+constexpr std::size_t RANGES = 10000;
+constexpr int64_t RANGE_SPAN = 1000; // keys per range query on average
+
+template <typename Tree>
+void bench_tree(billing::bench::BenchSuite &suite, const std::string &name,
+                const std::vector<int64_t> &keys,
+                const std::vector<int64_t> &probes) {
+  using billing::bench::do_not_optimize;
+  auto tree = std::make_unique<Tree>();
+  suite.measure(name + " insert", keys.size(), [&] {
+    for (int64_t k : keys)
+      tree->insert(k, k);
+  });
+
+  int64_t sum = 0;
+  suite.measure(name + " search", probes.size(), [&] {
+    for (int64_t k : probes)
+      sum += tree->search(k).value_or(0);
+  });
+  do_not_optimize(sum);
+
+  std::size_t hits = 0;
+  int64_t universe = static_cast<int64_t>(keys.size()) * 2;
+  suite.measure(name + " range (~500 hits)", RANGES, [&] {
+    for (std::size_t i = 0; i < RANGES; ++i) {
+      int64_t lo = probes[i] % universe;
+      hits += tree->range(lo, lo + RANGE_SPAN).size();
+    }
+  });
+  do_not_optimize(hits);
+}
+
+} // namespace
+
+void run_bplus_tree_bench(billing::bench::BenchSuite &suite) {
+  std::size_t n = suite.n(10000000);
+  std::string tag = " [n=" + std::to_string(n) + "]";
+
+  // Even keys in random order; probes hit present keys in random order
+  std::vector<int64_t> keys(n);
+  std::iota(keys.begin(), keys.end(), 0);
+  for (auto &k : keys)
+    k *= 2;
+  std::mt19937_64 rng(7);
+  std::shuffle(keys.begin(), keys.end(), rng);
+  std::vector<int64_t> probes = keys;
+  std::shuffle(probes.begin(), probes.end(), rng);
+
+  bench_tree<billing::bench::legacy::BPlusTree<int64_t, int64_t>>(
+      suite, "order 4 (v1)" + tag, keys, probes);
+  bench_tree<billing::core::BPlusTree<int64_t, int64_t>>(
+      suite, "order 64" + tag, keys, probes);
+  bench_tree<billing::core::BPlusTree<int64_t, int64_t, 128>>(
+      suite, "order 128" + tag, keys, probes);
+  // Startup index build: sort + bulk_load vs inserting in arrival order
+  std::vector<std::pair<int64_t, int64_t>> entries;
+  suite.measure("sort + bulk_load" + tag, n, [&] {
+    entries.reserve(n);
+    for (int64_t k : keys)
+      entries.emplace_back(k, k);
+    std::sort(entries.begin(), entries.end());
+    billing::core::BPlusTree<int64_t, int64_t> tree;
+    tree.bulk_load(entries.begin(), entries.end());
+    billing::bench::do_not_optimize(tree.size());
+  });
+
+  // Churn: delete 90% of the keys, then scan what is left. The v1 tree
+  // never merges, so scans still walk every (mostly empty) leaf.
+  auto churn = [&](auto &tree, const std::string &name) {
+    for (int64_t k : keys)
+      tree.insert(k, k);
+    suite.measure(name + " remove 90%" + tag, n - n / 10, [&] {
+      for (std::size_t i = n / 10; i < n; ++i)
+        tree.remove(probes[i]);
+    });
+    int64_t sum = 0;
+    suite.measure(name + " for_each after churn" + tag, n / 10, [&] {
+      tree.for_each([&](const int64_t &, const int64_t &v) { sum += v; });
+    });
+    billing::bench::do_not_optimize(sum);
+  };
+  {
+    billing::bench::legacy::BPlusTree<int64_t, int64_t> v1;
+    churn(v1, "order 4 (v1)");
+  }
+  billing::core::BPlusTree<int64_t, int64_t> current;
+  churn(current, "order 64");
+  auto st = current.stats();
+  suite.note("order 64 after churn: height " + std::to_string(st.height) +
+             ", leaves " + std::to_string(st.leaf_nodes) + ", occupancy " +
+             std::to_string(static_cast<int>(st.leaf_occupancy * 100)) + "%");
+#if defined(__AVX2__)
+  suite.note("in-node search: AVX2 compare + popcount");
+#else
+  suite.note("in-node search: branchless binary search");
+#endif
+}
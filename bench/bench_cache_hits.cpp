@@ -0,0 +1,94 @@
+// bench_cache_hits.cpp — Hit latency: cached values copied vs shared
+// Every lookup is a cache hit on a warm cache of 512 invoices. "copy" is a
+// cache of models::Invoice, as the repositories used to keep, so each hit
+// deep-copies the invoice and its line items; "shared" caches InvoicePtr,
+// so a hit is a refcount bump. The repository rows compare find_by_id
+// (still a private copy) with find_shared.
+#include "../src/core/lru_cache.hpp"
+#include "../src/repository/invoice_repository.hpp"
+#include "../src/repository/write_batch.hpp"
+#include "bench_harness.hpp"
+#include <filesystem>
+#include <random>
+
+namespace {
+
+constexpr int64_t CACHED = 512;
+
+billing::models::Invoice make_invoice(int64_t id, int line_items) {
+  billing::models::Invoice inv{};
+  inv.id = id;
+  inv.customer_id = id % 50;
+  inv.invoice_number = "INV-2024-" + std::to_string(100000 + id);
+  inv.currency = "USD";
+  inv.notes = "Net 30. Thank you for your business.";
+  for (int i = 0; i < line_items; ++i)
+    inv.line_items.push_back(
+        {"Metered usage, region eu-west-" + std::to_string(i), 3, 12.5});
+  return inv;
+}
+
+// Uniform ids over the cached set, drawn up front
+std::vector<int64_t> make_ids(std::size_t ops) {
+  std::mt19937_64 rng(7);
+  std::vector<int64_t> ids(ops);
+  for (auto &id : ids)
+    id = 1 + static_cast<int64_t>(rng() % CACHED);
+  return ids;
+}
+
+} // namespace
+
+void run_cache_hit_bench(billing::bench::BenchSuite &suite) {
+  using namespace billing;
+  std::size_t ops = suite.n(2000000);
+  auto ids = make_ids(ops);
+
+  for (int items : {1, 10, 50}) {
+    std::string tag = " [line_items=" + std::to_string(items) + "]";
+
+    core::LRUCache<int64_t, models::Invoice> by_value(CACHED);
+    core::LRUCache<int64_t, repository::InvoicePtr> by_ptr(CACHED);
+    for (int64_t id = 1; id <= CACHED; ++id) {
+      by_value.put(id, make_invoice(id, items));
+      by_ptr.put(id, std::make_shared<const models::Invoice>(
+                         make_invoice(id, items)));
+    }
+    suite.measure("LRUCache get, copy" + tag, ops, [&] {
+      double sum = 0;
+      for (int64_t id : ids)
+        sum += by_value.get(id)->line_items.size();
+      bench::do_not_optimize(sum);
+    });
+    suite.measure("LRUCache get, shared" + tag, ops, [&] {
+      double sum = 0;
+      for (int64_t id : ids)
+        sum += (*by_ptr.get(id))->line_items.size();
+      bench::do_not_optimize(sum);
+    });
+
+    auto dir = std::filesystem::temp_directory_path() / "billing_bench_hits";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    {
+      repository::InvoiceRepository repo(dir.string());
+      repository::WriteBatch batch;
+      for (int64_t id = 1; id <= CACHED; ++id)
+        batch.save(make_invoice(id, items));
+      batch.commit(repo);
+      suite.measure("find_by_id (copy)" + tag, ops, [&] {
+        double sum = 0;
+        for (int64_t id : ids)
+          sum += repo.find_by_id(id)->line_items.size();
+        bench::do_not_optimize(sum);
+      });
+      suite.measure("find_shared" + tag, ops, [&] {
+        double sum = 0;
+        for (int64_t id : ids)
+          sum += repo.find_shared(id)->line_items.size();
+        bench::do_not_optimize(sum);
+      });
+    }
+    std::filesystem::remove_all(dir);
+  }
+}
@@ -0,0 +1,88 @@
+// bench_cache_policies.cpp — Trace replay: LRU vs W-TinyLFU hit rates
+// The trace models the customer repository under a status screen: Zipf
+// distributed find_by_id traffic over 10k customers, interrupted by report
+// runs that read every customer once. Each access is get(), then put() on
+// a miss, exactly as the repositories do.
+#include "../src/core/lru_cache.hpp"
+#include "../src/core/tinylfu_cache.hpp"
+#include "bench_harness.hpp"
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+namespace {
+
+constexpr int64_t CUSTOMERS = 10000;
+constexpr double ZIPF_S = 0.9;
+constexpr std::size_t REPORT_EVERY = 100000; // point accesses per report
+
+struct Access {
+  int64_t id;
+  bool scan; // part of a report run
+};
+
+std::vector<Access> make_trace(std::size_t point_accesses) {
+  std::vector<double> cdf(CUSTOMERS);
+  double total = 0;
+  for (int64_t i = 0; i < CUSTOMERS; ++i)
+    cdf[i] = total += 1.0 / std::pow(static_cast<double>(i + 1), ZIPF_S);
+  std::mt19937_64 rng(2024);
+  std::uniform_real_distribution<double> uni(0, total);
+  // Popularity rank -> id, shuffled so hot ids are not adjacent
+  std::vector<int64_t> ids(CUSTOMERS);
+  for (int64_t i = 0; i < CUSTOMERS; ++i)
+    ids[i] = i + 1;
+  std::shuffle(ids.begin(), ids.end(), rng);
+
+  std::vector<Access> trace;
+  for (std::size_t i = 0; i < point_accesses; ++i) {
+    if (i > 0 && i % REPORT_EVERY == 0)
+      for (int64_t id = 1; id <= CUSTOMERS; ++id)
+        trace.push_back({id, true});
+    auto rank = std::lower_bound(cdf.begin(), cdf.end(), uni(rng)) -
+                cdf.begin();
+    trace.push_back({ids[std::min<int64_t>(rank, CUSTOMERS - 1)], false});
+  }
+  return trace;
+}
+
+template <typename Cache>
+void replay(billing::bench::BenchSuite &suite, const std::string &name,
+            std::size_t capacity, const std::vector<Access> &trace) {
+  Cache cache(capacity);
+  std::size_t point = 0, point_hits = 0;
+  suite.measure(name + " [capacity=" + std::to_string(capacity) + "]",
+                trace.size(), [&] {
+                  for (const Access &a : trace) {
+                    bool hit = cache.get(a.id).has_value();
+                    if (!hit)
+                      cache.put(a.id, a.id);
+                    if (!a.scan) {
+                      point++;
+                      point_hits += hit;
+                    }
+                  }
+                });
+  char line[160];
+  std::snprintf(line, sizeof(line),
+                "%s: overall hit rate %.1f%%, point lookups %.1f%%",
+                name.c_str(), cache.hit_rate() * 100,
+                100.0 * point_hits / point);
+  suite.note(line);
+}
+
+} // namespace
+
+void run_cache_policy_bench(billing::bench::BenchSuite &suite) {
+  using namespace billing;
+  auto trace = make_trace(suite.n(2000000));
+  suite.note("trace: " + std::to_string(trace.size()) + " accesses, zipf " +
+             std::to_string(ZIPF_S).substr(0, 3) + " over " +
+             std::to_string(CUSTOMERS) + " ids, full scan every " +
+             std::to_string(REPORT_EVERY));
+  for (std::size_t capacity : {256u, 512u, 2048u}) {
+    replay<core::LRUCache<int64_t, int64_t>>(suite, "LRU", capacity, trace);
+    replay<core::TinyLFUCache<int64_t, int64_t>>(suite, "W-TinyLFU",
+                                                 capacity, trace);
+  }
+}
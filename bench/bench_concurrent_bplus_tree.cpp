@@ -0,0 +1,90 @@
+// bench_concurrent_bplus_tree.cpp — Reader/writer scaling of the B+ tree
+// ConcurrentBPlusTree (optimistic lock coupling) against BPlusTree behind a
+// std::shared_mutex, at 1/2/4/8/16 threads. The total number of operations
+// is fixed, so ns/op falling with more threads means the tree scales.
+#include "../src/core/bplus_tree.hpp"
+#include "../src/core/concurrent_bplus_tree.hpp"
+#include "bench_harness.hpp"
+#include <mutex>
+#include <random>
+#include <shared_mutex>
+#include <thread>
+
+namespace {
+
+// BPlusTree made shareable the way repositories do it today: one lock
+class LockedTree {
+public:
+  bool insert(int64_t k, int64_t v) {
+    std::unique_lock lock(mutex_);
+    tree_.insert(k, v);
+    return true;
+  }
+  std::optional<int64_t> search(int64_t k) const {
+    std::shared_lock lock(mutex_);
+    return tree_.search(k);
+  }
+
+private:
+  billing::core::BPlusTree<int64_t, int64_t> tree_;
+  mutable std::shared_mutex mutex_;
+};
+
+// Every thread does ops/threads operations; `write_pct` of them insert
+// fresh odd keys (disjoint per thread), the rest look up preloaded keys
+template <typename Tree>
+void run_mix(Tree &tree, std::size_t ops, int threads, int write_pct,
+             int64_t preloaded, int64_t &next_odd) {
+  std::vector<std::thread> pool;
+  std::size_t per_thread = ops / threads;
+  for (int t = 0; t < threads; ++t)
+    pool.emplace_back([&, t] {
+      std::mt19937_64 rng(t + 1);
+      int64_t odd = next_odd + 2 * t;
+      int64_t sum = 0;
+      for (std::size_t i = 0; i < per_thread; ++i) {
+        if (static_cast<int>(rng() % 100) < write_pct) {
+          tree.insert(odd, odd);
+          odd += 2 * threads;
+        } else {
+          int64_t k = static_cast<int64_t>(rng() % preloaded) * 2;
+          sum += tree.search(k).value_or(0);
+        }
+      }
+      billing::bench::do_not_optimize(sum);
+    });
+  for (auto &th : pool)
+    th.join();
+  next_odd += static_cast<int64_t>(2 * ops + 2 * threads);
+}
+
+} // namespace
+
+void run_concurrent_bplus_tree_bench(billing::bench::BenchSuite &suite) {
+  using namespace billing;
+  int64_t preloaded = static_cast<int64_t>(suite.n(1000000));
+  std::size_t ops = suite.n(4000000);
+  suite.note("preloaded keys: " + std::to_string(preloaded) +
+             ", hardware threads: " +
+             std::to_string(std::thread::hardware_concurrency()));
+
+  for (int write_pct : {0, 10}) {
+    std::string mix = write_pct ? " 90/10 read/insert" : " read-only";
+    core::ConcurrentBPlusTree<int64_t, int64_t> olc;
+    LockedTree locked;
+    for (int64_t k = 0; k < preloaded; ++k) {
+      olc.insert(2 * k, 2 * k);
+      locked.insert(2 * k, 2 * k);
+    }
+    int64_t olc_odd = 1, locked_odd = 1;
+    for (int threads : {1, 2, 4, 8, 16}) {
+      std::string tag = mix + " [threads=" + std::to_string(threads) + "]";
+      suite.measure("olc" + tag, ops, [&] {
+        run_mix(olc, ops, threads, write_pct, preloaded, olc_odd);
+      });
+      suite.measure("shared_mutex" + tag, ops, [&] {
+        run_mix(locked, ops, threads, write_pct, preloaded, locked_odd);
+      });
+    }
+  }
+}
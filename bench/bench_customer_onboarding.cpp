@@ -0,0 +1,41 @@
+// bench_customer_onboarding.cpp — bulk customer import through the unique
+// email index (previously an O(n) scan per customer, O(n^2) overall)
+#include "../src/repository/customer_repository.hpp"
+#include "../src/service/customer_service.hpp"
+#include "bench_harness.hpp"
+#include <filesystem>
+
+void run_customer_onboarding_bench(billing::bench::BenchSuite &suite) {
+  using namespace billing;
+  for (std::size_t n : {suite.n(100000), suite.n(1000000)}) {
+    std::string tag = " [n=" + std::to_string(n) + "]";
+    auto dir = std::filesystem::temp_directory_path() /
+               ("billing_bench_cust_" + std::to_string(n));
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+
+    std::vector<service::CustomerCreateRequest> reqs;
+    reqs.reserve(n);
+    for (std::size_t i = 0; i < n; ++i)
+      reqs.push_back({"Customer " + std::to_string(i),
+                      "User" + std::to_string(i) + "@Example.com", "555-0100",
+                      "1 Main St", "US", "CA"});
+    reqs.push_back(reqs.front()); // duplicate: must be skipped
+
+    repository::CustomerRepository repo(dir.string());
+    service::CustomerService service(repo);
+    std::size_t created = 0;
+    suite.measure("create_many" + tag, n,
+                  [&] { created = service.create_many(reqs).size(); });
+    suite.note("created " + std::to_string(created) + " of " +
+               std::to_string(reqs.size()) + " requests");
+
+    std::size_t hits = 0;
+    suite.measure("find_by_email (hash index)" + tag, n, [&] {
+      for (std::size_t i = 0; i < n; ++i)
+        hits += repo.email_taken("user" + std::to_string(i) + "@example.com");
+    });
+    bench::do_not_optimize(hits);
+    std::filesystem::remove_all(dir);
+  }
+}
@@ -0,0 +1,73 @@
+#pragma once
+// =============================================================================
+// bench_harness.hpp — Lightweight Benchmark Framework
+// =============================================================================
+#include <chrono>
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace billing::bench {
+
+struct BenchResult {
+  std::string name;
+  std::size_t ops;
+  double millis;
+};
+
+class BenchSuite {
+public:
+  BenchSuite(const std::string &suite_name, std::size_t divisor)
+      : name_(suite_name), divisor_(divisor ? divisor : 1) {}
+
+  // Problem size: `full` for a normal run, scaled down under --quick
+  std::size_t n(std::size_t full) const {
+    std::size_t v = full / divisor_;
+    return v ? v : 1;
+  }
+
+  // Time fn() once; `ops` is how many operations it performed
+  template <typename Fn>
+  double measure(const std::string &label, std::size_t ops, Fn fn) {
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    auto end = std::chrono::steady_clock::now();
+    double ms = std::chrono::duration<double, std::milli>(end - start).count();
+    results_.push_back({label, ops, ms});
+    return ms;
+  }
+
+  // Free-form line in the report (parameters, derived ratios)
+  void note(const std::string &text) { results_.push_back({text, 0, -1.0}); }
+
+  void print_report() const {
+    std::cout << "\n=== " << name_ << " ===" << std::endl;
+    for (auto &r : results_) {
+      if (r.millis < 0) {
+        std::cout << "  # " << r.name << "\n";
+        continue;
+      }
+      std::cout << "  " << std::left << std::setw(52) << r.name << std::right
+                << std::fixed << std::setprecision(2) << std::setw(11)
+                << r.millis << " ms";
+      if (r.ops)
+        std::cout << std::setw(12) << std::setprecision(1)
+                  << r.millis * 1e6 / static_cast<double>(r.ops) << " ns/op";
+      std::cout << "\n";
+    }
+  }
+
+private:
+  std::string name_;
+  std::size_t divisor_;
+  std::vector<BenchResult> results_;
+};
+
+// Keep the optimizer from discarding a computed value
+template <typename T> inline void do_not_optimize(const T &value) {
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+} // namespace billing::bench
@@ -0,0 +1,93 @@
+// bench_indexed_heap.cpp — Indexed 4-ary heap vs the MinHeap binary heap
+// Both hold compact (due_date, invoice_id) entries with random due dates.
+// MinHeap takes its mutex per call and has no update or erase; its ordered
+// drain (drain_sorted) copies the heap first. The 2-ary IndexedHeap row
+// separates the effect of arity from the handle bookkeeping.
+#include "../src/core/indexed_heap.hpp"
+#include "../src/core/min_heap.hpp"
+#include "bench_harness.hpp"
+#include <random>
+#include <vector>
+
+namespace {
+
+struct Due {
+  std::time_t due_date;
+  int64_t invoice_id;
+};
+
+struct DueCompare {
+  bool operator()(const Due &a, const Due &b) const {
+    return a.due_date < b.due_date;
+  }
+};
+
+std::vector<Due> make_entries(std::size_t n, uint64_t seed) {
+  std::mt19937_64 rng(seed);
+  std::vector<Due> out(n);
+  for (std::size_t i = 0; i < n; ++i)
+    out[i] = {1700000000 + static_cast<std::time_t>(rng() % (365 * 86400)),
+              static_cast<int64_t>(i + 1)};
+  return out;
+}
+
+template <std::size_t Arity>
+void indexed_rows(billing::bench::BenchSuite &suite, const std::string &name,
+                  const std::vector<Due> &entries,
+                  const std::vector<Due> &rekeys) {
+  using namespace billing;
+  std::size_t n = entries.size();
+  std::string tag = " [n=" + std::to_string(n) + "]";
+  core::IndexedHeap<std::time_t, int64_t, Arity> heap;
+  heap.reserve(n);
+  std::vector<uint32_t> handles(n);
+  suite.measure(name + " push" + tag, n, [&] {
+    for (std::size_t i = 0; i < n; ++i)
+      handles[i] = heap.push(entries[i].due_date, entries[i].invoice_id);
+  });
+  suite.measure(name + " update_key" + tag, n, [&] {
+    for (std::size_t i = 0; i < n; ++i)
+      heap.update_key(handles[i], rekeys[i].due_date);
+  });
+  std::size_t erased = n / 3;
+  suite.measure(name + " erase 1/3" + tag, erased, [&] {
+    for (std::size_t i = 0; i < erased; ++i)
+      heap.erase(handles[i * 3]);
+  });
+  std::size_t left = heap.size();
+  int64_t sum = 0;
+  suite.measure(name + " drain" + tag, left, [&] {
+    heap.drain([&](auto &&e) { sum += e.value; });
+  });
+  bench::do_not_optimize(sum);
+}
+
+} // namespace
+
+void run_indexed_heap_bench(billing::bench::BenchSuite &suite) {
+  using namespace billing;
+  std::size_t n = suite.n(1000000);
+  std::string tag = " [n=" + std::to_string(n) + "]";
+  auto entries = make_entries(n, 1);
+  auto rekeys = make_entries(n, 2);
+
+  {
+    core::MinHeap<Due, DueCompare> heap;
+    suite.measure("MinHeap push" + tag, n, [&] {
+      for (auto &e : entries)
+        heap.push(e);
+    });
+    std::size_t copied = 0;
+    suite.measure("MinHeap drain_sorted (copies)" + tag, n,
+                  [&] { copied = heap.drain_sorted().size(); });
+    bench::do_not_optimize(copied);
+    int64_t sum = 0;
+    suite.measure("MinHeap pop all" + tag, n, [&] {
+      while (!heap.empty())
+        sum += heap.pop().invoice_id;
+    });
+    bench::do_not_optimize(sum);
+  }
+  indexed_rows<4>(suite, "IndexedHeap<4>", entries, rekeys);
+  indexed_rows<2>(suite, "IndexedHeap<2>", entries, rekeys);
+}
@@ -0,0 +1,92 @@
+// bench_invoice_indexes.cpp — InvoiceRepository secondary indexes
+// Query cost should stay flat as the table grows (O(log n + k)) while a
+// full scan grows linearly.
+#include "../src/repository/invoice_repository.hpp"
+#include "bench_harness.hpp"
+#include <filesystem>
+#include <random>
+
+namespace {
+
+constexpr int64_t INVOICES_PER_CUSTOMER = 10;
+constexpr std::size_t OVERDUE = 100;
+constexpr std::size_t QUERIES = 10000;
+
+// Write a snapshot of n invoices directly (bypasses the WAL)
+std::string build_dataset(std::size_t n) {
+  using namespace billing;
+  auto dir = std::filesystem::temp_directory_path() /
+             ("billing_bench_idx_" + std::to_string(n));
+  std::filesystem::remove_all(dir);
+  std::filesystem::create_directories(dir);
+  std::time_t now = std::time(nullptr);
+  repository::RecordStore<repository::InvoiceCodec> store;
+  for (std::size_t i = 1; i <= n; ++i) {
+    models::Invoice inv{};
+    inv.id = static_cast<int64_t>(i);
+    inv.customer_id = static_cast<int64_t>(i) / INVOICES_PER_CUSTOMER;
+    inv.invoice_number = "INV-" + std::to_string(i);
+    inv.status = i % 3 == 0 ? models::InvoiceStatus::PAID
+                            : models::InvoiceStatus::PENDING;
+    if (i % 3 != 0 && i % (n / OVERDUE) == 1)
+      inv.due_date = now - 86400; // a fixed handful are overdue
+    else
+      inv.due_date = now + 86400 * static_cast<std::time_t>(1 + i % 30);
+    inv.line_items.push_back({"Consulting Hours", 2, 75.0});
+    inv.total_amount = 150.0;
+    inv.currency = "USD";
+    store.put(inv);
+  }
+  store.checkpoint((dir / "invoices.bin").string());
+  return dir.string();
+}
+
+} // namespace
+
+void run_invoice_index_bench(billing::bench::BenchSuite &suite) {
+  using namespace billing;
+  for (std::size_t n : {suite.n(100000), suite.n(1000000)}) {
+    std::string tag = " [n=" + std::to_string(n) + "]";
+    auto dir = build_dataset(n);
+
+    std::unique_ptr<repository::InvoiceRepository> repo;
+    suite.measure("open + build indexes" + tag, n, [&] {
+      repo = std::make_unique<repository::InvoiceRepository>(dir);
+    });
+
+    std::mt19937_64 rng(42);
+    int64_t customers = static_cast<int64_t>(n) / INVOICES_PER_CUSTOMER;
+    std::size_t found = 0;
+    suite.measure("find_by_customer (indexed)" + tag, QUERIES, [&] {
+      for (std::size_t q = 0; q < QUERIES; ++q)
+        found += repo->find_by_customer(
+                         static_cast<int64_t>(rng() % customers))
+                     .size();
+    });
+    bench::do_not_optimize(found);
+
+    suite.measure("find_overdue (due-index range)" + tag, 100, [&] {
+      for (int q = 0; q < 100; ++q)
+        found += repo->find_overdue().size();
+    });
+    bench::do_not_optimize(found);
+
+    repository::RecordStore<repository::InvoiceCodec> raw;
+    raw.open(dir + "/invoices.bin");
+    suite.measure("find_by_customer (header scan baseline)" + tag, 10, [&] {
+      for (int q = 0; q < 10; ++q) {
+        int64_t c = static_cast<int64_t>(rng() % customers);
+        found += raw.select([&](const auto &r) { return r.customer_id == c; })
+                     .size();
+      }
+    });
+    bench::do_not_optimize(found);
+
+    bool ok = false;
+    suite.measure("verify_indexes" + tag, n,
+                  [&] { ok = repo->verify_indexes(); });
+    suite.note(std::string("indexes consistent: ") + (ok ? "yes" : "NO"));
+    repo.reset();
+    std::filesystem::remove_all(dir);
+  }
+}
@@ -0,0 +1,75 @@
+// bench_invoice_numbers.cpp — invoice number generation: the original
+// mutex + std::localtime + string concatenation per number vs
+// MonthlySequence. "reserve(1)" pays one CAS and one clock read per
+// number; "reserve(1024)" is what a batch_create chunk does, one CAS per
+// block and allocation-free format() into a stack buffer. The lease file
+// is written once per 1024 numbers in every case.
+#include "../src/core/monthly_sequence.hpp"
+#include "bench_harness.hpp"
+#include "legacy/invoice_number_v1.hpp"
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+template <typename Fn> void run_threads(int threads, Fn fn) {
+  std::vector<std::thread> pool;
+  for (int t = 0; t < threads; ++t)
+    pool.emplace_back(fn);
+  for (auto &th : pool)
+    th.join();
+}
+
+std::string fresh_file(const std::string &name) {
+  auto path = std::filesystem::temp_directory_path() / name;
+  std::filesystem::remove(path);
+  return path.string();
+}
+
+} // namespace
+
+void run_invoice_number_bench(billing::bench::BenchSuite &suite) {
+  using namespace billing;
+  std::size_t ops = suite.n(4000000);
+  for (int threads : {1, 4}) {
+    std::string tag = " [threads=" + std::to_string(threads) + "]";
+    std::size_t per_thread = ops / threads;
+
+    bench::legacy::InvoiceNumberer legacy;
+    suite.measure("mutex + localtime (v1)" + tag, ops, [&] {
+      run_threads(threads, [&] {
+        std::size_t len = 0;
+        for (std::size_t i = 0; i < per_thread; ++i)
+          len += legacy.next().size();
+        bench::do_not_optimize(len);
+      });
+    });
+
+    std::string path = fresh_file("billing_bench_invoice_numbers.seq");
+    core::MonthlySequence seq(path);
+    suite.measure("reserve(1) + str" + tag, ops, [&] {
+      run_threads(threads, [&] {
+        std::size_t len = 0;
+        for (std::size_t i = 0; i < per_thread; ++i)
+          len += seq.reserve(1).str(0, "INV-").size();
+        bench::do_not_optimize(len);
+      });
+    });
+
+    suite.measure("reserve(1024) + format" + tag, ops, [&] {
+      run_threads(threads, [&] {
+        char buf[64];
+        std::size_t len = 0;
+        for (std::size_t i = 0; i < per_thread; i += 1024) {
+          auto block = seq.reserve(1024);
+          for (std::size_t k = 0; k < block.size(); ++k)
+            len += block.format(k, "INV-", buf);
+        }
+        bench::do_not_optimize(len);
+      });
+    });
+    std::filesystem::remove(path);
+  }
+}
@@ -0,0 +1,75 @@
+// bench_memory_pool.cpp — MemoryPool alloc/free throughput under threads
+// Each thread runs the batch_create pattern: allocate a burst of records,
+// then free them. The original pool (one mutex per call) is compared with
+// the magazine pool and with plain new/delete. Total operations are fixed,
+// so ns/op falling with more threads means the allocator scales.
+#include "../src/core/memory_pool.hpp"
+#include "bench_harness.hpp"
+#include "legacy/memory_pool_v1.hpp"
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct Record {
+  int64_t id;
+  double amount;
+  char tag[48];
+};
+
+constexpr std::size_t BURST = 16;
+
+template <typename Alloc, typename Free>
+void run_bursts(std::size_t ops, int threads, Alloc alloc, Free release) {
+  std::vector<std::thread> pool;
+  std::size_t rounds = ops / (2 * BURST) / threads;
+  for (int t = 0; t < threads; ++t)
+    pool.emplace_back([&] {
+      Record *burst[BURST];
+      for (std::size_t r = 0; r < rounds; ++r) {
+        for (auto &p : burst) {
+          p = alloc();
+          p->id = static_cast<int64_t>(r);
+        }
+        for (auto *p : burst)
+          release(p);
+      }
+      billing::bench::do_not_optimize(burst[0]);
+    });
+  for (auto &th : pool)
+    th.join();
+}
+
+} // namespace
+
+void run_memory_pool_bench(billing::bench::BenchSuite &suite) {
+  using namespace billing;
+  std::size_t ops = suite.n(8000000);
+  suite.note("hardware threads: " +
+             std::to_string(std::thread::hardware_concurrency()));
+
+  bench::legacy::MemoryPool<Record> v1;
+  core::MemoryPool<Record> pool;
+  for (int threads : {1, 2, 4, 8}) {
+    std::string tag = " [threads=" + std::to_string(threads) + "]";
+    suite.measure("v1 mutex pool" + tag, ops, [&] {
+      run_bursts(
+          ops, threads, [&] { return v1.allocate(); },
+          [&](Record *p) { v1.deallocate(p); });
+    });
+    suite.measure("magazine pool" + tag, ops, [&] {
+      run_bursts(
+          ops, threads, [&] { return pool.allocate(); },
+          [&](Record *p) { pool.deallocate(p); });
+    });
+    suite.measure("new/delete" + tag, ops, [&] {
+      run_bursts(
+          ops, threads, [] { return new Record; },
+          [](Record *p) { delete p; });
+    });
+  }
+  auto s = pool.stats();
+  suite.note("magazine pool hit ratio: " + std::to_string(s.hit_ratio()) +
+             " over " + std::to_string(s.hits + s.misses) + " ops, " +
+             std::to_string(s.blocks) + " blocks");
+}
@@ -0,0 +1,87 @@
+// bench_overdue_sweep.cpp — cost of one overdue check over a book of open
+// invoices whose due dates are spread over 30 days. The original
+// flag_overdue copied every invoice with find_all() and called
+// is_overdue() (a clock read each) on all of them, so every run cost
+// O(n). sweep_overdue takes from the timing wheel only what fell due since
+// the previous sweep (about n / 43200 per minute here), reads headers
+// without decoding, and flips them in one log frame. ns/op is per sweep.
+#include "../src/repository/customer_repository.hpp"
+#include "../src/repository/invoice_repository.hpp"
+#include "../src/repository/write_batch.hpp"
+#include "../src/service/billing_engine.hpp"
+#include "bench_harness.hpp"
+#include <filesystem>
+#include <string>
+
+namespace {
+
+using namespace billing;
+
+constexpr std::time_t SPREAD = 30 * 86400;
+
+void seed(repository::InvoiceRepository &invoices, std::size_t n,
+          std::time_t now) {
+  repository::WriteBatch batch;
+  for (std::size_t i = 0; i < n; ++i) {
+    models::Invoice inv{};
+    inv.id = static_cast<int64_t>(i + 1);
+    inv.customer_id = 1 + static_cast<int64_t>(i % 1000);
+    inv.invoice_number = "INV-SEED-" + std::to_string(i);
+    inv.type = models::InvoiceType::ONE_TIME;
+    inv.status = models::InvoiceStatus::PENDING;
+    inv.line_items = {{"Plan", 1, 29.0}};
+    inv.subtotal = inv.total_amount = 29.0;
+    inv.currency = "USD";
+    inv.issue_date = now;
+    // Spread evenly, so each minute of the month has its share
+    inv.due_date = now + static_cast<std::time_t>((i * 7919) % SPREAD);
+    batch.save(inv);
+    if (batch.size() == 100000)
+      batch.commit(invoices);
+  }
+  batch.commit(invoices);
+}
+
+} // namespace
+
+void run_overdue_sweep_bench(billing::bench::BenchSuite &suite) {
+  std::size_t n = suite.n(2000000);
+  std::string tag = " [open=" + std::to_string(n) + "]";
+  auto dir = std::filesystem::temp_directory_path() / "billing_bench_sweep";
+  std::filesystem::remove_all(dir);
+  std::filesystem::create_directories(dir);
+  {
+    std::time_t now = std::time(nullptr);
+    repository::CustomerRepository customers(dir.string());
+    repository::InvoiceRepository invoices(dir.string());
+    seed(invoices, n, now);
+    service::DiscountEngine disc;
+    service::TaxEngine tax;
+    service::BillingEngine engine(invoices, customers, disc, tax);
+
+    std::size_t overdue = 0;
+    suite.measure("find_all + is_overdue scan (v1)" + tag, 1, [&] {
+      for (auto &inv : invoices.find_all())
+        overdue += inv.is_overdue();
+    });
+    bench::do_not_optimize(overdue);
+
+    // A day's worth of per-minute sweeps, then one that covers a week
+    constexpr int SWEEPS = 24 * 60;
+    std::size_t expired = 0, flagged = 0;
+    suite.measure("sweep_overdue every minute" + tag, SWEEPS, [&] {
+      for (int m = 1; m <= SWEEPS; ++m) {
+        auto s = engine.sweep_overdue(now + m * 60);
+        expired += s.expired;
+        flagged += s.flagged;
+      }
+    });
+    suite.note("over a day: " + std::to_string(expired) + " expired, " +
+               std::to_string(flagged) + " flagged");
+    service::OverdueSweep week;
+    suite.measure("sweep_overdue after a week" + tag, 1,
+                  [&] { week = engine.sweep_overdue(now + 8 * 86400); });
+    suite.note("flagged " + std::to_string(week.flagged));
+  }
+  std::filesystem::remove_all(dir);
+}
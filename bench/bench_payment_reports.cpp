@@ -0,0 +1,74 @@
+// bench_payment_reports.cpp — CLV and monthly revenue over the payment
+// indexes (previously one full payment scan per customer for CLV)
+#include "../src/service/report_service.hpp"
+#include "bench_harness.hpp"
+#include <filesystem>
+
+namespace {
+
+constexpr std::size_t PAYMENTS_PER_CUSTOMER = 20;
+
+// Customer and payment snapshots written directly (no per-record flush)
+std::string build_dataset(std::size_t payments) {
+  using namespace billing;
+  auto dir = std::filesystem::temp_directory_path() /
+             ("billing_bench_pay_" + std::to_string(payments));
+  std::filesystem::remove_all(dir);
+  std::filesystem::create_directories(dir);
+  std::size_t customers = payments / PAYMENTS_PER_CUSTOMER;
+  std::time_t now = std::time(nullptr);
+
+  repository::RecordStore<repository::CustomerCodec> cust;
+  for (std::size_t i = 1; i <= customers; ++i) {
+    models::Customer c{};
+    c.id = static_cast<int64_t>(i);
+    c.name = "Customer " + std::to_string(i);
+    c.email = "c" + std::to_string(i) + "@example.com";
+    c.created_at = now - 86400 * 365;
+    cust.put(c);
+  }
+  cust.checkpoint((dir / "customers.bin").string());
+
+  repository::RecordStore<repository::PaymentCodec> pay;
+  for (std::size_t i = 1; i <= payments; ++i) {
+    models::Payment p{};
+    p.id = static_cast<int64_t>(i);
+    p.invoice_id = static_cast<int64_t>(i);
+    p.customer_id = static_cast<int64_t>(1 + i % customers);
+    p.status = i % 10 ? models::PaymentStatus::COMPLETED
+                      : models::PaymentStatus::FAILED;
+    p.amount = 50.0 + static_cast<double>(i % 500);
+    p.completed_at = now - static_cast<std::time_t>((i * 7919) % (86400 * 730));
+    p.currency = "USD";
+    pay.put(p);
+  }
+  pay.checkpoint((dir / "payments.bin").string());
+  return dir.string();
+}
+
+} // namespace
+
+void run_payment_report_bench(billing::bench::BenchSuite &suite) {
+  using namespace billing;
+  for (std::size_t n : {suite.n(100000), suite.n(1000000)}) {
+    std::string tag = " [payments=" + std::to_string(n) + "]";
+    auto dir = build_dataset(n);
+    repository::CustomerRepository customers(dir);
+    repository::InvoiceRepository invoices(dir);
+    std::unique_ptr<repository::PaymentRepository> payments;
+    suite.measure("open + build payment indexes" + tag, n, [&] {
+      payments = std::make_unique<repository::PaymentRepository>(dir);
+    });
+    service::ReportService reports(invoices, customers, *payments, dir);
+
+    std::size_t rows = 0;
+    suite.measure("customer_clv_report" + tag, n,
+                  [&] { rows = reports.customer_clv_report().size(); });
+    suite.note("customers: " + std::to_string(rows));
+    suite.measure("monthly_revenue_history" + tag, n,
+                  [&] { rows = reports.monthly_revenue_history().size(); });
+    suite.note("months: " + std::to_string(rows));
+    payments.reset();
+    std::filesystem::remove_all(dir);
+  }
+}
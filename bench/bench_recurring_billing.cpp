@@ -0,0 +1,119 @@
+// bench_recurring_billing.cpp — one monthly billing cycle over a book of
+// recurring parents, a quarter of them due. The old way scans every invoice
+// with find_all(), then per due parent runs create_invoice and a separate
+// update to advance it (two log commits, not atomic). RecurringBillingRun
+// reads the due parents off the next_billing_date index and bills them
+// through the batch pipeline, advancing parents in the children's commits.
+#include "../src/core/calendar.hpp"
+#include "../src/repository/customer_repository.hpp"
+#include "../src/repository/invoice_repository.hpp"
+#include "../src/repository/write_batch.hpp"
+#include "../src/service/billing_engine.hpp"
+#include "../src/service/recurring_billing_run.hpp"
+#include "bench_harness.hpp"
+#include <filesystem>
+#include <vector>
+
+namespace {
+
+using namespace billing;
+
+constexpr int64_t CUSTOMERS = 1000;
+
+std::filesystem::path fresh_dir(const std::string &name) {
+  auto dir = std::filesystem::temp_directory_path() / name;
+  std::filesystem::remove_all(dir);
+  std::filesystem::create_directories(dir);
+  return dir;
+}
+
+// `n` monthly parents; every fourth is due on `billing_date`
+std::time_t seed(repository::CustomerRepository &customers,
+                 repository::InvoiceRepository &invoices, std::size_t n) {
+  repository::WriteBatch batch;
+  for (int64_t id = 1; id <= CUSTOMERS; ++id) {
+    models::Customer c{};
+    c.id = id;
+    c.name = "Customer " + std::to_string(id);
+    c.email = "c" + std::to_string(id) + "@example.com";
+    c.country = "US";
+    c.state = "WA";
+    c.created_at = std::time(nullptr);
+    batch.save(c);
+  }
+  batch.commit(customers);
+
+  std::time_t now = std::time(nullptr);
+  std::time_t billing_date = core::add_months(now, 1);
+  for (std::size_t i = 0; i < n; ++i) {
+    models::Invoice inv{};
+    inv.id = static_cast<int64_t>(i + 1);
+    inv.customer_id = 1 + static_cast<int64_t>(i % CUSTOMERS);
+    inv.invoice_number = "INV-SEED-" + std::to_string(i);
+    inv.type = models::InvoiceType::RECURRING;
+    inv.period = models::RecurringPeriod::MONTHLY;
+    inv.status = models::InvoiceStatus::PAID;
+    inv.line_items = {{"Plan", 1, 29.0}};
+    inv.subtotal = inv.total_amount = inv.amount_paid = 29.0;
+    inv.currency = "USD";
+    inv.issue_date = now;
+    inv.due_date = now;
+    inv.next_billing_date =
+        i % 4 == 0 ? billing_date : core::add_months(now, 2);
+    batch.save(inv);
+  }
+  batch.commit(invoices);
+  return billing_date;
+}
+
+} // namespace
+
+void run_recurring_billing_bench(billing::bench::BenchSuite &suite) {
+  std::size_t n = suite.n(200000);
+  service::DiscountEngine disc;
+  service::TaxEngine tax;
+  std::string tag = " [parents=" + std::to_string(n) + ", due=" +
+                    std::to_string((n + 3) / 4) + "]";
+
+  {
+    auto dir = fresh_dir("billing_bench_recurring_v1");
+    repository::CustomerRepository customers(dir.string());
+    repository::InvoiceRepository invoices(dir.string());
+    std::time_t date = seed(customers, invoices, n);
+    service::BillingEngine engine(invoices, customers, disc, tax);
+    suite.measure("find_all scan + create_invoice/update (v1)" + tag, n / 4,
+                  [&] {
+                    for (auto &p : invoices.find_all()) {
+                      if (p.type != models::InvoiceType::RECURRING ||
+                          p.next_billing_date > date)
+                        continue;
+                      service::InvoiceRequest req;
+                      req.customer_id = p.customer_id;
+                      req.type = models::InvoiceType::RECURRING;
+                      req.period = p.period;
+                      req.line_items = p.line_items;
+                      req.parent_invoice_id = p.id;
+                      engine.create_invoice(req);
+                      p.next_billing_date =
+                          core::add_months(p.next_billing_date, 1);
+                      invoices.update(p);
+                    }
+                  });
+  }
+  {
+    auto dir = fresh_dir("billing_bench_recurring_run");
+    repository::CustomerRepository customers(dir.string());
+    repository::InvoiceRepository invoices(dir.string());
+    std::time_t date = seed(customers, invoices, n);
+    service::BillingEngine engine(invoices, customers, disc, tax);
+    service::RecurringBillingRun run(engine, invoices);
+    service::RecurringRunStats stats;
+    suite.measure("RecurringBillingRun" + tag, n / 4,
+                  [&] { stats = run.run(date); });
+    suite.note("created " + std::to_string(stats.created) + " in " +
+               std::to_string(stats.passes) + " pass(es)");
+    std::filesystem::remove_all(dir);
+  }
+  std::filesystem::remove_all(
+      std::filesystem::temp_directory_path() / "billing_bench_recurring_v1");
+}
@@ -0,0 +1,70 @@
+// bench_runner.cpp — Main entry point for all benchmarks
+// Usage: billing_bench [--quick] [suite-filter]
+#include "bench_harness.hpp"
+#include <cstring>
+#include <iostream>
+
+// Forward declarations of benchmark suites
+void run_invoice_index_bench(billing::bench::BenchSuite &);
+void run_customer_onboarding_bench(billing::bench::BenchSuite &);
+void run_payment_report_bench(billing::bench::BenchSuite &);
+void run_bplus_tree_bench(billing::bench::BenchSuite &);
+void run_concurrent_bplus_tree_bench(billing::bench::BenchSuite &);
+void run_cache_sharding_bench(billing::bench::BenchSuite &);
+void run_cache_policy_bench(billing::bench::BenchSuite &);
+void run_cache_hit_bench(billing::bench::BenchSuite &);
+void run_memory_pool_bench(billing::bench::BenchSuite &);
+void run_allocation_bench(billing::bench::BenchSuite &);
+void run_scheduler_bench(billing::bench::BenchSuite &);
+void run_indexed_heap_bench(billing::bench::BenchSuite &);
+void run_snowflake_bench(billing::bench::BenchSuite &);
+void run_batch_billing_bench(billing::bench::BenchSuite &);
+void run_thread_pool_bench(billing::bench::BenchSuite &);
+void run_invoice_number_bench(billing::bench::BenchSuite &);
+void run_recurring_billing_bench(billing::bench::BenchSuite &);
+void run_overdue_sweep_bench(billing::bench::BenchSuite &);
+
+int main(int argc, char **argv) {
+  std::size_t divisor = 1;
+  std::string filter;
+  for (int i = 1; i < argc; ++i) {
+    if (std::strcmp(argv[i], "--quick") == 0)
+      divisor = 100;
+    else
+      filter = argv[i];
+  }
+
+  std::cout << "\n========================================\n";
+  std::cout << "  Billing System — Benchmarks"
+            << (divisor > 1 ? " (quick)" : "") << "\n";
+  std::cout << "========================================\n";
+
+  auto run_suite = [&](const std::string &name,
+                       void (*fn)(billing::bench::BenchSuite &)) {
+    if (!filter.empty() && name.find(filter) == std::string::npos)
+      return;
+    billing::bench::BenchSuite suite(name, divisor);
+    fn(suite);
+    suite.print_report();
+  };
+
+  run_suite("Invoice Indexes", run_invoice_index_bench);
+  run_suite("Customer Onboarding", run_customer_onboarding_bench);
+  run_suite("Payment Reports", run_payment_report_bench);
+  run_suite("B+ Tree", run_bplus_tree_bench);
+  run_suite("Concurrent B+ Tree", run_concurrent_bplus_tree_bench);
+  run_suite("Cache Sharding", run_cache_sharding_bench);
+  run_suite("Cache Policies", run_cache_policy_bench);
+  run_suite("Cache Hits", run_cache_hit_bench);
+  run_suite("Memory Pool", run_memory_pool_bench);
+  run_suite("Allocations", run_allocation_bench);
+  run_suite("Scheduler", run_scheduler_bench);
+  run_suite("Indexed Heap", run_indexed_heap_bench);
+  run_suite("Snowflake", run_snowflake_bench);
+  run_suite("Batch Billing", run_batch_billing_bench);
+  run_suite("Thread Pool", run_thread_pool_bench);
+  run_suite("Invoice Numbers", run_invoice_number_bench);
+  run_suite("Recurring Billing", run_recurring_billing_bench);
+  run_suite("Overdue Sweep", run_overdue_sweep_bench);
+  return 0;
+}
@@ -0,0 +1,95 @@
+// bench_scheduler.cpp — Due-date scheduling: MinHeap of invoices vs wheel
+// The old scheduler kept full Invoice copies in a MinHeap; the timing wheel
+// keeps ids only. Deadlines are spread over 90 days from a fixed start.
+// "drain" moves the clock a day at a time and expires everything due,
+// popping the heap one entry at a time; "cancel" removes a third of the
+// entries, which the heap cannot do at all.
+#include "../src/core/min_heap.hpp"
+#include "../src/core/timing_wheel.hpp"
+#include "../src/models/invoice.hpp"
+#include "bench_harness.hpp"
+#include <random>
+#include <vector>
+
+namespace {
+
+constexpr std::time_t START = 1700000000;
+constexpr std::time_t DAYS = 90;
+
+struct DueCompare {
+  bool operator()(const billing::models::Invoice &a,
+                  const billing::models::Invoice &b) const {
+    return a.due_date < b.due_date;
+  }
+};
+
+std::vector<billing::models::Invoice> make_invoices(std::size_t n) {
+  std::mt19937_64 rng(11);
+  std::vector<billing::models::Invoice> out(n);
+  for (std::size_t i = 0; i < n; ++i) {
+    auto &inv = out[i];
+    inv.id = static_cast<int64_t>(i + 1);
+    inv.invoice_number = "INV-202401" + std::to_string(1000 + i);
+    inv.currency = "USD";
+    inv.line_items.push_back({"Subscription, monthly plan", 1, 49.0});
+    inv.due_date = START + static_cast<std::time_t>(rng() % (DAYS * 86400));
+  }
+  return out;
+}
+
+} // namespace
+
+void run_scheduler_bench(billing::bench::BenchSuite &suite) {
+  using namespace billing;
+  std::size_t n = suite.n(1000000);
+  std::string tag = " [n=" + std::to_string(n) + "]";
+  auto invoices = make_invoices(n);
+
+  {
+    core::MinHeap<models::Invoice, DueCompare> heap;
+    suite.measure("MinHeap push (Invoice copies)" + tag, n, [&] {
+      for (auto &inv : invoices)
+        heap.push(inv);
+    });
+    std::size_t drained = 0;
+    suite.measure("MinHeap drain by day" + tag, n, [&] {
+      for (std::time_t day = 1; day <= DAYS; ++day)
+        while (!heap.empty() && heap.peek().due_date <= START + day * 86400) {
+          heap.pop();
+          drained++;
+        }
+    });
+    bench::do_not_optimize(drained);
+  }
+
+  {
+    core::TimingWheel<int64_t> wheel(START);
+    wheel.reserve(n);
+    suite.measure("TimingWheel schedule (ids)" + tag, n, [&] {
+      for (auto &inv : invoices)
+        wheel.schedule(inv.id, inv.due_date);
+    });
+    std::size_t drained = 0;
+    suite.measure("TimingWheel drain by day" + tag, n, [&] {
+      for (std::time_t day = 1; day <= DAYS; ++day)
+        wheel.advance(START + day * 86400,
+                      [&](int64_t, std::time_t) { drained++; });
+    });
+    bench::do_not_optimize(drained);
+
+    core::TimingWheel<int64_t> again(START);
+    for (auto &inv : invoices)
+      again.schedule(inv.id, inv.due_date);
+    std::size_t cancels = n / 3;
+    suite.measure("TimingWheel cancel" + tag, cancels, [&] {
+      for (std::size_t i = 0; i < cancels; ++i)
+        again.cancel(invoices[i * 3].id);
+    });
+    suite.measure("TimingWheel earliest" + tag, 1000, [&] {
+      int64_t sum = 0;
+      for (int i = 0; i < 1000; ++i)
+        sum += again.earliest()->id;
+      bench::do_not_optimize(sum);
+    });
+  }
+}
@@ -0,0 +1,80 @@
+// bench_snowflake.cpp — ID generation: mutex generator vs CAS vs blocks
+// The original generator takes a mutex per ID and spins once a
+// millisecond's 4096 sequence numbers are used up, which caps it at about
+// 4M IDs/s. The CAS generator borrows following milliseconds instead, up
+// to MAX_LEAD_MS ahead of the clock, then yields; it has the same sustained
+// ceiling but no lock. "reserve" hands IDs out of per-thread blocks with
+// one CAS per block, and next_n fills a buffer from one clock sample. Total
+// IDs are fixed, so ns/op falling with more threads means scaling.
+#include "../src/core/snowflake.hpp"
+#include "bench_harness.hpp"
+#include "legacy/snowflake_v1.hpp"
+#include <thread>
+#include <vector>
+
+namespace {
+
+template <typename Fn> void run_threads(int threads, Fn fn) {
+  std::vector<std::thread> pool;
+  for (int t = 0; t < threads; ++t)
+    pool.emplace_back(fn);
+  for (auto &th : pool)
+    th.join();
+}
+
+} // namespace
+
+void run_snowflake_bench(billing::bench::BenchSuite &suite) {
+  using namespace billing;
+  std::size_t ops = suite.n(20000000);
+  for (int threads : {1, 4}) {
+    std::string tag = " [threads=" + std::to_string(threads) + "]";
+    std::size_t per_thread = ops / threads;
+
+    bench::legacy::SnowflakeGenerator legacy(1);
+    suite.measure("mutex next (v1)" + tag, ops, [&] {
+      run_threads(threads, [&] {
+        int64_t sum = 0;
+        for (std::size_t i = 0; i < per_thread; ++i)
+          sum += legacy.next();
+        bench::do_not_optimize(sum);
+      });
+    });
+
+    core::SnowflakeGenerator gen(1);
+    suite.measure("CAS next" + tag, ops, [&] {
+      run_threads(threads, [&] {
+        int64_t sum = 0;
+        for (std::size_t i = 0; i < per_thread; ++i)
+          sum += gen.next();
+        bench::do_not_optimize(sum);
+      });
+    });
+    double ms = suite.measure("next_n(1024)" + tag, ops, [&] {
+      run_threads(threads, [&] {
+        std::vector<int64_t> buf(1024);
+        int64_t sum = 0;
+        for (std::size_t done = 0; done < per_thread; done += buf.size()) {
+          gen.next_n(buf.size(), buf.data());
+          sum += buf.back();
+        }
+        bench::do_not_optimize(sum);
+      });
+    });
+    suite.note("next_n: " + std::to_string(static_cast<long long>(
+                                 ops / ms / 1000.0)) +
+               "M IDs/s");
+    suite.measure("reserve(256) blocks" + tag, ops, [&] {
+      run_threads(threads, [&] {
+        int64_t sum = 0;
+        core::IdBlock block;
+        for (std::size_t i = 0; i < per_thread; ++i) {
+          if (block.empty())
+            block = gen.reserve(256);
+          sum += block.next();
+        }
+        bench::do_not_optimize(sum);
+      });
+    });
+  }
+}
@@ -0,0 +1,54 @@
+// bench_thread_pool.cpp — fan-out of small jobs: threads created and joined
+// per call (the old batch_create pattern) vs tasks on the shared
+// work-stealing pool. Each "call" splits `work` units over 4 parts.
+#include "../src/core/thread_pool.hpp"
+#include "bench_harness.hpp"
+#include <atomic>
+#include <future>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// A few hundred nanoseconds of arithmetic per unit
+long burn(std::size_t units) {
+  long acc = 0;
+  for (std::size_t i = 0; i < units * 64; ++i)
+    acc += static_cast<long>(i ^ (i >> 3));
+  return acc;
+}
+
+} // namespace
+
+void run_thread_pool_bench(billing::bench::BenchSuite &suite) {
+  using namespace billing;
+  constexpr int PARTS = 4;
+  core::ThreadPool pool(PARTS);
+  std::size_t calls = suite.n(20000);
+  for (std::size_t work : {4, 256}) {
+    std::string tag = " [units/call=" + std::to_string(work) + "]";
+    std::atomic<long> sink{0};
+    suite.measure("std::thread per call (v1)" + tag, calls, [&] {
+      for (std::size_t c = 0; c < calls; ++c) {
+        std::vector<std::thread> threads;
+        for (int p = 0; p < PARTS; ++p)
+          threads.emplace_back([&] { sink += burn(work / PARTS); });
+        for (auto &t : threads)
+          t.join();
+      }
+    });
+    suite.measure("pool submit + wait_all" + tag, calls, [&] {
+      std::vector<std::future<void>> parts;
+      for (std::size_t c = 0; c < calls; ++c) {
+        parts.clear();
+        for (int p = 0; p < PARTS; ++p)
+          parts.push_back(pool.submit([&] { sink += burn(work / PARTS); }));
+        pool.wait_all(parts);
+        for (auto &f : parts)
+          f.get();
+      }
+    });
+    bench::do_not_optimize(sink.load());
+  }
+  suite.note("pool steals: " + std::to_string(pool.steals()));
+}
@@ -0,0 +1,32 @@
+#pragma once
+// invoice_number_v1.hpp — frozen copy of the original invoice numbering in
+// BillingEngine (one mutex, std::localtime and strftime per number, string
+// concatenation for the padding, counter never reset or persisted), kept
+// only as the baseline for bench_invoice_numbers.cpp
+#include <atomic>
+#include <ctime>
+#include <mutex>
+#include <string>
+
+namespace billing::bench::legacy {
+
+class InvoiceNumberer {
+public:
+  std::string next() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::time_t now = std::time(nullptr);
+    std::tm *t = std::localtime(&now);
+    char buf[32];
+    std::strftime(buf, sizeof(buf), "INV-%Y%m", t);
+    std::string num = std::to_string(counter_.fetch_add(1));
+    while (num.size() < 4)
+      num = "0" + num;
+    return std::string(buf) + num;
+  }
+
+private:
+  std::atomic<int> counter_{1};
+  std::mutex mutex_;
+};
+
+} // namespace billing::bench::legacy
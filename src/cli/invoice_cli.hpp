@@ -6,6 +6,7 @@
 #include "../service/audit_service.hpp"
 #include "../service/billing_engine.hpp"
 #include "../service/customer_service.hpp"
+#include "../service/recurring_billing_run.hpp"
 #include "../service/rbac_service.hpp"
 #include "cli_helpers.hpp"
 #include <iomanip>
@@ -34,9 +35,10 @@ public:
                 << "  [8] List Overdue Invoices\n"
                 << "  [9] Scan & Flag All Overdue\n"
                 << " [10] Next Invoice Due (Scheduler)\n"
+                << " [11] Run Recurring Billing (today)\n"
                 << "  [0] Back\n";
       print_divider();
-      int choice = get_int_input("Select option: ", 0, 10);
+      int choice = get_int_input("Select option: ", 0, 11);
       switch (choice) {
       case 0:
         return;
@@ -70,6 +72,9 @@ public:
       case 10:
         next_due();
         break;
+      case 11:
+        run_recurring();
+        break;
       }
     }
   }
@@ -149,9 +154,9 @@ private:
     try {
       rbac_.enforce(user_, service::Permission::READ_INVOICE);
       int64_t id = get_id_input("Invoice ID: ");
-      auto opt = inv_repo_.find_by_id(id);
-      if (opt)
-        print_invoice(*opt);
+      auto inv = inv_repo_.find_shared(id);
+      if (inv)
+        print_invoice(*inv);
       else
         print_warning("Invoice not found.");
       press_enter();
@@ -233,13 +238,13 @@ private:
     try {
       rbac_.enforce(user_, service::Permission::WRITE_INVOICE);
       int64_t id = get_id_input("Parent Invoice ID: ");
-      auto opt = inv_repo_.find_by_id(id);
-      if (!opt) {
+      auto parent = inv_repo_.find_shared(id);
+      if (!parent) {
         print_warning("Invoice not found");
         press_enter();
         return;
       }
-      auto next = engine_.generate_next_recurring(*opt);
+      auto next = engine_.generate_next_recurring(*parent);
       if (next) {
         print_success("Next recurring invoice: " + next->invoice_number);
         print_invoice(*next);
@@ -284,6 +289,28 @@ private:
     press_enter();
   }
 
+  // Finishes an interrupted run first, if one was left behind
+  void run_recurring() {
+    try {
+      rbac_.enforce(user_, service::Permission::WRITE_INVOICE);
+      service::RecurringBillingRun run(engine_, inv_repo_);
+      auto stats = run.pending() ? *run.resume() : run.run(std::time(nullptr));
+      print_success(std::to_string(stats.created) +
+                    " recurring invoices billed in " +
+                    std::to_string(stats.passes) + " pass(es)" +
+                    (stats.resumed ? " (resumed)" : ""));
+      for (auto &f : stats.failures)
+        print_warning("Parent " + std::to_string(f.parent_id) + ": " +
+                      f.reason);
+      AUDIT(user_, models::AuditAction::CREATE, "Invoice", 0,
+            "Recurring billing run: " + std::to_string(stats.created));
+      press_enter();
+    } catch (const std::exception &e) {
+      print_error(e.what());
+      press_enter();
+    }
+  }
+
   service::BillingEngine &engine_;
   service::CustomerService &cust_svc_;
   repository::InvoiceRepository &inv_repo_;
@@ -192,9 +192,9 @@ private:
     try {
       rbac_.enforce(user_, service::Permission::READ_INVOICE);
       int64_t pid = get_id_input("Payment ID: ");
-      auto opt = pay_repo_.find_by_id(pid);
-      if (opt)
-        print_payment(*opt);
+      auto pay = pay_repo_.find_shared(pid);
+      if (pay)
+        print_payment(*pay);
       else
         print_warning("Payment not found.");
       press_enter();
@@ -2,6 +2,7 @@
 // =============================================================================
 // report_cli.hpp — Reporting & Analytics CLI Module
 // =============================================================================
+#include "../core/memory_resource.hpp"
 #include "../service/audit_service.hpp"
 #include "../service/rbac_service.hpp"
 #include "../service/report_service.hpp"
@@ -27,9 +28,10 @@ public:
                 << "  [5] Export Aging Report → CSV\n"
                 << "  [6] Export CLV Report → CSV\n"
                 << "  [7] Export Revenue → JSON\n"
+                << "  [8] Export All (in parallel)\n"
                 << "  [0] Back\n";
       print_divider();
-      int choice = get_int_input("Select option: ", 0, 7);
+      int choice = get_int_input("Select option: ", 0, 8);
       switch (choice) {
       case 0:
         return;
@@ -54,15 +56,25 @@ public:
       case 7:
         export_revenue_json();
         break;
+      case 8:
+        export_all();
+        break;
       }
     }
   }
 
 private:
+  // Report temporaries live in one arena that is rewound per report, so
+  // repeated reports stop allocating scratch space
+  std::pmr::memory_resource *scratch() {
+    scratch_.reset();
+    return &scratch_;
+  }
+
   void dashboard() {
     try {
       rbac_.enforce(user_, service::Permission::VIEW_REPORTS);
-      auto s = svc_.generate_summary();
+      auto s = svc_.generate_summary(scratch());
       print_header("System Dashboard");
       std::cout << Color::BOLD << "  Customers:       " << Color::RESET
                 << s.total_customers << "\n"
@@ -89,7 +101,7 @@ private:
   void aging_report() {
     try {
       rbac_.enforce(user_, service::Permission::VIEW_REPORTS);
-      auto report = svc_.aging_report();
+      auto report = svc_.aging_report(scratch());
       print_header("Aging Report — Outstanding Receivables");
 
       auto print_bucket = [](const service::AgingBucket &b) {
@@ -125,8 +137,8 @@ private:
     try {
       rbac_.enforce(user_, service::Permission::VIEW_REPORTS);
       int window = get_int_input("SMA window (months, 1-12): ", 1, 12);
-      auto history = svc_.monthly_revenue_history();
-      auto forecast = svc_.sma_forecast(window, 3);
+      auto history = svc_.monthly_revenue_history(scratch());
+      auto forecast = svc_.sma_forecast(window, 3, scratch());
       print_header("Revenue History & Forecast (SMA-" + std::to_string(window) +
                    ")");
       if (history.empty()) {
@@ -179,7 +191,7 @@ private:
   void export_aging_csv() {
     try {
       rbac_.enforce(user_, service::Permission::EXPORT_DATA);
-      auto report = svc_.aging_report();
+      auto report = svc_.aging_report(scratch());
       auto path = svc_.export_aging_csv(report);
       print_success("Aging report exported to: " + path);
       AUDIT(user_, models::AuditAction::EXPORT, "Report", 0,
@@ -209,9 +221,9 @@ private:
   void export_revenue_json() {
     try {
       rbac_.enforce(user_, service::Permission::EXPORT_DATA);
-      auto history = svc_.monthly_revenue_history();
+      auto history = svc_.monthly_revenue_history(scratch());
       int w = get_int_input("SMA window (months): ", 1, 12);
-      auto forecast = svc_.sma_forecast(w, 3);
+      auto forecast = svc_.sma_forecast(w, 3, scratch());
       auto path = svc_.export_revenue_json(history, forecast);
       print_success("Revenue report exported to: " + path);
       AUDIT(user_, models::AuditAction::EXPORT, "Report", 0,
@@ -223,9 +235,25 @@ private:
     }
   }
 
+  void export_all() {
+    try {
+      rbac_.enforce(user_, service::Permission::EXPORT_DATA);
+      int w = get_int_input("SMA window (months): ", 1, 12);
+      for (auto &path : svc_.export_all(w))
+        print_success("Exported: " + path);
+      AUDIT(user_, models::AuditAction::EXPORT, "Report", 0,
+            "Exported all reports");
+      press_enter();
+    } catch (const std::exception &e) {
+      print_error(e.what());
+      press_enter();
+    }
+  }
+
   service::ReportService &svc_;
   service::RBACService &rbac_;
   std::string user_;
+  core::MonotonicArena scratch_{64 * 1024};
 };
 
 } // namespace billing::cli
@@ -1,43 +1,120 @@
 #pragma once
 // =============================================================================
-// bplus_tree.hpp — B+ Tree (Order 4) Implementation
+// bplus_tree.hpp — B+ Tree Implementation (cache-conscious, order 64)
 // Used for: Customer & Invoice indexing with range query support
+// Leaves hold keys + values, internal nodes keys + child pointers; in-node
+// search is a branchless binary search for arithmetic keys (AVX2 compare
+// for int64 keys when compiled with -mavx2)
 // Complexity: Insert O(log n), Search O(log n), Range O(log n + k), Delete
-// O(log n)
+// O(log n) with borrow/merge rebalancing
 // =============================================================================
 #include <algorithm>
-#include <array>
+#include <cstdint>
 #include <functional>
-#include <iostream>
 #include <optional>
 #include <stdexcept>
+#include <type_traits>
 #include <vector>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
 
 namespace billing::core {
 
-template <typename Key, typename Value, int Order = 4> class BPlusTree {
+// -----------------------------------------------------------------------------
+// In-node search over a sorted key array
+// -----------------------------------------------------------------------------
+namespace bptree_detail {
+
+// First index i with !(keys[i] < key)
+template <typename Key>
+inline int lower_bound(const Key *keys, int n, const Key &key) {
+  if constexpr (std::is_arithmetic_v<Key>) {
+#if defined(__AVX2__)
+    if constexpr (std::is_integral_v<Key> && sizeof(Key) == 8) {
+      // Sorted keys: the number of keys < key is the lower bound
+      const __m256i needle = _mm256_set1_epi64x(static_cast<int64_t>(key));
+      int i = 0, count = 0;
+      for (; i + 4 <= n; i += 4) {
+        __m256i v =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i *>(keys + i));
+        __m256i lt = _mm256_cmpgt_epi64(needle, v);
+        count += __builtin_popcount(
+            _mm256_movemask_pd(_mm256_castsi256_pd(lt)));
+      }
+      for (; i < n; ++i)
+        count += keys[i] < key;
+      return count;
+    }
+#endif
+    if (n == 0)
+      return 0;
+    const Key *base = keys;
+    int len = n;
+    while (len > 1) {
+      int half = len >> 1;
+      base += (base[half] < key) ? half : 0; // compiles to cmov
+      len -= half;
+    }
+    return static_cast<int>(base - keys) + (*base < key);
+  } else {
+    return static_cast<int>(std::lower_bound(keys, keys + n, key) - keys);
+  }
+}
+
+// First index i with key < keys[i]
+template <typename Key>
+inline int upper_bound(const Key *keys, int n, const Key &key) {
+  if constexpr (std::is_arithmetic_v<Key>) {
+    if (n == 0)
+      return 0;
+    const Key *base = keys;
+    int len = n;
+    while (len > 1) {
+      int half = len >> 1;
+      base += (key < base[half]) ? 0 : half;
+      len -= half;
+    }
+    return static_cast<int>(base - keys) + !(key < *base);
+  } else {
+    return static_cast<int>(std::upper_bound(keys, keys + n, key) - keys);
+  }
+}
+
+} // namespace bptree_detail
+
+template <typename Key, typename Value, int Order = 64> class BPlusTree {
+  static_assert(Order >= 4, "B+ tree order must be at least 4");
+
 public:
   static constexpr int MAX_KEYS = Order - 1;       // max keys per node
   static constexpr int MIN_KEYS = (Order - 1) / 2; // min keys (except root)
 
   // -----------------------------------------------------------------------
-  // Node types
+  // Node types — leaves carry no child pointers, internals no values.
+  // Arrays have one spare slot so a node can overflow before it splits.
   // -----------------------------------------------------------------------
   struct Node {
     bool is_leaf;
-    int num_keys;
-    std::array<Key, Order> keys;            // Order keys (one spare for split)
-    std::array<Node *, Order + 1> children; // internal: child pointers
-    std::array<Value, Order> values;        // leaf: values
-    Node *next_leaf;                        // linked leaf list
-
-    Node(bool leaf) : is_leaf(leaf), num_keys(0), next_leaf(nullptr) {
-      children.fill(nullptr);
-    }
+    int num_keys = 0;
+    explicit Node(bool leaf) : is_leaf(leaf) {}
+  };
+
+  struct Leaf : Node {
+    Key keys[Order];
+    Value values[Order];
+    Leaf *next_leaf = nullptr; // linked leaf list
+    Leaf() : Node(true) {}
+  };
+
+  struct Internal : Node {
+    Key keys[Order];
+    Node *children[Order + 1] = {};
+    Internal() : Node(false) {}
   };
 
   // -----------------------------------------------------------------------
-  BPlusTree() : root_(nullptr), size_(0) { root_ = new Node(true); }
+  BPlusTree() : root_(new Leaf()), size_(0) {}
 
   ~BPlusTree() { destroy(root_); }
 
@@ -50,7 +127,7 @@ public:
     auto [new_child, promoted_key, did_split] =
         insert_recursive(root_, key, value);
     if (did_split) {
-      Node *new_root = new Node(false);
+      Internal *new_root = new Internal();
       new_root->keys[0] = promoted_key;
       new_root->children[0] = root_;
       new_root->children[1] = new_child;
@@ -60,104 +137,218 @@ public:
     size_++;
   }
 
-  // Search for exact key — O(log n)
-  std::optional<Value> search(const Key &key) const {
-    Node *node = root_;
-    while (!node->is_leaf) {
-      int i = upper_bound_idx(node, key);
-      node = node->children[i];
+  // Replace the contents with [first, last), a range of (key, value) pairs
+  // in strictly ascending key order, built bottom-up — O(n). Each node is
+  // packed to `fill` of its capacity; fill < 1 leaves room for later inserts
+  // before the first splits.
+  template <typename It> void bulk_load(It first, It last, double fill = 1.0) {
+    if (!(fill > 0.0 && fill <= 1.0))
+      throw std::invalid_argument("BPlusTree::bulk_load: fill not in (0, 1]");
+    std::size_t n = 0;
+    for (It it = first, before = first; it != last; before = it++, ++n)
+      if (n > 0 && !(before->first < it->first))
+        throw std::invalid_argument(
+            "BPlusTree::bulk_load: keys not strictly ascending");
+
+    // Leaves: spread n keys evenly so no leaf ends up nearly empty
+    std::vector<std::pair<Node *, Key>> level; // node + smallest key below
+    int per_leaf = std::clamp(static_cast<int>(MAX_KEYS * fill), 1, MAX_KEYS);
+    std::size_t leaves = (n + per_leaf - 1) / per_leaf;
+    level.reserve(leaves);
+    Leaf *prev = nullptr;
+    It it = first;
+    for (std::size_t l = 0; l < leaves; ++l) {
+      Leaf *leaf = new Leaf();
+      leaf->num_keys = static_cast<int>(n / leaves + (l < n % leaves));
+      for (int i = 0; i < leaf->num_keys; ++i, ++it) {
+        leaf->keys[i] = it->first;
+        leaf->values[i] = it->second;
+      }
+      if (prev)
+        prev->next_leaf = leaf;
+      prev = leaf;
+      level.emplace_back(leaf, leaf->keys[0]);
     }
-    for (int i = 0; i < node->num_keys; ++i) {
-      if (node->keys[i] == key)
-        return node->values[i];
+
+    // Internal levels: at least 3 children per node keeps every node >= 2
+    // children after the even split
+    int per_node = std::clamp(static_cast<int>(Order * fill), 3, Order);
+    while (level.size() > 1) {
+      std::size_t groups = (level.size() + per_node - 1) / per_node;
+      std::vector<std::pair<Node *, Key>> parents;
+      parents.reserve(groups);
+      std::size_t c = 0;
+      for (std::size_t g = 0; g < groups; ++g) {
+        int take = static_cast<int>(level.size() / groups +
+                                    (g < level.size() % groups));
+        Internal *in = new Internal();
+        for (int i = 0; i < take; ++i) {
+          in->children[i] = level[c + i].first;
+          if (i > 0)
+            in->keys[i - 1] = level[c + i].second;
+        }
+        in->num_keys = take - 1;
+        parents.emplace_back(in, level[c].second);
+        c += take;
+      }
+      level.swap(parents);
     }
+
+    destroy(root_);
+    root_ = level.empty() ? new Leaf() : level[0].first;
+    size_ = n;
+  }
+
+  // Search for exact key — O(log n)
+  std::optional<Value> search(const Key &key) const {
+    const Leaf *leaf = find_leaf(key);
+    int i = bptree_detail::lower_bound(leaf->keys, leaf->num_keys, key);
+    if (i < leaf->num_keys && leaf->keys[i] == key)
+      return leaf->values[i];
     return std::nullopt;
   }
 
   // Range query [lo, hi] — O(log n + k)
   std::vector<std::pair<Key, Value>> range(const Key &lo, const Key &hi) const {
     std::vector<std::pair<Key, Value>> result;
-    Node *node = root_;
-    while (!node->is_leaf) {
-      int i = lower_bound_idx(node, lo);
-      node = node->children[i];
-    }
-    while (node) {
-      for (int i = 0; i < node->num_keys; ++i) {
-        if (node->keys[i] > hi)
-          return result;
-        if (node->keys[i] >= lo)
-          result.emplace_back(node->keys[i], node->values[i]);
+    range_for_each(lo, hi, [&](const Key &k, const Value &v) {
+      result.emplace_back(k, v);
+    });
+    return result;
+  }
+
+  // Visit [lo, hi] in key order without materializing it — O(log n + k)
+  template <typename Fn>
+  void range_for_each(const Key &lo, const Key &hi, Fn fn) const {
+    const Leaf *leaf = find_leaf_lower(lo);
+    int i = bptree_detail::lower_bound(leaf->keys, leaf->num_keys, lo);
+    while (leaf) {
+      for (; i < leaf->num_keys; ++i) {
+        if (hi < leaf->keys[i])
+          return;
+        fn(leaf->keys[i], leaf->values[i]);
       }
-      node = node->next_leaf;
+      leaf = leaf->next_leaf;
+      i = 0;
     }
-    return result;
   }
 
   // Update value for existing key — O(log n)
   bool update(const Key &key, const Value &value) {
-    Node *node = root_;
-    while (!node->is_leaf) {
-      int i = upper_bound_idx(node, key);
-      node = node->children[i];
-    }
-    for (int i = 0; i < node->num_keys; ++i) {
-      if (node->keys[i] == key) {
-        node->values[i] = value;
-        return true;
-      }
+    Leaf *leaf = const_cast<Leaf *>(find_leaf(key));
+    int i = bptree_detail::lower_bound(leaf->keys, leaf->num_keys, key);
+    if (i < leaf->num_keys && leaf->keys[i] == key) {
+      leaf->values[i] = value;
+      return true;
     }
     return false;
   }
 
-  // Remove key — O(log n)
+  // Remove key — O(log n). Underfull nodes borrow from or merge with a
+  // sibling, so every node except the root keeps >= MIN_KEYS keys
   bool remove(const Key &key) {
-    bool removed = remove_recursive(root_, key);
-    if (removed) {
-      --size_;
-      // If root has no keys and has a child, shrink tree
-      if (!root_->is_leaf && root_->num_keys == 0) {
-        Node *old_root = root_;
-        root_ = root_->children[0];
-        old_root->children[0] = nullptr;
-        delete old_root;
-      }
+    if (!remove_recursive(root_, key))
+      return false;
+    --size_;
+    // An internal root left with a single child hands over to it
+    if (!root_->is_leaf && root_->num_keys == 0) {
+      Internal *old = static_cast<Internal *>(root_);
+      root_ = old->children[0];
+      delete old;
     }
-    return removed;
+    return true;
   }
 
   // Iterate all leaf entries in sorted order
   void for_each(std::function<void(const Key &, const Value &)> fn) const {
-    Node *node = root_;
+    const Node *node = root_;
     while (!node->is_leaf)
-      node = node->children[0];
-    while (node) {
-      for (int i = 0; i < node->num_keys; ++i)
-        fn(node->keys[i], node->values[i]);
-      node = node->next_leaf;
-    }
+      node = static_cast<const Internal *>(node)->children[0];
+    for (auto *leaf = static_cast<const Leaf *>(node); leaf;
+         leaf = leaf->next_leaf)
+      for (int i = 0; i < leaf->num_keys; ++i)
+        fn(leaf->keys[i], leaf->values[i]);
   }
 
   std::size_t size() const { return size_; }
   bool empty() const { return size_ == 0; }
 
+  // Shape and fill of the tree — O(nodes)
+  struct Stats {
+    std::size_t height = 0; // levels; 1 for a lone leaf
+    std::size_t leaf_nodes = 0;
+    std::size_t internal_nodes = 0;
+    int min_leaf_keys = 0;     // over non-root leaves (0 if none)
+    int min_internal_keys = 0; // over non-root internal nodes (0 if none)
+    double leaf_occupancy = 0;     // keys / (leaf_nodes * MAX_KEYS)
+    double internal_occupancy = 0; // keys / (internal_nodes * MAX_KEYS)
+    std::size_t bytes = 0;         // node memory
+  };
+
+  Stats stats() const {
+    Stats st;
+    std::size_t leaf_keys = 0, internal_keys = 0;
+    int min_leaf = MAX_KEYS + 1, min_internal = MAX_KEYS + 1;
+    std::vector<const Node *> level{root_};
+    while (!level.empty()) {
+      ++st.height;
+      std::vector<const Node *> below;
+      for (const Node *node : level) {
+        bool is_root = node == root_;
+        if (node->is_leaf) {
+          ++st.leaf_nodes;
+          leaf_keys += node->num_keys;
+          if (!is_root)
+            min_leaf = std::min(min_leaf, node->num_keys);
+          continue;
+        }
+        auto *in = static_cast<const Internal *>(node);
+        ++st.internal_nodes;
+        internal_keys += in->num_keys;
+        if (!is_root)
+          min_internal = std::min(min_internal, in->num_keys);
+        below.insert(below.end(), in->children,
+                     in->children + in->num_keys + 1);
+      }
+      level.swap(below);
+    }
+    st.min_leaf_keys = min_leaf > MAX_KEYS ? 0 : min_leaf;
+    st.min_internal_keys = min_internal > MAX_KEYS ? 0 : min_internal;
+    st.leaf_occupancy =
+        static_cast<double>(leaf_keys) / (st.leaf_nodes * MAX_KEYS);
+    if (st.internal_nodes)
+      st.internal_occupancy =
+          static_cast<double>(internal_keys) / (st.internal_nodes * MAX_KEYS);
+    st.bytes = st.leaf_nodes * sizeof(Leaf) +
+               st.internal_nodes * sizeof(Internal);
+    return st;
+  }
+
 private:
   // -----------------------------------------------------------------------
   // Internal helpers
   // -----------------------------------------------------------------------
 
-  int upper_bound_idx(const Node *n, const Key &key) const {
-    int i = 0;
-    while (i < n->num_keys && key >= n->keys[i])
-      ++i;
-    return i;
+  // Leaf that would hold `key` (equal keys route right of a separator)
+  const Leaf *find_leaf(const Key &key) const {
+    const Node *node = root_;
+    while (!node->is_leaf) {
+      auto *in = static_cast<const Internal *>(node);
+      node = in->children[bptree_detail::upper_bound(in->keys, in->num_keys,
+                                                     key)];
+    }
+    return static_cast<const Leaf *>(node);
   }
 
-  int lower_bound_idx(const Node *n, const Key &key) const {
-    int i = 0;
-    while (i < n->num_keys && key > n->keys[i])
-      ++i;
-    return i;
+  // Leftmost leaf that may hold keys >= key
+  const Leaf *find_leaf_lower(const Key &key) const {
+    const Node *node = root_;
+    while (!node->is_leaf) {
+      auto *in = static_cast<const Internal *>(node);
+      node = in->children[bptree_detail::lower_bound(in->keys, in->num_keys,
+                                                     key)];
+    }
+    return static_cast<const Leaf *>(node);
   }
 
   // Returns {new_sibling, promoted_key, did_split}
@@ -170,45 +361,46 @@ private:
   InsertResult insert_recursive(Node *node, const Key &key,
                                 const Value &value) {
     if (node->is_leaf) {
+      Leaf *leaf = static_cast<Leaf *>(node);
       // Insert into leaf in sorted order
-      int pos = lower_bound_idx(node, key);
-      // Shift right
-      for (int i = node->num_keys; i > pos; --i) {
-        node->keys[i] = node->keys[i - 1];
-        node->values[i] = node->values[i - 1];
+      int pos = bptree_detail::lower_bound(leaf->keys, leaf->num_keys, key);
+      for (int i = leaf->num_keys; i > pos; --i) {
+        leaf->keys[i] = leaf->keys[i - 1];
+        leaf->values[i] = leaf->values[i - 1];
       }
-      node->keys[pos] = key;
-      node->values[pos] = value;
-      node->num_keys++;
+      leaf->keys[pos] = key;
+      leaf->values[pos] = value;
+      leaf->num_keys++;
 
-      if (node->num_keys < Order)
+      if (leaf->num_keys < Order)
         return {nullptr, {}, false};
-      return split_leaf(node);
+      return split_leaf(leaf);
     }
 
     // Internal node: find child to recurse into
-    int i = upper_bound_idx(node, key);
+    Internal *in = static_cast<Internal *>(node);
+    int i = bptree_detail::upper_bound(in->keys, in->num_keys, key);
     auto [new_child, pkey, did_split] =
-        insert_recursive(node->children[i], key, value);
+        insert_recursive(in->children[i], key, value);
     if (!did_split)
       return {nullptr, {}, false};
 
     // Insert promoted key into this node
-    for (int j = node->num_keys; j > i; --j) {
-      node->keys[j] = node->keys[j - 1];
-      node->children[j + 1] = node->children[j];
+    for (int j = in->num_keys; j > i; --j) {
+      in->keys[j] = in->keys[j - 1];
+      in->children[j + 1] = in->children[j];
     }
-    node->keys[i] = pkey;
-    node->children[i + 1] = new_child;
-    node->num_keys++;
+    in->keys[i] = pkey;
+    in->children[i + 1] = new_child;
+    in->num_keys++;
 
-    if (node->num_keys < Order)
+    if (in->num_keys < Order)
       return {nullptr, {}, false};
-    return split_internal(node);
+    return split_internal(in);
   }
 
-  InsertResult split_leaf(Node *leaf) {
-    Node *sibling = new Node(true);
+  InsertResult split_leaf(Leaf *leaf) {
+    Leaf *sibling = new Leaf();
     int mid = Order / 2;
 
     sibling->num_keys = leaf->num_keys - mid;
@@ -223,11 +415,11 @@ private:
     return {sibling, sibling->keys[0], true};
   }
 
-  InsertResult split_internal(Node *node) {
+  InsertResult split_internal(Internal *node) {
     int mid = node->num_keys / 2;
     Key pkey = node->keys[mid];
 
-    Node *sibling = new Node(false);
+    Internal *sibling = new Internal();
     sibling->num_keys = node->num_keys - mid - 1;
     for (int i = 0; i < sibling->num_keys; ++i)
       sibling->keys[i] = node->keys[mid + 1 + i];
@@ -238,33 +430,144 @@ private:
     return {sibling, pkey, true};
   }
 
+  // Returns false if the key is absent; rebalances the child it descended
+  // into on the way back up
   bool remove_recursive(Node *node, const Key &key) {
     if (node->is_leaf) {
-      for (int i = 0; i < node->num_keys; ++i) {
-        if (node->keys[i] == key) {
-          for (int j = i; j < node->num_keys - 1; ++j) {
-            node->keys[j] = node->keys[j + 1];
-            node->values[j] = node->values[j + 1];
-          }
-          node->num_keys--;
-          return true;
-        }
+      Leaf *leaf = static_cast<Leaf *>(node);
+      int i = bptree_detail::lower_bound(leaf->keys, leaf->num_keys, key);
+      if (i >= leaf->num_keys || !(leaf->keys[i] == key))
+        return false;
+      for (int j = i; j < leaf->num_keys - 1; ++j) {
+        leaf->keys[j] = leaf->keys[j + 1];
+        leaf->values[j] = leaf->values[j + 1];
       }
+      leaf->num_keys--;
+      return true;
+    }
+
+    Internal *in = static_cast<Internal *>(node);
+    int i = bptree_detail::upper_bound(in->keys, in->num_keys, key);
+    if (!remove_recursive(in->children[i], key))
       return false;
+    if (in->children[i]->num_keys < MIN_KEYS)
+      rebalance(in, i);
+    return true;
+  }
+
+  // children[i] of parent is underfull: borrow one entry from a sibling
+  // that can spare it, otherwise merge with a sibling
+  void rebalance(Internal *parent, int i) {
+    if (i > 0 && parent->children[i - 1]->num_keys > MIN_KEYS)
+      borrow_from_left(parent, i);
+    else if (i < parent->num_keys &&
+             parent->children[i + 1]->num_keys > MIN_KEYS)
+      borrow_from_right(parent, i);
+    else if (i > 0)
+      merge(parent, i - 1);
+    else
+      merge(parent, i);
+  }
+
+  void borrow_from_left(Internal *parent, int i) {
+    Node *child = parent->children[i];
+    Node *sibling = parent->children[i - 1];
+    if (child->is_leaf) {
+      Leaf *dst = static_cast<Leaf *>(child);
+      Leaf *src = static_cast<Leaf *>(sibling);
+      for (int j = dst->num_keys; j > 0; --j) {
+        dst->keys[j] = dst->keys[j - 1];
+        dst->values[j] = dst->values[j - 1];
+      }
+      dst->keys[0] = src->keys[src->num_keys - 1];
+      dst->values[0] = src->values[src->num_keys - 1];
+      parent->keys[i - 1] = dst->keys[0];
+    } else {
+      Internal *dst = static_cast<Internal *>(child);
+      Internal *src = static_cast<Internal *>(sibling);
+      for (int j = dst->num_keys; j > 0; --j)
+        dst->keys[j] = dst->keys[j - 1];
+      for (int j = dst->num_keys + 1; j > 0; --j)
+        dst->children[j] = dst->children[j - 1];
+      dst->keys[0] = parent->keys[i - 1];
+      dst->children[0] = src->children[src->num_keys];
+      parent->keys[i - 1] = src->keys[src->num_keys - 1];
     }
-    int i = upper_bound_idx(node, key);
-    bool removed = remove_recursive(node->children[i], key);
-    return removed;
+    child->num_keys++;
+    sibling->num_keys--;
+  }
+
+  void borrow_from_right(Internal *parent, int i) {
+    Node *child = parent->children[i];
+    Node *sibling = parent->children[i + 1];
+    if (child->is_leaf) {
+      Leaf *dst = static_cast<Leaf *>(child);
+      Leaf *src = static_cast<Leaf *>(sibling);
+      dst->keys[dst->num_keys] = src->keys[0];
+      dst->values[dst->num_keys] = src->values[0];
+      for (int j = 0; j < src->num_keys - 1; ++j) {
+        src->keys[j] = src->keys[j + 1];
+        src->values[j] = src->values[j + 1];
+      }
+      parent->keys[i] = src->keys[0];
+    } else {
+      Internal *dst = static_cast<Internal *>(child);
+      Internal *src = static_cast<Internal *>(sibling);
+      dst->keys[dst->num_keys] = parent->keys[i];
+      dst->children[dst->num_keys + 1] = src->children[0];
+      parent->keys[i] = src->keys[0];
+      for (int j = 0; j < src->num_keys - 1; ++j)
+        src->keys[j] = src->keys[j + 1];
+      for (int j = 0; j < src->num_keys; ++j)
+        src->children[j] = src->children[j + 1];
+    }
+    child->num_keys++;
+    sibling->num_keys--;
+  }
+
+  // Fold children[j + 1] into children[j] and drop separator keys[j]
+  void merge(Internal *parent, int j) {
+    Node *left = parent->children[j];
+    Node *right = parent->children[j + 1];
+    if (left->is_leaf) {
+      Leaf *dst = static_cast<Leaf *>(left);
+      Leaf *src = static_cast<Leaf *>(right);
+      for (int k = 0; k < src->num_keys; ++k) {
+        dst->keys[dst->num_keys + k] = src->keys[k];
+        dst->values[dst->num_keys + k] = src->values[k];
+      }
+      dst->num_keys += src->num_keys;
+      dst->next_leaf = src->next_leaf;
+      delete src;
+    } else {
+      Internal *dst = static_cast<Internal *>(left);
+      Internal *src = static_cast<Internal *>(right);
+      dst->keys[dst->num_keys] = parent->keys[j];
+      for (int k = 0; k < src->num_keys; ++k)
+        dst->keys[dst->num_keys + 1 + k] = src->keys[k];
+      for (int k = 0; k <= src->num_keys; ++k)
+        dst->children[dst->num_keys + 1 + k] = src->children[k];
+      dst->num_keys += 1 + src->num_keys;
+      delete src;
+    }
+    for (int k = j; k < parent->num_keys - 1; ++k) {
+      parent->keys[k] = parent->keys[k + 1];
+      parent->children[k + 1] = parent->children[k + 2];
+    }
+    parent->num_keys--;
   }
 
   void destroy(Node *node) {
     if (!node)
       return;
-    if (!node->is_leaf) {
-      for (int i = 0; i <= node->num_keys; ++i)
-        destroy(node->children[i]);
+    if (node->is_leaf) {
+      delete static_cast<Leaf *>(node);
+      return;
     }
-    delete node;
+    Internal *in = static_cast<Internal *>(node);
+    for (int i = 0; i <= in->num_keys; ++i)
+      destroy(in->children[i]);
+    delete in;
   }
 
   Node *root_;
@@ -0,0 +1,58 @@
+#pragma once
+// =============================================================================
+// calendar.hpp — Local-Calendar Date Arithmetic
+// Used for: Recurring billing dates. A month is a calendar month, not 30
+// days, and a day is a local calendar day (23 or 25 hours across DST).
+// Complexity: O(1) — one localtime_r and one mktime per call
+// =============================================================================
+#include <algorithm>
+#include <ctime>
+
+namespace billing::core {
+
+inline bool is_leap_year(int year) {
+  return (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+}
+
+// month is 1-12
+inline int days_in_month(int year, int month) {
+  static constexpr int days[] = {31, 28, 31, 30, 31, 30,
+                                 31, 31, 30, 31, 30, 31};
+  return month == 2 && is_leap_year(year) ? 29 : days[month - 1];
+}
+
+// Same local wall-clock time, `days` calendar days later (or earlier)
+inline std::time_t add_days(std::time_t t, int days) {
+  std::tm tm{};
+  localtime_r(&t, &tm);
+  tm.tm_mday += days;
+  tm.tm_isdst = -1;
+  return std::mktime(&tm);
+}
+
+// Same local wall-clock time, `months` calendar months later (or earlier),
+// on day `anchor_day` of that month, or its last day if the month is
+// shorter. anchor_day 0 means t's own day. Keeping the anchor across a
+// series stops drift: the 31st goes Jan 31 -> Feb 28 -> Mar 31, not Mar 28.
+inline std::time_t add_months(std::time_t t, int months, int anchor_day = 0) {
+  std::tm tm{};
+  localtime_r(&t, &tm);
+  int day = anchor_day > 0 ? anchor_day : tm.tm_mday;
+  int index = tm.tm_year * 12 + tm.tm_mon + months; // months since 1900
+  int year = index / 12 - (index % 12 < 0);
+  int month = ((index % 12) + 12) % 12;
+  tm.tm_year = year;
+  tm.tm_mon = month;
+  tm.tm_mday = std::min(day, days_in_month(year + 1900, month + 1));
+  tm.tm_isdst = -1;
+  return std::mktime(&tm);
+}
+
+// Local day of month (1-31) of t
+inline int day_of_month(std::time_t t) {
+  std::tm tm{};
+  localtime_r(&t, &tm);
+  return tm.tm_mday;
+}
+
+} // namespace billing::core
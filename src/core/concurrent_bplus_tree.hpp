@@ -0,0 +1,392 @@
+#pragma once
+// =============================================================================
+// concurrent_bplus_tree.hpp — B+ Tree with Optimistic Lock Coupling
+// Used for: Indexes read by many threads while writers insert
+// Every node carries a version latch. Readers take no locks: they note a
+// node's version, read it, and re-check the version before trusting what
+// they read, restarting from the root if a writer got in between. Writers
+// lock only the leaf they change (plus its parent when splitting); full
+// nodes are split on the way down so a split never propagates upwards.
+// Nodes are freed only by the destructor (remove does not merge), so an
+// optimistic reader never touches released memory.
+// Complexity: Insert O(log n), Search O(log n), Range O(log n + k)
+// =============================================================================
+#include "bplus_tree.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace billing::core {
+
+// -----------------------------------------------------------------------------
+// Version latch — odd version = write-locked; every unlock bumps the version
+// -----------------------------------------------------------------------------
+class VersionLatch {
+public:
+  // Wait until no writer holds the latch; returns the version to validate
+  uint64_t read_begin() const {
+    uint64_t v = version_.load(std::memory_order_acquire);
+    for (int spins = 0; v & 1; v = version_.load(std::memory_order_acquire))
+      if (++spins > 64)
+        std::this_thread::yield();
+    return v;
+  }
+
+  // True if no writer touched the node since read_begin() returned v
+  bool validate(uint64_t v) const {
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return version_.load(std::memory_order_relaxed) == v;
+  }
+
+  // Take the write lock only if the node is still at version v
+  bool try_upgrade(uint64_t v) {
+    return version_.compare_exchange_strong(v, v + 1,
+                                            std::memory_order_acquire);
+  }
+
+  void write_unlock() { version_.fetch_add(1, std::memory_order_release); }
+
+private:
+  std::atomic<uint64_t> version_{0};
+};
+
+template <typename Key, typename Value, int Order = 64>
+class ConcurrentBPlusTree {
+  static_assert(Order >= 8, "concurrent B+ tree order must be at least 8");
+  // Readers may copy a key or value while a writer is changing it; the copy
+  // is discarded when validation fails, which is only sound for plain data
+  static_assert(std::is_trivially_copyable_v<Key> &&
+                    std::is_trivially_copyable_v<Value>,
+                "ConcurrentBPlusTree needs trivially copyable keys/values");
+
+public:
+  static constexpr int MAX_KEYS = Order - 1; // max keys per node
+
+  ConcurrentBPlusTree() : root_(new Leaf()) {}
+  ~ConcurrentBPlusTree() { destroy(root_.load()); }
+
+  // Non-copyable
+  ConcurrentBPlusTree(const ConcurrentBPlusTree &) = delete;
+  ConcurrentBPlusTree &operator=(const ConcurrentBPlusTree &) = delete;
+
+  // Insert if absent — O(log n). Returns false (value untouched) if the key
+  // is already present.
+  bool insert(const Key &key, const Value &value) {
+    for (int attempt = 0;; ++attempt) {
+      if (auto inserted = try_insert(key, value)) {
+        if (*inserted)
+          size_.fetch_add(1, std::memory_order_relaxed);
+        return *inserted;
+      }
+      backoff(attempt);
+    }
+  }
+
+  // Search for exact key — O(log n), lock-free for readers
+  std::optional<Value> search(const Key &key) const {
+    for (int attempt = 0;; ++attempt) {
+      uint64_t v;
+      if (const Leaf *leaf = descend(key, v)) {
+        std::optional<Value> result;
+        int n = count_of(leaf);
+        int i = bptree_detail::lower_bound(leaf->keys, n, key);
+        if (i < n && leaf->keys[i] == key)
+          result = leaf->values[i];
+        if (leaf->latch.validate(v))
+          return result;
+      }
+      backoff(attempt);
+    }
+  }
+
+  // Range query [lo, hi] — O(log n + k). Each leaf is read consistently;
+  // the scan as a whole is not a snapshot (writes to leaves not yet reached
+  // are visible).
+  std::vector<std::pair<Key, Value>> range(const Key &lo,
+                                           const Key &hi) const {
+    std::vector<std::pair<Key, Value>> out;
+    std::pair<Key, Value> buf[MAX_KEYS];
+    Key from = lo;
+    bool past_from = false; // after a restart, resume after the last key out
+    for (int attempt = 0;; ++attempt) {
+      uint64_t v;
+      const Leaf *leaf = descend(from, v);
+      while (leaf) {
+        int n = count_of(leaf);
+        int got = 0;
+        bool done = false;
+        for (int i = bptree_detail::lower_bound(leaf->keys, n, from); i < n;
+             ++i) {
+          Key k = leaf->keys[i];
+          if (hi < k) {
+            done = true;
+            break;
+          }
+          if (!past_from || from < k)
+            buf[got++] = {k, leaf->values[i]};
+        }
+        const Leaf *next = leaf->next_leaf;
+        if (!leaf->latch.validate(v))
+          break;
+        out.insert(out.end(), buf, buf + got);
+        if (got) {
+          from = buf[got - 1].first;
+          past_from = true;
+        }
+        if (done || !next)
+          return out;
+        uint64_t next_v = next->latch.read_begin();
+        if (!leaf->latch.validate(v))
+          break; // leaf split while we stepped: next may be stale
+        leaf = next;
+        v = next_v;
+      }
+      backoff(attempt);
+    }
+  }
+
+  // Update value for existing key — O(log n)
+  bool update(const Key &key, const Value &value) {
+    return modify_leaf(key, [&](Leaf *leaf, int i) {
+      leaf->values[i] = value;
+      return true;
+    });
+  }
+
+  // Remove key — O(log n). Leaves are not merged (see header).
+  bool remove(const Key &key) {
+    bool removed = modify_leaf(key, [](Leaf *leaf, int i) {
+      for (int j = i; j < leaf->num_keys - 1; ++j) {
+        leaf->keys[j] = leaf->keys[j + 1];
+        leaf->values[j] = leaf->values[j + 1];
+      }
+      leaf->num_keys--;
+      return true;
+    });
+    if (removed)
+      size_.fetch_sub(1, std::memory_order_relaxed);
+    return removed;
+  }
+
+  std::size_t size() const { return size_.load(std::memory_order_relaxed); }
+  bool empty() const { return size() == 0; }
+
+private:
+  // -----------------------------------------------------------------------
+  // Node types — every key under children[i] of an internal node is
+  // <= keys[i]; nodes are split before they overflow, so no spare slot
+  // -----------------------------------------------------------------------
+  struct Node {
+    mutable VersionLatch latch;
+    bool is_leaf;
+    int num_keys = 0;
+    explicit Node(bool leaf) : is_leaf(leaf) {}
+  };
+
+  struct Leaf : Node {
+    Key keys[MAX_KEYS];
+    Value values[MAX_KEYS];
+    Leaf *next_leaf = nullptr;
+    Leaf() : Node(true) {}
+  };
+
+  struct Internal : Node {
+    Key keys[MAX_KEYS];
+    Node *children[Order] = {};
+    Internal() : Node(false) {}
+  };
+
+  // An optimistic read of num_keys may be stale; never index past the array
+  static int count_of(const Node *node) {
+    int n = node->num_keys;
+    return n < 0 ? 0 : std::min(n, MAX_KEYS);
+  }
+
+  static int child_index(const Internal *in, const Key &key) {
+    return bptree_detail::lower_bound(in->keys, count_of(in), key);
+  }
+
+  static void backoff(int attempt) {
+    if (attempt > 4)
+      std::this_thread::yield();
+  }
+
+  // Lock-coupled descent: validate the parent after reading the child
+  // pointer and again after reading the child's version. Returns the leaf
+  // and its version in v, or nullptr if the caller must restart.
+  const Leaf *descend(const Key &key, uint64_t &v) const {
+    const Node *node = root_.load(std::memory_order_acquire);
+    v = node->latch.read_begin();
+    while (!node->is_leaf) {
+      auto *in = static_cast<const Internal *>(node);
+      const Node *child = in->children[child_index(in, key)];
+      if (!in->latch.validate(v))
+        return nullptr;
+      uint64_t child_v = child->latch.read_begin();
+      if (!in->latch.validate(v))
+        return nullptr;
+      node = child;
+      v = child_v;
+    }
+    return static_cast<const Leaf *>(node);
+  }
+
+  // Run fn(leaf, index) on the entry for key under the leaf's write lock.
+  // Leaves are never merged, so a leaf whose version is unchanged since the
+  // descent still covers the key.
+  template <typename Fn> bool modify_leaf(const Key &key, Fn fn) {
+    for (int attempt = 0;; ++attempt) {
+      uint64_t v;
+      Leaf *leaf = const_cast<Leaf *>(descend(key, v));
+      if (leaf && leaf->latch.try_upgrade(v)) {
+        int i = bptree_detail::lower_bound(leaf->keys, leaf->num_keys, key);
+        bool hit = i < leaf->num_keys && leaf->keys[i] == key && fn(leaf, i);
+        leaf->latch.write_unlock();
+        return hit;
+      }
+      backoff(attempt);
+    }
+  }
+
+  // One descent; std::nullopt means restart. Full nodes met on the way are
+  // split (holding the node and its parent) and the descent restarts.
+  std::optional<bool> try_insert(const Key &key, const Value &value) {
+    Node *node = root_.load(std::memory_order_acquire);
+    uint64_t v = node->latch.read_begin();
+    if (node != root_.load(std::memory_order_acquire))
+      return std::nullopt;
+    Internal *parent = nullptr;
+    uint64_t parent_v = 0;
+    while (true) {
+      if (count_of(node) == MAX_KEYS) {
+        if (!lock_for_split(parent, parent_v, node, v))
+          return std::nullopt;
+        split(parent, node);
+        node->latch.write_unlock();
+        if (parent)
+          parent->latch.write_unlock();
+        return std::nullopt;
+      }
+      if (node->is_leaf)
+        break;
+      Internal *in = static_cast<Internal *>(node);
+      Node *child = in->children[child_index(in, key)];
+      if (!in->latch.validate(v))
+        return std::nullopt;
+      uint64_t child_v = child->latch.read_begin();
+      if (!in->latch.validate(v))
+        return std::nullopt;
+      parent = in;
+      parent_v = v;
+      node = child;
+      v = child_v;
+    }
+
+    Leaf *leaf = static_cast<Leaf *>(node);
+    if (!leaf->latch.try_upgrade(v))
+      return std::nullopt;
+    int pos = bptree_detail::lower_bound(leaf->keys, leaf->num_keys, key);
+    bool fresh = pos == leaf->num_keys || !(leaf->keys[pos] == key);
+    if (fresh) {
+      for (int i = leaf->num_keys; i > pos; --i) {
+        leaf->keys[i] = leaf->keys[i - 1];
+        leaf->values[i] = leaf->values[i - 1];
+      }
+      leaf->keys[pos] = key;
+      leaf->values[pos] = value;
+      leaf->num_keys++;
+    }
+    leaf->latch.write_unlock();
+    return fresh;
+  }
+
+  // Write-lock parent (if any) and node at the versions seen on the way
+  // down; a node without a parent must still be the root
+  bool lock_for_split(Internal *parent, uint64_t parent_v, Node *node,
+                      uint64_t v) {
+    if (parent && !parent->latch.try_upgrade(parent_v))
+      return false;
+    if (!node->latch.try_upgrade(v)) {
+      if (parent)
+        parent->latch.write_unlock();
+      return false;
+    }
+    if (!parent && node != root_.load(std::memory_order_acquire)) {
+      node->latch.write_unlock();
+      return false;
+    }
+    return true;
+  }
+
+  // Split a full node into itself + a new right sibling and link the
+  // sibling into the (non-full) parent, or grow a new root
+  void split(Internal *parent, Node *node) {
+    Key sep;
+    Node *right;
+    if (node->is_leaf) {
+      Leaf *leaf = static_cast<Leaf *>(node);
+      Leaf *sibling = new Leaf();
+      int keep = leaf->num_keys / 2;
+      sibling->num_keys = leaf->num_keys - keep;
+      std::copy(leaf->keys + keep, leaf->keys + leaf->num_keys, sibling->keys);
+      std::copy(leaf->values + keep, leaf->values + leaf->num_keys,
+                sibling->values);
+      sibling->next_leaf = leaf->next_leaf;
+      leaf->next_leaf = sibling;
+      leaf->num_keys = keep;
+      sep = leaf->keys[keep - 1];
+      right = sibling;
+    } else {
+      Internal *in = static_cast<Internal *>(node);
+      Internal *sibling = new Internal();
+      int n = in->num_keys;
+      sibling->num_keys = n - n / 2;
+      int keep = n - sibling->num_keys - 1;
+      sep = in->keys[keep];
+      std::copy(in->keys + keep + 1, in->keys + n, sibling->keys);
+      std::copy(in->children + keep + 1, in->children + n + 1,
+                sibling->children);
+      in->num_keys = keep;
+      right = sibling;
+    }
+
+    if (!parent) {
+      Internal *root = new Internal();
+      root->keys[0] = sep;
+      root->children[0] = node;
+      root->children[1] = right;
+      root->num_keys = 1;
+      root_.store(root, std::memory_order_release);
+      return;
+    }
+    int pos = bptree_detail::lower_bound(parent->keys, parent->num_keys, sep);
+    for (int i = parent->num_keys; i > pos; --i) {
+      parent->keys[i] = parent->keys[i - 1];
+      parent->children[i + 1] = parent->children[i];
+    }
+    parent->keys[pos] = sep;
+    parent->children[pos + 1] = right;
+    parent->num_keys++;
+  }
+
+  void destroy(Node *node) {
+    if (node->is_leaf) {
+      delete static_cast<Leaf *>(node);
+      return;
+    }
+    Internal *in = static_cast<Internal *>(node);
+    for (int i = 0; i <= in->num_keys; ++i)
+      destroy(in->children[i]);
+    delete in;
+  }
+
+  std::atomic<Node *> root_;
+  std::atomic<std::size_t> size_{0};
+};
+
+} // namespace billing::core
@@ -0,0 +1,37 @@
+#pragma once
+// =============================================================================
+// deep_size.hpp — Heap Footprint Estimates
+// Used for: Byte-budgeted caches (charging entries by what they own)
+// heap_bytes(x) is what x owns outside its own sizeof; repositories add up
+// their model's string/vector members with these.
+// Complexity: O(1) per string, O(1) per vector (element storage only)
+// =============================================================================
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace billing::core {
+
+// Short strings live inside the object (SSO); longer ones own capacity + 1
+inline std::size_t heap_bytes(const std::string &s) {
+  static const std::size_t sso_capacity = std::string().capacity();
+  return s.capacity() > sso_capacity ? s.capacity() + 1 : 0;
+}
+
+// Element storage only — callers add whatever the elements own
+template <typename T> std::size_t heap_bytes(const std::vector<T> &v) {
+  return v.capacity() * sizeof(T);
+}
+
+// make_shared block: the object plus two reference counts. Callers add what
+// the object itself owns.
+template <typename T> std::size_t heap_bytes(const std::shared_ptr<T> &p) {
+  return p ? sizeof(T) + 2 * sizeof(long) : 0;
+}
+
+template <typename... Ts> std::size_t heap_bytes_of(const Ts &...members) {
+  return (heap_bytes(members) + ... + 0);
+}
+
+} // namespace billing::core
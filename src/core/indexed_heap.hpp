@@ -0,0 +1,182 @@
+#pragma once
+// =============================================================================
+// indexed_heap.hpp — Indexed d-ary Min-Heap with Stable Handles
+// Used for: Due-ordered invoice queues that must drop or re-key an entry
+// (paid, cancelled, rescheduled) without waiting for it to reach the top
+// Complexity: Push O(log_d n), Pop O(d log_d n), Top O(1),
+// Update/Erase by handle O(d log_d n)
+// =============================================================================
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace billing::core {
+
+// Entries are (key, value) pairs stored inline in the heap array, next to
+// their handle; a side table maps each handle to its current position. A
+// 4-ary layout halves the depth of a binary heap, and the children compared
+// at each step of a sift-down sit next to each other in memory.
+//
+// A handle stays valid until its entry is popped or erased; after that
+// the number may be reused. Not thread-safe: callers serialize access.
+template <typename Key, typename Value, std::size_t Arity = 4,
+          typename Compare = std::less<Key>>
+class IndexedHeap {
+  static_assert(Arity >= 2, "IndexedHeap needs at least two children");
+
+public:
+  using Handle = uint32_t;
+
+  struct Entry {
+    Key key;
+    Value value;
+  };
+
+  explicit IndexedHeap(Compare comp = Compare()) : comp_(comp) {}
+
+  // Insert and return the entry's handle — O(log_d n)
+  Handle push(Key key, Value value) {
+    Handle h;
+    if (!free_.empty()) {
+      h = free_.back();
+      free_.pop_back();
+    } else {
+      h = static_cast<Handle>(pos_.size());
+      pos_.push_back(NPOS);
+    }
+    heap_.push_back({{std::move(key), std::move(value)}, h});
+    sift_up(heap_.size() - 1);
+    return h;
+  }
+
+  const Entry &top() const {
+    if (heap_.empty())
+      throw std::underflow_error("Heap is empty");
+    return heap_.front().entry;
+  }
+
+  // Remove and return the smallest entry — O(d log_d n)
+  Entry pop() {
+    if (heap_.empty())
+      throw std::underflow_error("Heap is empty");
+    return remove_at(0);
+  }
+
+  bool contains(Handle h) const { return h < pos_.size() && pos_[h] != NPOS; }
+
+  const Entry &get(Handle h) const { return heap_[position(h)].entry; }
+
+  // Change an entry's key in either direction — O(d log_d n)
+  void update_key(Handle h, Key key) {
+    std::size_t i = position(h);
+    bool up = comp_(key, heap_[i].entry.key);
+    heap_[i].entry.key = std::move(key);
+    if (up)
+      sift_up(i);
+    else
+      sift_down(i);
+  }
+
+  // Remove an entry wherever it is — O(d log_d n)
+  Entry erase(Handle h) { return remove_at(position(h)); }
+
+  // Pop every entry in key order into fn(Entry&&), leaving the heap empty.
+  // Entries are moved out one by one; nothing is copied — O(n d log_d n)
+  template <typename Fn> void drain(Fn fn) {
+    while (!heap_.empty())
+      fn(remove_at(0));
+  }
+
+  std::size_t size() const { return heap_.size(); }
+  bool empty() const { return heap_.empty(); }
+
+  void reserve(std::size_t n) {
+    heap_.reserve(n);
+    pos_.reserve(n);
+  }
+
+  void clear() {
+    heap_.clear();
+    pos_.clear();
+    free_.clear();
+  }
+
+private:
+  static constexpr uint32_t NPOS = UINT32_MAX;
+
+  struct Slot {
+    Entry entry;
+    Handle handle;
+  };
+
+  std::size_t position(Handle h) const {
+    if (!contains(h))
+      throw std::out_of_range("IndexedHeap: stale handle");
+    return pos_[h];
+  }
+
+  Entry remove_at(std::size_t i) {
+    Slot out = std::move(heap_[i]);
+    pos_[out.handle] = NPOS;
+    free_.push_back(out.handle);
+    Slot last = std::move(heap_.back());
+    heap_.pop_back();
+    if (i < heap_.size()) {
+      bool up = comp_(last.entry.key, out.entry.key);
+      heap_[i] = std::move(last);
+      pos_[heap_[i].handle] = static_cast<uint32_t>(i);
+      if (up)
+        sift_up(i);
+      else
+        sift_down(i);
+    }
+    return std::move(out.entry);
+  }
+
+  // Both sifts move a hole instead of swapping, then drop the slot in once
+  void sift_up(std::size_t i) {
+    Slot moving = std::move(heap_[i]);
+    while (i > 0) {
+      std::size_t parent = (i - 1) / Arity;
+      if (!comp_(moving.entry.key, heap_[parent].entry.key))
+        break;
+      place(i, std::move(heap_[parent]));
+      i = parent;
+    }
+    place(i, std::move(moving));
+  }
+
+  void sift_down(std::size_t i) {
+    std::size_t n = heap_.size();
+    Slot moving = std::move(heap_[i]);
+    while (true) {
+      std::size_t first = i * Arity + 1;
+      if (first >= n)
+        break;
+      std::size_t last = first + Arity < n ? first + Arity : n;
+      std::size_t best = first;
+      for (std::size_t c = first + 1; c < last; ++c)
+        if (comp_(heap_[c].entry.key, heap_[best].entry.key))
+          best = c;
+      if (!comp_(heap_[best].entry.key, moving.entry.key))
+        break;
+      place(i, std::move(heap_[best]));
+      i = best;
+    }
+    place(i, std::move(moving));
+  }
+
+  void place(std::size_t i, Slot &&slot) {
+    heap_[i] = std::move(slot);
+    pos_[heap_[i].handle] = static_cast<uint32_t>(i);
+  }
+
+  std::vector<Slot> heap_;
+  std::vector<uint32_t> pos_; // handle -> index in heap_, NPOS if free
+  std::vector<Handle> free_;
+  Compare comp_;
+};
+
+} // namespace billing::core
@@ -2,6 +2,8 @@
 // =============================================================================
 // lru_cache.hpp — LRU Cache using Doubly-Linked List + Hash Map
 // Used for: Caching frequently accessed billing records
+// Bounded by entry count, optionally also by a byte budget (per-entry sizes
+// from a caller-supplied size function)
 // Complexity: Get O(1), Put O(1), Evict O(1)
 // =============================================================================
 #include <functional>
@@ -14,14 +16,34 @@
 namespace billing::core {
 
 template <typename Key, typename Value> class LRUCache {
-  using ListIter = typename std::list<std::pair<Key, Value>>::iterator;
+  struct Entry {
+    Key key;
+    Value value;
+    std::size_t bytes; // charged footprint (0 unless a byte budget is set)
+  };
+  using ListIter = typename std::list<Entry>::iterator;
 
 public:
+  using SizeFn = std::function<std::size_t(const Key &, const Value &)>;
+
+  // Per-entry bookkeeping charged on top of size_of() (which covers the
+  // value itself): list node links + key, and the hash node (next pointer,
+  // cached hash, key copy, iterator)
+  static constexpr std::size_t ENTRY_OVERHEAD =
+      sizeof(Entry) - sizeof(Value) + 2 * sizeof(void *) +
+      2 * sizeof(void *) + sizeof(Key) + sizeof(ListIter);
+
   explicit LRUCache(std::size_t capacity) : capacity_(capacity) {
     if (capacity == 0)
       throw std::invalid_argument("LRU capacity must be > 0");
   }
 
+  // Count and byte limits together (see set_byte_budget)
+  LRUCache(std::size_t capacity, std::size_t max_bytes, SizeFn size_of)
+      : LRUCache(capacity) {
+    set_byte_budget(max_bytes, std::move(size_of));
+  }
+
   // Get value by key, moves to front — O(1)
   std::optional<Value> get(const Key &key) {
     std::lock_guard<std::mutex> lock(mutex_);
@@ -33,28 +55,32 @@ public:
     hits_++;
     // Move to front (most recently used)
     list_.splice(list_.begin(), list_, it->second);
-    return it->second->second;
+    return it->second->value;
   }
 
-  // Put key-value, evict LRU if full — O(1)
+  // Put key-value, evict LRU entries while over the count or byte limit —
+  // O(1) amortized. With a byte budget, a value bigger than the whole
+  // budget is not cached (and any older copy is dropped).
   void put(const Key &key, const Value &value) {
     std::lock_guard<std::mutex> lock(mutex_);
+    std::size_t charge = size_of_ ? size_of_(key, value) + ENTRY_OVERHEAD : 0;
     auto it = map_.find(key);
-    if (it != map_.end()) {
-      it->second->second = value;
-      list_.splice(list_.begin(), list_, it->second);
+    if (max_bytes_ && charge > max_bytes_) {
+      if (it != map_.end())
+        erase(it);
       return;
     }
-    if (list_.size() == capacity_) {
-      // Evict LRU (back of list)
-      auto &lru = list_.back();
-      if (evict_cb_)
-        evict_cb_(lru.first, lru.second);
-      map_.erase(lru.first);
-      list_.pop_back();
+    if (it != map_.end()) {
+      bytes_ = bytes_ - it->second->bytes + charge;
+      it->second->value = value;
+      it->second->bytes = charge;
+      list_.splice(list_.begin(), list_, it->second);
+    } else {
+      list_.push_front({key, value, charge});
+      map_[key] = list_.begin();
+      bytes_ += charge;
     }
-    list_.emplace_front(key, value);
-    map_[key] = list_.begin();
+    trim();
   }
 
   // Invalidate a specific key — O(1)
@@ -63,8 +89,7 @@ public:
     auto it = map_.find(key);
     if (it == map_.end())
       return false;
-    list_.erase(it->second);
-    map_.erase(it);
+    erase(it);
     return true;
   }
 
@@ -78,11 +103,54 @@ public:
     evict_cb_ = std::move(cb);
   }
 
-  std::size_t size() const { return list_.size(); }
+  // Byte-budget mode: every entry is charged size_of(key, value) plus
+  // ENTRY_OVERHEAD, and LRU entries are evicted until the total fits
+  // max_bytes (the entry-count capacity still applies). Entries already
+  // cached are re-charged and the cache trimmed immediately.
+  void set_byte_budget(std::size_t max_bytes, SizeFn size_of) {
+    if (max_bytes == 0 || !size_of)
+      throw std::invalid_argument("LRU byte budget needs a limit and sizer");
+    std::lock_guard<std::mutex> lock(mutex_);
+    max_bytes_ = max_bytes;
+    size_of_ = std::move(size_of);
+    bytes_ = 0;
+    for (auto it = list_.begin(); it != list_.end();) {
+      it->bytes = size_of_(it->key, it->value) + ENTRY_OVERHEAD;
+      if (it->bytes > max_bytes_) {
+        map_.erase(it->key);
+        it = list_.erase(it);
+        continue;
+      }
+      bytes_ += it->bytes;
+      ++it;
+    }
+    trim();
+  }
+
+  std::size_t size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return list_.size();
+  }
   std::size_t capacity() const { return capacity_; }
-  std::size_t hits() const { return hits_; }
-  std::size_t misses() const { return misses_; }
+  // Charged bytes currently cached (0 without a byte budget)
+  std::size_t bytes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return bytes_;
+  }
+  std::size_t byte_budget() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return max_bytes_;
+  }
+  std::size_t hits() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return hits_;
+  }
+  std::size_t misses() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return misses_;
+  }
   double hit_rate() const {
+    std::lock_guard<std::mutex> lock(mutex_);
     std::size_t total = hits_ + misses_;
     return total ? static_cast<double>(hits_) / total : 0.0;
   }
@@ -91,11 +159,33 @@ public:
     std::lock_guard<std::mutex> lock(mutex_);
     list_.clear();
     map_.clear();
+    bytes_ = 0;
   }
 
 private:
+  void erase(typename std::unordered_map<Key, ListIter>::iterator it) {
+    bytes_ -= it->second->bytes;
+    list_.erase(it->second);
+    map_.erase(it);
+  }
+
+  // Evict from the LRU end until both limits hold
+  void trim() {
+    while (list_.size() > capacity_ || (max_bytes_ && bytes_ > max_bytes_)) {
+      auto &lru = list_.back();
+      if (evict_cb_)
+        evict_cb_(lru.key, lru.value);
+      bytes_ -= lru.bytes;
+      map_.erase(lru.key);
+      list_.pop_back();
+    }
+  }
+
   std::size_t capacity_;
-  std::list<std::pair<Key, Value>> list_;
+  std::size_t max_bytes_ = 0; // 0 = count limit only
+  std::size_t bytes_ = 0;
+  SizeFn size_of_;
+  std::list<Entry> list_;
   std::unordered_map<Key, ListIter> map_;
   std::function<void(const Key &, const Value &)> evict_cb_;
   mutable std::mutex mutex_;
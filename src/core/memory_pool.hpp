@@ -1,66 +1,174 @@
 #pragma once
 // =============================================================================
 // memory_pool.hpp — Custom Slab Memory Pool Allocator
-// Complexity: Alloc O(1), Dealloc O(1)
-// Design: Pre-allocated contiguous block with intrusive free-list
+// Complexity: Alloc O(1), Dealloc O(1) (amortized; a refill/spill moves a
+//             batch of slots under the central lock)
+// Design: Pre-allocated aligned blocks with an intrusive central free list,
+//         fronted by a per-thread magazine of free slots so the common path
+//         takes no lock
 // =============================================================================
+#include <algorithm>
+#include <atomic>
 #include <cstddef>
-#include <cstdlib>
-#include <stdexcept>
-#include <cassert>
+#include <cstdint>
+#include <memory>
 #include <mutex>
+#include <new>
+#include <stdexcept>
+#include <utility>
 #include <vector>
 
 namespace billing::core {
 
+namespace pool_detail {
+
+// Per-thread stack of free slots for one pool. Only the owning thread
+// touches `slots`/`count` while it is alive; the pool reclaims them after
+// the thread exits.
+struct Magazine {
+    static constexpr std::size_t CAPACITY = 64;
+    static constexpr std::size_t BATCH = CAPACITY / 2; // refill/spill size
+
+    void*       slots[CAPACITY];
+    std::size_t count = 0;
+    // Written by the owner only, read by stats() from any thread
+    std::atomic<std::size_t>  hits{0};   // ops served without the lock
+    std::atomic<std::size_t>  misses{0}; // ops that refilled or spilled
+    std::atomic<std::ptrdiff_t> live{0}; // allocs - frees on this thread
+    std::atomic<bool> thread_alive{true};
+    std::atomic<bool> pool_alive{true};
+
+    void bump(std::atomic<std::size_t>& c) {
+        c.store(c.load(std::memory_order_relaxed) + 1,
+                std::memory_order_relaxed);
+    }
+    void add_live(std::ptrdiff_t d) {
+        live.store(live.load(std::memory_order_relaxed) + d,
+                   std::memory_order_relaxed);
+    }
+};
+
+// The calling thread's magazines, one per pool it has used. Pools are
+// identified by a never-reused id, so an entry for a destroyed pool can
+// never be mistaken for a new pool at the same address.
+struct ThreadMagazines {
+    struct Entry {
+        uint64_t pool_id;
+        std::shared_ptr<Magazine> magazine;
+    };
+    std::vector<Entry> entries;
+    uint64_t  last_id = 0;
+    Magazine* last = nullptr;
+
+    ~ThreadMagazines() {
+        for (auto& e : entries)
+            e.magazine->thread_alive.store(false, std::memory_order_release);
+    }
+};
+
+inline ThreadMagazines& thread_magazines() {
+    static thread_local ThreadMagazines tls;
+    return tls;
+}
+
+inline uint64_t next_pool_id() {
+    static std::atomic<uint64_t> next{1};
+    return next.fetch_add(1, std::memory_order_relaxed);
+}
+
+} // namespace pool_detail
+
 // ---------------------------------------------------------------------------
 // MemoryPool<T> — Fixed-size object pool
 // ---------------------------------------------------------------------------
 template <typename T, std::size_t BlockSize = 4096>
 class MemoryPool {
+    using Magazine = pool_detail::Magazine;
+
 public:
-    static constexpr std::size_t OBJECT_SIZE = sizeof(T) > sizeof(void*) ? sizeof(T) : sizeof(void*);
+    static constexpr std::size_t ALIGNMENT =
+        alignof(T) > alignof(void*) ? alignof(T) : alignof(void*);
+    // Slot size: holds a T or a free-list link, rounded up so every slot in
+    // a block stays aligned for T
+    static constexpr std::size_t OBJECT_SIZE =
+        ((sizeof(T) > sizeof(void*) ? sizeof(T) : sizeof(void*)) +
+         ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
 
-    MemoryPool() : free_list_(nullptr), blocks_allocated_(0), total_objects_(0) {}
+    // Per-thread view: how often that thread's magazine avoided the lock
+    struct ThreadStats {
+        std::size_t hits;
+        std::size_t misses;
+        double hit_ratio() const {
+            std::size_t total = hits + misses;
+            return total ? static_cast<double>(hits) / total : 0.0;
+        }
+    };
 
-    ~MemoryPool() {
-        for (auto* block : blocks_) {
-            std::free(block);
+    struct Stats {
+        std::size_t blocks;       // blocks obtained from the system
+        std::size_t live_objects; // allocated and not yet returned
+        std::size_t central_free; // slots on the shared free list
+        std::size_t cached_free;  // slots parked in thread magazines
+        std::size_t hits;         // summed over threads, including exited
+        std::size_t misses;
+        std::vector<ThreadStats> threads; // threads still running
+        double hit_ratio() const {
+            std::size_t total = hits + misses;
+            return total ? static_cast<double>(hits) / total : 0.0;
         }
+    };
+
+    MemoryPool() : id_(pool_detail::next_pool_id()) {}
+
+    ~MemoryPool() {
+        for (auto& m : magazines_)
+            m->pool_alive.store(false, std::memory_order_release);
+        for (auto* block : blocks_)
+            ::operator delete(block, std::align_val_t(ALIGNMENT));
     }
 
     // Non-copyable, non-movable
     MemoryPool(const MemoryPool&) = delete;
     MemoryPool& operator=(const MemoryPool&) = delete;
 
-    // Allocate one object slot — O(1)
+    // Allocate one object slot — O(1); lock-free unless the calling thread's
+    // magazine is empty
     T* allocate() {
-        std::lock_guard<std::mutex> lock(mutex_);
-        if (!free_list_) {
-            allocate_block();
+        Magazine& m = local_magazine();
+        if (m.count == 0) {
+            refill(m);
+            m.bump(m.misses);
+        } else {
+            m.bump(m.hits);
         }
-        // Pop from free list
-        void* slot = free_list_;
-        free_list_ = *reinterpret_cast<void**>(slot);
-        total_objects_++;
-        return reinterpret_cast<T*>(slot);
+        m.add_live(1);
+        return static_cast<T*>(m.slots[--m.count]);
     }
 
-    // Return object to pool — O(1)
+    // Return object to pool — O(1); lock-free unless the calling thread's
+    // magazine is full. Any thread may free a slot another thread allocated.
     void deallocate(T* ptr) {
-        std::lock_guard<std::mutex> lock(mutex_);
-        // Push onto free list
-        *reinterpret_cast<void**>(ptr) = free_list_;
-        free_list_ = ptr;
-        total_objects_--;
+        Magazine& m = local_magazine();
+        if (m.count == Magazine::CAPACITY) {
+            spill(m);
+            m.bump(m.misses);
+        } else {
+            m.bump(m.hits);
+        }
+        m.add_live(-1);
+        m.slots[m.count++] = ptr;
     }
 
     // Construct object in-place
     template <typename... Args>
     T* construct(Args&&... args) {
         T* slot = allocate();
-        new (slot) T(std::forward<Args>(args)...);
-        return slot;
+        try {
+            return new (slot) T(std::forward<Args>(args)...);
+        } catch (...) {
+            deallocate(slot);
+            throw;
+        }
     }
 
     // Destroy object and return to pool
@@ -69,25 +177,135 @@ public:
         deallocate(ptr);
     }
 
-    std::size_t total_objects() const { return total_objects_; }
-    std::size_t blocks_allocated() const { return blocks_allocated_; }
+    std::size_t total_objects() const { return stats().live_objects; }
+    std::size_t blocks_allocated() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return blocks_.size();
+    }
+
+    // Snapshot of counters — O(threads + central free list)
+    Stats stats() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Stats s{blocks_.size(), 0, 0, 0, retired_hits_, retired_misses_, {}};
+        std::ptrdiff_t live = retired_live_;
+        for (const auto& m : magazines_) {
+            std::size_t h = m->hits.load(std::memory_order_relaxed);
+            std::size_t x = m->misses.load(std::memory_order_relaxed);
+            live += m->live.load(std::memory_order_relaxed);
+            s.hits += h;
+            s.misses += x;
+            if (m->thread_alive.load(std::memory_order_acquire))
+                s.threads.push_back({h, x});
+        }
+        for (void* p = free_list_; p; p = *static_cast<void**>(p))
+            s.central_free++;
+        // Counters of running threads are read without their cooperation,
+        // so the split between live and cached is approximate meanwhile
+        std::size_t total = blocks_.size() * OBJECTS_PER_BLOCK;
+        s.live_objects = std::min<std::size_t>(
+            static_cast<std::size_t>(std::max<std::ptrdiff_t>(live, 0)),
+            total - s.central_free);
+        s.cached_free = total - s.central_free - s.live_objects;
+        return s;
+    }
 
 private:
-    void allocate_block() {
-        // Calculate how many objects fit per block
-        constexpr std::size_t objects_per_block = BlockSize / OBJECT_SIZE;
-        static_assert(objects_per_block > 0, "Object larger than block size");
+    static constexpr std::size_t OBJECTS_PER_BLOCK = BlockSize / OBJECT_SIZE;
+    static_assert(OBJECTS_PER_BLOCK > 0, "Object larger than block size");
 
-        std::size_t block_bytes = objects_per_block * OBJECT_SIZE;
-        void* block = std::malloc(block_bytes);
-        if (!block) throw std::bad_alloc();
+    // The calling thread's magazine for this pool, registered on first use
+    Magazine& local_magazine() {
+        auto& tls = pool_detail::thread_magazines();
+        if (tls.last_id == id_)
+            return *tls.last;
+        Magazine* found = nullptr;
+        for (auto& e : tls.entries)
+            if (e.pool_id == id_)
+                found = e.magazine.get();
+        if (!found) {
+            // Forget magazines of pools that no longer exist
+            auto dead = [](const pool_detail::ThreadMagazines::Entry& e) {
+                return !e.magazine->pool_alive.load(std::memory_order_acquire);
+            };
+            tls.entries.erase(std::remove_if(tls.entries.begin(),
+                                             tls.entries.end(), dead),
+                              tls.entries.end());
+            auto m = std::make_shared<Magazine>();
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                magazines_.push_back(m);
+            }
+            tls.entries.push_back({id_, m});
+            found = m.get();
+        }
+        tls.last_id = id_;
+        tls.last = found;
+        return *found;
+    }
 
-        blocks_.push_back(block);
-        blocks_allocated_++;
+    // Move up to BATCH slots from the central list into `m` (empty)
+    void refill(Magazine& m) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!free_list_)
+            reclaim_exited();
+        if (!free_list_)
+            allocate_block();
+        while (free_list_ && m.count < Magazine::BATCH) {
+            m.slots[m.count++] = free_list_;
+            free_list_ = *static_cast<void**>(free_list_);
+        }
+    }
+
+    // Move the older half of a full magazine back to the central list
+    void spill(Magazine& m) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (std::size_t i = 0; i < Magazine::BATCH; ++i)
+            push_free(m.slots[i]);
+        for (std::size_t i = Magazine::BATCH; i < m.count; ++i)
+            m.slots[i - Magazine::BATCH] = m.slots[i];
+        m.count -= Magazine::BATCH;
+    }
+
+    // Take back the slots and counters of threads that have exited;
+    // caller holds mutex_
+    void reclaim_exited() {
+        auto it = magazines_.begin();
+        while (it != magazines_.end()) {
+            Magazine& m = **it;
+            if (m.thread_alive.load(std::memory_order_acquire)) {
+                ++it;
+                continue;
+            }
+            for (std::size_t i = 0; i < m.count; ++i)
+                push_free(m.slots[i]);
+            m.count = 0;
+            retired_hits_ += m.hits.load(std::memory_order_relaxed);
+            retired_misses_ += m.misses.load(std::memory_order_relaxed);
+            retired_live_ += m.live.load(std::memory_order_relaxed);
+            it = magazines_.erase(it);
+        }
+    }
+
+    void push_free(void* slot) {
+        *static_cast<void**>(slot) = free_list_;
+        free_list_ = slot;
+    }
+
+    // Caller holds mutex_
+    void allocate_block() {
+        std::size_t block_bytes = OBJECTS_PER_BLOCK * OBJECT_SIZE;
+        void* block =
+            ::operator new(block_bytes, std::align_val_t(ALIGNMENT));
+        try {
+            blocks_.push_back(block);
+        } catch (...) {
+            ::operator delete(block, std::align_val_t(ALIGNMENT));
+            throw;
+        }
 
         // Chain all slots into free list
         char* cursor = static_cast<char*>(block);
-        for (std::size_t i = 0; i < objects_per_block - 1; ++i) {
+        for (std::size_t i = 0; i < OBJECTS_PER_BLOCK - 1; ++i) {
             *reinterpret_cast<void**>(cursor) = cursor + OBJECT_SIZE;
             cursor += OBJECT_SIZE;
         }
@@ -95,34 +313,57 @@ private:
         free_list_ = block;
     }
 
-    void*                   free_list_;
-    std::vector<void*>      blocks_;
-    std::size_t             blocks_allocated_;
-    std::size_t             total_objects_;
-    std::mutex              mutex_;
+    const uint64_t                          id_;
+    void*                                   free_list_ = nullptr;
+    std::vector<void*>                      blocks_;
+    std::vector<std::shared_ptr<Magazine>>  magazines_;
+    std::size_t                             retired_hits_ = 0;
+    std::size_t                             retired_misses_ = 0;
+    std::ptrdiff_t                          retired_live_ = 0;
+    mutable std::mutex                      mutex_;
 };
 
 // ---------------------------------------------------------------------------
 // PoolAllocator<T> — STL-compatible allocator wrapping MemoryPool
+// Single objects come from the pool; arrays (n != 1, e.g. vector storage)
+// go to aligned operator new. Node containers rebind to their node type,
+// which a MemoryPool<T> cannot serve — use core::PoolResource with a
+// std::pmr container for those.
 // ---------------------------------------------------------------------------
 template <typename T>
 class PoolAllocator {
 public:
     using value_type = T;
 
-    explicit PoolAllocator(MemoryPool<T>& pool) : pool_(pool) {}
+    explicit PoolAllocator(MemoryPool<T>& pool) : pool_(&pool) {}
 
     T* allocate(std::size_t n) {
-        if (n != 1) throw std::bad_alloc(); // pool only for single objects
-        return pool_.allocate();
+        if (n == 1)
+            return pool_->allocate();
+        if (n > static_cast<std::size_t>(-1) / sizeof(T))
+            throw std::bad_array_new_length();
+        return static_cast<T*>(::operator new(
+            n * sizeof(T), std::align_val_t(MemoryPool<T>::ALIGNMENT)));
+    }
+
+    void deallocate(T* p, std::size_t n) {
+        if (n == 1)
+            pool_->deallocate(p);
+        else
+            ::operator delete(p, std::align_val_t(MemoryPool<T>::ALIGNMENT));
     }
 
-    void deallocate(T* p, std::size_t) {
-        pool_.deallocate(p);
+    MemoryPool<T>& pool() const { return *pool_; }
+
+    friend bool operator==(const PoolAllocator& a, const PoolAllocator& b) {
+        return a.pool_ == b.pool_;
+    }
+    friend bool operator!=(const PoolAllocator& a, const PoolAllocator& b) {
+        return !(a == b);
     }
 
 private:
-    MemoryPool<T>& pool_;
+    MemoryPool<T>* pool_; // pointer so the allocator is copy-assignable
 };
 
 } // namespace billing::core
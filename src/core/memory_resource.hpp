@@ -0,0 +1,267 @@
+#pragma once
+// =============================================================================
+// memory_resource.hpp — std::pmr Resources over MemoryPool
+// Used for: Pooled node storage (PoolResource) and request-scoped scratch
+// space for services (MonotonicArena), so std::pmr containers can use the
+// pool and temporaries can be dropped in one reset instead of freed one by
+// one. CountingResource wraps another resource to count its traffic.
+// Complexity: Pool alloc/free O(1); arena alloc O(1), free no-op, reset
+// O(chunks)
+// =============================================================================
+#include "memory_pool.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <type_traits>
+#include <vector>
+
+namespace billing::core {
+
+// -----------------------------------------------------------------------------
+// PoolResource — size-class pools for small allocations. Requests up to
+// MAX_POOLED bytes (and alignment up to alignof(max_align_t)) are rounded up
+// to a power-of-two class served by a MemoryPool; anything bigger goes to
+// the upstream resource. Thread-safe: MemoryPool keeps per-thread magazines.
+// -----------------------------------------------------------------------------
+class PoolResource : public std::pmr::memory_resource {
+public:
+  static constexpr std::size_t MIN_CLASS = 8;
+  static constexpr std::size_t MAX_POOLED = 512;
+
+  explicit PoolResource(
+      std::pmr::memory_resource *upstream = std::pmr::new_delete_resource())
+      : upstream_(upstream) {}
+
+  PoolResource(const PoolResource &) = delete;
+  PoolResource &operator=(const PoolResource &) = delete;
+
+  std::pmr::memory_resource *upstream() const { return upstream_; }
+  std::size_t upstream_allocations() const {
+    return upstream_allocs_.load(std::memory_order_relaxed);
+  }
+  // Blocks held by the class serving `bytes` (0 for unpooled sizes)
+  std::size_t blocks_for(std::size_t bytes) const {
+    int cls = class_of(bytes, 1);
+    if (cls < 0)
+      return 0;
+    return with_pool<std::size_t>(
+        cls, [](auto &pool) { return pool.blocks_allocated(); });
+  }
+
+protected:
+  void *do_allocate(std::size_t bytes, std::size_t align) override {
+    int cls = class_of(bytes, align);
+    if (cls < 0) {
+      upstream_allocs_.fetch_add(1, std::memory_order_relaxed);
+      return upstream_->allocate(bytes, align);
+    }
+    return with_pool<void *>(cls,
+                             [](auto &pool) { return pool.allocate(); });
+  }
+
+  void do_deallocate(void *p, std::size_t bytes, std::size_t align) override {
+    int cls = class_of(bytes, align);
+    if (cls < 0)
+      return upstream_->deallocate(p, bytes, align);
+    with_pool<void>(cls, [p](auto &pool) {
+      using Slot = std::remove_pointer_t<decltype(pool.allocate())>;
+      pool.deallocate(static_cast<Slot *>(p));
+    });
+  }
+
+  bool do_is_equal(const std::pmr::memory_resource &other) const
+      noexcept override {
+    return this == &other;
+  }
+
+private:
+  // Slot type for one size class: N bytes aligned to N (capped at malloc's
+  // alignment), so class_of can route an alignment like a size
+  template <std::size_t N>
+  struct alignas(N < alignof(std::max_align_t) ? N : alignof(std::max_align_t))
+      Chunk {
+    unsigned char bytes[N];
+  };
+  template <std::size_t N> using Pool = MemoryPool<Chunk<N>, 16384>;
+
+  // Index of the size class (0 = 8 bytes ... 6 = 512), or -1 for upstream
+  static int class_of(std::size_t bytes, std::size_t align) {
+    if (bytes > MAX_POOLED || align > alignof(std::max_align_t))
+      return -1;
+    bytes = std::max(bytes, align);
+    int cls = 0;
+    for (std::size_t size = MIN_CLASS; size < bytes; size <<= 1)
+      cls++;
+    return cls;
+  }
+
+  // Dispatch on the class index to the pool of that size
+  template <typename R, typename Fn> R with_pool(int cls, Fn fn) const {
+    switch (cls) {
+    case 0:
+      return fn(pool8_);
+    case 1:
+      return fn(pool16_);
+    case 2:
+      return fn(pool32_);
+    case 3:
+      return fn(pool64_);
+    case 4:
+      return fn(pool128_);
+    case 5:
+      return fn(pool256_);
+    default:
+      return fn(pool512_);
+    }
+  }
+
+  std::pmr::memory_resource *upstream_;
+  std::atomic<std::size_t> upstream_allocs_{0};
+  // mutable: with_pool serves both the const stats path and allocation
+  mutable Pool<8> pool8_;
+  mutable Pool<16> pool16_;
+  mutable Pool<32> pool32_;
+  mutable Pool<64> pool64_;
+  mutable Pool<128> pool128_;
+  mutable Pool<256> pool256_;
+  mutable Pool<512> pool512_;
+};
+
+// -----------------------------------------------------------------------------
+// MonotonicArena — bump allocator for request- or batch-scoped scratch.
+// deallocate() is a no-op; reset() rewinds to the first chunk but keeps
+// every chunk, so a loop that resets once per batch stops touching the
+// upstream resource after the first few batches. Not thread-safe: give each
+// worker its own arena.
+// -----------------------------------------------------------------------------
+class MonotonicArena : public std::pmr::memory_resource {
+public:
+  explicit MonotonicArena(
+      std::size_t initial_bytes = 4096,
+      std::pmr::memory_resource *upstream = std::pmr::new_delete_resource())
+      : next_size_(std::max<std::size_t>(initial_bytes, 64)),
+        upstream_(upstream) {}
+
+  ~MonotonicArena() override {
+    for (auto &c : chunks_)
+      upstream_->deallocate(c.base, c.size, alignof(std::max_align_t));
+  }
+
+  MonotonicArena(const MonotonicArena &) = delete;
+  MonotonicArena &operator=(const MonotonicArena &) = delete;
+
+  // Forget everything allocated so far; memory is kept for reuse. Any
+  // object still using the arena must be gone before this is called.
+  void reset() {
+    current_ = 0;
+    offset_ = 0;
+    used_ = 0;
+  }
+
+  std::size_t bytes_used() const { return used_; }
+  std::size_t bytes_reserved() const {
+    std::size_t total = 0;
+    for (auto &c : chunks_)
+      total += c.size;
+    return total;
+  }
+  std::size_t chunk_count() const { return chunks_.size(); }
+
+protected:
+  void *do_allocate(std::size_t bytes, std::size_t align) override {
+    while (current_ < chunks_.size()) {
+      if (void *p = bump(chunks_[current_], bytes, align))
+        return p;
+      current_++; // too small for this request: move on to the next chunk
+      offset_ = 0;
+    }
+    // Grow geometrically; a single oversized request gets its own chunk
+    std::size_t size = std::max(next_size_, bytes + align);
+    next_size_ = size * 2;
+    chunks_.push_back(
+        {static_cast<char *>(
+             upstream_->allocate(size, alignof(std::max_align_t))),
+         size});
+    current_ = chunks_.size() - 1;
+    offset_ = 0;
+    return bump(chunks_.back(), bytes, align);
+  }
+
+  void do_deallocate(void *, std::size_t, std::size_t) override {}
+
+  bool do_is_equal(const std::pmr::memory_resource &other) const
+      noexcept override {
+    return this == &other;
+  }
+
+private:
+  struct Chunk {
+    char *base;
+    std::size_t size;
+  };
+
+  void *bump(const Chunk &c, std::size_t bytes, std::size_t align) {
+    auto addr = reinterpret_cast<uintptr_t>(c.base) + offset_;
+    std::size_t pad = (align - addr % align) % align;
+    if (offset_ + pad + bytes > c.size)
+      return nullptr;
+    offset_ += pad + bytes;
+    used_ += bytes;
+    return c.base + offset_ - bytes;
+  }
+
+  std::vector<Chunk> chunks_;
+  std::size_t current_ = 0; // chunk being bumped
+  std::size_t offset_ = 0;  // bytes consumed in chunks_[current_]
+  std::size_t used_ = 0;
+  std::size_t next_size_;
+  std::pmr::memory_resource *upstream_;
+};
+
+// -----------------------------------------------------------------------------
+// CountingResource — forwards to another resource and counts the calls.
+// Used by tests and benchmarks to show which resource serves a workload.
+// -----------------------------------------------------------------------------
+class CountingResource : public std::pmr::memory_resource {
+public:
+  explicit CountingResource(
+      std::pmr::memory_resource *upstream = std::pmr::new_delete_resource())
+      : upstream_(upstream) {}
+
+  std::size_t allocations() const {
+    return allocs_.load(std::memory_order_relaxed);
+  }
+  std::size_t deallocations() const {
+    return frees_.load(std::memory_order_relaxed);
+  }
+  std::size_t bytes_allocated() const {
+    return bytes_.load(std::memory_order_relaxed);
+  }
+
+protected:
+  void *do_allocate(std::size_t bytes, std::size_t align) override {
+    allocs_.fetch_add(1, std::memory_order_relaxed);
+    bytes_.fetch_add(bytes, std::memory_order_relaxed);
+    return upstream_->allocate(bytes, align);
+  }
+
+  void do_deallocate(void *p, std::size_t bytes, std::size_t align) override {
+    frees_.fetch_add(1, std::memory_order_relaxed);
+    upstream_->deallocate(p, bytes, align);
+  }
+
+  bool do_is_equal(const std::pmr::memory_resource &other) const
+      noexcept override {
+    return this == &other;
+  }
+
+private:
+  std::pmr::memory_resource *upstream_;
+  std::atomic<std::size_t> allocs_{0};
+  std::atomic<std::size_t> frees_{0};
+  std::atomic<std::size_t> bytes_{0};
+};
+
+} // namespace billing::core
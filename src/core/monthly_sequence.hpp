@@ -0,0 +1,300 @@
+#pragma once
+// =============================================================================
+// monthly_sequence.hpp — Persistent Per-Month Sequence Allocator
+// Used for: Human-readable invoice numbers (INV-YYYYMM0001, ...) that start
+// over each month and never repeat, across threads or process restarts
+// Complexity: O(1) per block, lock-free (one CAS) inside the current lease;
+// one small file write per `lease` numbers
+// =============================================================================
+#include <atomic>
+#include <charconv>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <fcntl.h>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <sys/file.h>
+#include <unistd.h>
+#include <vector>
+
+namespace billing::core {
+
+// A run of consecutive numbers within one month, owned by a single thread
+// or batch job
+class SequenceBlock {
+public:
+  // Room format() needs beyond the prefix: yyyymm plus a 64-bit number
+  static constexpr std::size_t MAX_SUFFIX = 6 + 20;
+
+  SequenceBlock() = default;
+
+  int month() const { return month_; } // yyyymm
+  std::size_t size() const { return count_; }
+
+  uint64_t at(std::size_t i) const {
+    if (i >= count_)
+      throw std::out_of_range("SequenceBlock index out of range");
+    return first_ + i;
+  }
+
+  // Write "<prefix><yyyymm><number, zero-padded to 4 digits>" into `buf`,
+  // which must hold prefix.size() + MAX_SUFFIX chars; returns the length.
+  // No allocation.
+  std::size_t format(std::size_t i, std::string_view prefix, char *buf) const {
+    uint64_t n = at(i);
+    char *p = buf;
+    for (char c : prefix)
+      *p++ = c;
+    p = std::to_chars(p, p + 6, month_).ptr;
+    char digits[20];
+    char *end = std::to_chars(digits, digits + sizeof(digits), n).ptr;
+    for (std::ptrdiff_t pad = 4 - (end - digits); pad > 0; --pad)
+      *p++ = '0';
+    for (char *d = digits; d != end; ++d)
+      *p++ = *d;
+    return static_cast<std::size_t>(p - buf);
+  }
+
+  // format() as a string; short results stay in the string's inline buffer
+  std::string str(std::size_t i, std::string_view prefix) const {
+    if (prefix.size() > 32)
+      throw std::invalid_argument("SequenceBlock prefix too long");
+    char buf[32 + MAX_SUFFIX];
+    return std::string(buf, format(i, prefix, buf));
+  }
+
+private:
+  friend class MonthlySequence;
+  SequenceBlock(int month, uint64_t first, std::size_t count)
+      : month_(month), first_(first), count_(count) {}
+
+  int month_ = 0;
+  uint64_t first_ = 0;
+  std::size_t count_ = 0;
+};
+
+// Numbers restart at 1 in each local calendar month. The file at `path`
+// records, per month, the highest number ever leased. Before a number is
+// handed out, it lies inside a lease already written to that file. So a
+// restarted process resumes above everything its predecessor could have
+// issued. A crash loses at most the unused part of one lease, as a gap.
+// Instances sharing the file (two engines, or two processes) take leases
+// under an flock on `path`.lock and re-read the file first, so each lease
+// starts above every other instance's.
+//
+// Inside the lease, reserve() is a single CAS on the packed (month, next)
+// state. It takes the mutex only to extend the lease, to enter a new month,
+// or to recompute the month when the clock leaves the cached one; the
+// month comes from localtime_r, never localtime.
+class MonthlySequence {
+public:
+  // Wall clock in seconds; replaceable for tests
+  using ClockFn = std::time_t (*)();
+
+  explicit MonthlySequence(std::string path, uint64_t lease = 1024,
+                           ClockFn clock = &wall_clock)
+      : path_(std::move(path)), lease_(lease), clock_(clock) {
+    if (lease == 0)
+      throw std::invalid_argument("MonthlySequence lease must be positive");
+    lock_fd_ = ::open((path_ + ".lock").c_str(), O_RDWR | O_CREAT, 0644);
+    if (lock_fd_ < 0)
+      throw std::runtime_error("Cannot open sequence lock: " + path_);
+    load();
+  }
+
+  ~MonthlySequence() { ::close(lock_fd_); }
+
+  MonthlySequence(const MonthlySequence &) = delete;
+  MonthlySequence &operator=(const MonthlySequence &) = delete;
+
+  // `count` consecutive numbers of the current month
+  SequenceBlock reserve(std::size_t count) {
+    if (count == 0)
+      throw std::invalid_argument("SequenceBlock needs at least one number");
+    std::time_t now = clock_();
+    const Month *m = month_.load(std::memory_order_acquire);
+    if (!m || now < m->start || now >= m->end)
+      return reserve_slow(count, now);
+    uint64_t s = state_.load(std::memory_order_acquire);
+    while (true) {
+      uint64_t c = ceiling_.load(std::memory_order_acquire);
+      if (month_of_state(s) != m->yyyymm || month_of_state(c) != m->yyyymm ||
+          seq_of(s) + count > seq_of(c))
+        return reserve_slow(count, now);
+      if (state_.compare_exchange_weak(s, s + count,
+                                       std::memory_order_acq_rel))
+        return SequenceBlock(m->yyyymm, seq_of(s), count);
+    }
+  }
+
+  uint64_t next() { return reserve(1).at(0); }
+
+  // Highest number leased for `yyyymm` so far (0 if none)
+  uint64_t high_water(int yyyymm) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = high_water_.find(yyyymm);
+    return it == high_water_.end() ? 0 : it->second;
+  }
+
+  // Times the high-water file has been rewritten
+  std::size_t lease_writes() const {
+    return lease_writes_.load(std::memory_order_relaxed);
+  }
+
+  // Local calendar month of `t` as yyyymm
+  static int month_of(std::time_t t) {
+    std::tm tm{};
+    localtime_r(&t, &tm);
+    return (tm.tm_year + 1900) * 100 + tm.tm_mon + 1;
+  }
+
+private:
+  static constexpr int SEQ_BITS = 44; // yyyymm fits the 20 bits above
+  static constexpr uint64_t SEQ_MASK = (uint64_t{1} << SEQ_BITS) - 1;
+
+  struct Month {
+    int yyyymm;
+    std::time_t start; // first second of the month
+    std::time_t end;   // first second of the next month
+  };
+
+  static uint64_t pack(int yyyymm, uint64_t seq) {
+    return static_cast<uint64_t>(yyyymm) << SEQ_BITS | seq;
+  }
+  static int month_of_state(uint64_t s) {
+    return static_cast<int>(s >> SEQ_BITS);
+  }
+  static uint64_t seq_of(uint64_t s) { return s & SEQ_MASK; }
+
+  static std::time_t wall_clock() { return std::time(nullptr); }
+
+  SequenceBlock reserve_slow(std::size_t count, std::time_t now) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const Month *m = cache_month(now);
+    // Entering a month (or coming back to one): resume above everything
+    // ever leased for it
+    if (month_of_state(ceiling_.load(std::memory_order_acquire)) != m->yyyymm)
+      extend(m->yyyymm, 0, count);
+    // Other threads may still CAS on the fast path; the month cannot change
+    uint64_t s = state_.load(std::memory_order_acquire);
+    while (true) {
+      if (seq_of(s) + count >
+          seq_of(ceiling_.load(std::memory_order_acquire))) {
+        extend(m->yyyymm, seq_of(s), count);
+        s = state_.load(std::memory_order_acquire);
+        continue;
+      }
+      if (state_.compare_exchange_weak(s, s + count,
+                                       std::memory_order_acq_rel))
+        return SequenceBlock(m->yyyymm, seq_of(s), count);
+    }
+  }
+
+  // Make the month of `now` current for the fast path. Months are kept for
+  // the object's lifetime, so a pointer a reader still holds stays valid.
+  const Month *cache_month(std::time_t now) {
+    const Month *m = month_.load(std::memory_order_relaxed);
+    if (m && now >= m->start && now < m->end)
+      return m;
+    std::tm tm{};
+    localtime_r(&now, &tm);
+    int yyyymm = (tm.tm_year + 1900) * 100 + tm.tm_mon + 1;
+    for (auto &known : months_)
+      if (known->yyyymm == yyyymm) {
+        month_.store(known.get(), std::memory_order_release);
+        return known.get();
+      }
+    tm.tm_mday = 1;
+    tm.tm_hour = tm.tm_min = tm.tm_sec = 0;
+    tm.tm_isdst = -1;
+    std::tm next = tm;
+    std::time_t start = std::mktime(&tm);
+    next.tm_mon += 1;
+    std::time_t end = std::mktime(&next);
+    months_.push_back(std::make_unique<Month>(Month{yyyymm, start, end}));
+    month_.store(months_.back().get(), std::memory_order_release);
+    return months_.back().get();
+  }
+
+  // Lease room for `count` numbers from `next` plus a lease, durable
+  // first, then visible. The lease continues this instance's own unless
+  // another instance has leased past it (or this one holds none for the
+  // month); then it starts above everything leased, and state_ moves there
+  // before the ceiling does, so the fast path never pairs the old state
+  // with the new ceiling. Caller holds mutex_.
+  void extend(int yyyymm, uint64_t next, std::size_t count) {
+    struct FileLock {
+      int fd;
+      explicit FileLock(int f) : fd(f) {
+        if (::flock(fd, LOCK_EX) != 0)
+          throw std::runtime_error("Cannot lock sequence file");
+      }
+      ~FileLock() { ::flock(fd, LOCK_UN); }
+    } file_lock(lock_fd_);
+    load();
+    uint64_t c = ceiling_.load(std::memory_order_acquire);
+    uint64_t leased = high_water_[yyyymm];
+    bool continues = month_of_state(c) == yyyymm && seq_of(c) == leased + 1;
+    uint64_t first = continues ? next : leased + 1;
+    uint64_t hw = first + count - 1 + lease_;
+    if (hw >= SEQ_MASK)
+      throw std::overflow_error("MonthlySequence exhausted for the month");
+    high_water_[yyyymm] = hw;
+    save();
+    if (!continues)
+      state_.store(pack(yyyymm, first), std::memory_order_release);
+    ceiling_.store(pack(yyyymm, hw + 1), std::memory_order_release);
+  }
+
+  // Merge the file in, keeping the higher mark of each month
+  void load() {
+    std::ifstream f(path_);
+    int month;
+    unsigned long long hw;
+    while (f >> month >> hw) {
+      uint64_t &mark = high_water_[month];
+      if (hw > mark)
+        mark = hw;
+    }
+  }
+
+  // Rewrite the whole file (one line per month) via fsync + rename
+  void save() {
+    std::string tmp = path_ + ".tmp";
+    std::string text;
+    for (auto &[month, hw] : high_water_)
+      text += std::to_string(month) + " " + std::to_string(hw) + "\n";
+    int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+      throw std::runtime_error("Cannot write sequence file: " + tmp);
+    bool ok = ::write(fd, text.data(), text.size()) ==
+                  static_cast<ssize_t>(text.size()) &&
+              ::fsync(fd) == 0;
+    ::close(fd);
+    if (!ok || std::rename(tmp.c_str(), path_.c_str()) != 0)
+      throw std::runtime_error("Cannot write sequence file: " + path_);
+    lease_writes_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  std::string path_;
+  uint64_t lease_;
+  ClockFn clock_;
+
+  std::atomic<uint64_t> state_{0};   // (month, next number to hand out)
+  std::atomic<uint64_t> ceiling_{0}; // (month, first number not leased)
+  std::atomic<const Month *> month_{nullptr};
+  std::atomic<std::size_t> lease_writes_{0};
+  int lock_fd_ = -1;
+
+  mutable std::mutex mutex_; // guards everything below
+  std::map<int, uint64_t> high_water_;
+  std::vector<std::unique_ptr<Month>> months_;
+};
+
+} // namespace billing::core
@@ -0,0 +1,249 @@
+#pragma once
+// =============================================================================
+// pipeline.hpp — Staged Pipeline on the Shared Thread Pool
+// Used for: Batch jobs split into stages (lookup, compute, persist, publish)
+// that each run with their own parallelism, so a stage that serializes on
+// a lock does not hold up the others
+// Complexity: O(items) per stage; at most max_in_flight items exist at once
+// =============================================================================
+#include "thread_pool.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace billing::core {
+
+// Per-stage counters from the last Pipeline::run()
+struct StageStats {
+  std::string name;
+  int workers = 0;
+  std::size_t batches = 0;         // work items handled
+  std::size_t items = 0;           // as reported by the stage function
+  double busy_ms = 0.0;            // summed over the stage's workers
+  std::size_t max_queue_depth = 0; // of the stage's input queue
+
+  // Throughput of one worker while busy
+  double items_per_sec() const {
+    return busy_ms > 0 ? static_cast<double>(items) * 1000.0 / busy_ms : 0.0;
+  }
+};
+
+// Items flow from a source through the stages in the order they were
+// added. A stage runs at most `workers` pool tasks at a time, each draining
+// the stage's input queue; with one worker a stage sees items in the order
+// the previous stage finished them. Nothing blocks a pool thread: only the
+// source waits, when max_in_flight items are already in the pipeline.
+//
+// A stage function returns how many logical items it processed, for the
+// stats. The first exception thrown by a stage or the source stops the
+// run: items still queued are dropped, and run() rethrows it once every
+// in-flight item has been accounted for.
+template <typename Item> class Pipeline {
+public:
+  using StageFn = std::function<std::size_t(Item &)>;
+
+  explicit Pipeline(ThreadPool &pool, std::size_t max_in_flight = 8)
+      : pool_(pool), max_in_flight_(max_in_flight) {
+    if (max_in_flight == 0)
+      throw std::invalid_argument("Pipeline needs room for one item");
+  }
+
+  Pipeline &stage(std::string name, int workers, StageFn fn) {
+    if (workers < 1)
+      throw std::invalid_argument("Pipeline stage needs at least one worker");
+    stages_.push_back(std::make_unique<Stage>());
+    stages_.back()->name = std::move(name);
+    stages_.back()->workers = workers;
+    stages_.back()->fn = std::move(fn);
+    return *this;
+  }
+
+  // Call source(push) on this thread, where push(Item) feeds the first stage
+  // and returns false once the run has failed; then wait for the stages to
+  // drain
+  template <typename Source> void run(Source source) {
+    if (stages_.empty())
+      throw std::logic_error("Pipeline has no stages");
+    for (auto &s : stages_)
+      s->reset();
+    error_ = nullptr;
+    failed_.store(false);
+    in_flight_ = running_ = 0;
+
+    try {
+      source([this](Item item) {
+        wait_for([&] { return in_flight_ < max_in_flight_; });
+        if (failed_.load())
+          return false;
+        {
+          std::lock_guard<std::mutex> lock(mutex_);
+          in_flight_++;
+        }
+        enqueue(0, std::move(item));
+        return true;
+      });
+    } catch (...) {
+      fail(std::current_exception());
+    }
+    wait_for([&] { return in_flight_ == 0 && running_ == 0; });
+
+    stats_.clear();
+    for (auto &s : stages_) {
+      StageStats st;
+      st.name = s->name;
+      st.workers = s->workers;
+      st.batches = s->batches;
+      st.items = s->items;
+      st.busy_ms = static_cast<double>(s->busy_ns) / 1e6;
+      st.max_queue_depth = s->max_depth;
+      stats_.push_back(std::move(st));
+    }
+    if (error_)
+      std::rethrow_exception(error_);
+  }
+
+  const std::vector<StageStats> &stats() const { return stats_; }
+
+private:
+  struct Stage {
+    std::string name;
+    int workers = 1;
+    StageFn fn;
+
+    std::mutex mutex; // guards everything below
+    std::deque<Item> queue;
+    int active = 0;
+    std::size_t max_depth = 0;
+    std::size_t batches = 0;
+    std::size_t items = 0;
+    int64_t busy_ns = 0;
+
+    void reset() {
+      std::lock_guard<std::mutex> lock(mutex);
+      queue.clear();
+      active = 0;
+      max_depth = batches = items = 0;
+      busy_ns = 0;
+    }
+  };
+
+  // Queue an item for stage k, starting a drain task if under its limit
+  void enqueue(std::size_t k, Item item) {
+    Stage &s = *stages_[k];
+    bool start;
+    {
+      std::lock_guard<std::mutex> lock(s.mutex);
+      s.queue.push_back(std::move(item));
+      s.max_depth = std::max(s.max_depth, s.queue.size());
+      start = s.active < s.workers;
+      if (start)
+        s.active++;
+    }
+    if (!start)
+      return;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      running_++;
+    }
+    pool_.execute([this, k] { drain(k); });
+  }
+
+  void drain(std::size_t k) {
+    Stage &s = *stages_[k];
+    while (true) {
+      std::optional<Item> item;
+      {
+        std::lock_guard<std::mutex> lock(s.mutex);
+        if (s.queue.empty()) {
+          s.active--;
+          break;
+        }
+        item.emplace(std::move(s.queue.front()));
+        s.queue.pop_front();
+      }
+      if (failed_.load()) {
+        finish();
+        continue;
+      }
+      try {
+        auto start = std::chrono::steady_clock::now();
+        std::size_t n = s.fn(*item);
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                      std::chrono::steady_clock::now() - start)
+                      .count();
+        {
+          std::lock_guard<std::mutex> lock(s.mutex);
+          s.batches++;
+          s.items += n;
+          s.busy_ns += ns;
+        }
+      } catch (...) {
+        fail(std::current_exception());
+        finish();
+        continue;
+      }
+      if (k + 1 < stages_.size())
+        enqueue(k + 1, std::move(*item));
+      else
+        finish();
+    }
+    // Last touch of the pipeline: run() returns only after this
+    std::lock_guard<std::mutex> lock(mutex_);
+    running_--;
+    changed_.notify_all();
+  }
+
+  // An item left the pipeline (completed or dropped)
+  void finish() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    in_flight_--;
+    changed_.notify_all();
+  }
+
+  void fail(std::exception_ptr e) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!error_)
+      error_ = e;
+    failed_.store(true);
+    changed_.notify_all();
+  }
+
+  // A pool worker calling run() helps with pending tasks while it waits;
+  // any other thread sleeps until an item leaves the pipeline
+  template <typename Pred> void wait_for(Pred ready) {
+    if (pool_.in_worker()) {
+      pool_.wait_until([&] {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return ready();
+      });
+      return;
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    changed_.wait(lock, ready);
+  }
+
+  ThreadPool &pool_;
+  std::size_t max_in_flight_;
+  std::vector<std::unique_ptr<Stage>> stages_;
+  std::vector<StageStats> stats_;
+
+  std::mutex mutex_; // guards in_flight_, running_ and error_
+  std::condition_variable changed_;
+  std::size_t in_flight_ = 0; // items between push and finish
+  std::size_t running_ = 0;   // drain tasks started and not yet returned
+  std::exception_ptr error_;
+  std::atomic<bool> failed_{false};
+};
+
+} // namespace billing::core
@@ -0,0 +1,118 @@
+#pragma once
+// =============================================================================
+// sharded_lru_cache.hpp — Lock-Striped LRU Cache
+// Used for: Record caching under many concurrent readers
+// Keys are hashed onto Shards independent LRUCache instances, each with its
+// own mutex and hit/miss counters, so threads touching different keys rarely
+// share a lock. Recency is tracked per shard (approximate global LRU).
+// Drop-in for LRUCache (get/put/evict/hit_rate, constructed from a
+// capacity), so it fits the repositories' Cache parameter.
+// Complexity: Get O(1), Put O(1), Evict O(1); stats O(Shards)
+// =============================================================================
+#include "lru_cache.hpp"
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <vector>
+
+namespace billing::core {
+
+template <typename Key, typename Value, std::size_t Shards = 16>
+class ShardedLRUCache {
+  static_assert(Shards > 0 && (Shards & (Shards - 1)) == 0,
+                "shard count must be a power of two");
+
+public:
+  // `capacity` is the total; each shard holds capacity / Shards (at least 1)
+  explicit ShardedLRUCache(std::size_t capacity) {
+    if (capacity == 0)
+      throw std::invalid_argument("LRU capacity must be > 0");
+    std::size_t per_shard = (capacity + Shards - 1) / Shards;
+    shards_.reserve(Shards);
+    for (std::size_t i = 0; i < Shards; ++i)
+      shards_.push_back(std::make_unique<Shard>(per_shard));
+  }
+
+  std::optional<Value> get(const Key &key) { return shard(key).get(key); }
+
+  void put(const Key &key, const Value &value) { shard(key).put(key, value); }
+
+  bool evict(const Key &key) { return shard(key).evict(key); }
+
+  bool contains(const Key &key) const { return shard(key).contains(key); }
+
+  // Called by whichever shard evicts; may run on several threads at once
+  void set_evict_callback(std::function<void(const Key &, const Value &)> cb) {
+    for (auto &s : shards_)
+      s->cache.set_evict_callback(cb);
+  }
+
+  // Aggregates over shards — each shard is read under its own lock, so the
+  // totals are not one atomic snapshot
+  std::size_t size() const {
+    return sum([](const LRUCache<Key, Value> &c) { return c.size(); });
+  }
+  std::size_t capacity() const {
+    return sum([](const LRUCache<Key, Value> &c) { return c.capacity(); });
+  }
+  std::size_t hits() const {
+    return sum([](const LRUCache<Key, Value> &c) { return c.hits(); });
+  }
+  std::size_t misses() const {
+    return sum([](const LRUCache<Key, Value> &c) { return c.misses(); });
+  }
+  double hit_rate() const {
+    std::size_t h = hits(), total = h + misses();
+    return total ? static_cast<double>(h) / total : 0.0;
+  }
+
+  void clear() {
+    for (auto &s : shards_)
+      s->cache.clear();
+  }
+
+  static constexpr std::size_t shard_count() { return Shards; }
+
+  // Shard a key maps to — exposed for tests and diagnostics
+  std::size_t shard_of(const Key &key) const {
+    if constexpr (Shards == 1)
+      return 0;
+    // Fibonacci hashing: ids are often sequential, so take the top bits
+    // of a multiplicative mix rather than hash % Shards
+    uint64_t h = static_cast<uint64_t>(std::hash<Key>{}(key));
+    return static_cast<std::size_t>((h * 0x9E3779B97F4A7C15ULL) >>
+                                    (64 - log2(Shards)));
+  }
+
+private:
+  // One cache line (or more) per shard so neighbouring locks do not
+  // false-share
+  struct alignas(64) Shard {
+    explicit Shard(std::size_t capacity) : cache(capacity) {}
+    LRUCache<Key, Value> cache;
+  };
+
+  static constexpr int log2(std::size_t n) {
+    return n <= 1 ? 0 : 1 + log2(n / 2);
+  }
+
+  LRUCache<Key, Value> &shard(const Key &key) {
+    return shards_[shard_of(key)]->cache;
+  }
+  const LRUCache<Key, Value> &shard(const Key &key) const {
+    return shards_[shard_of(key)]->cache;
+  }
+
+  template <typename Fn> std::size_t sum(Fn fn) const {
+    std::size_t total = 0;
+    for (auto &s : shards_)
+      total += fn(s->cache);
+    return total;
+  }
+
+  std::vector<std::unique_ptr<Shard>> shards_;
+};
+
+} // namespace billing::core
@@ -0,0 +1,266 @@
+#pragma once
+// =============================================================================
+// thread_pool.hpp — Work-Stealing Thread Pool
+// Used for: Every service's background and parallel work (batch billing,
+// report building, notification dispatch) on one process-wide set of
+// threads instead of threads created per call
+// Complexity: Submit O(1), Take O(1) own deque / O(workers) when stealing
+// =============================================================================
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdlib>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace billing::core {
+
+// Thrown through a task's future when it was cancelled before it started
+class TaskCancelled : public std::runtime_error {
+public:
+  TaskCancelled() : std::runtime_error("Task cancelled") {}
+};
+
+// Shared cancel flag: copies handed to tasks see cancel() on any of them.
+// Queued tasks are skipped; running tasks may poll cancelled().
+class CancellationToken {
+public:
+  CancellationToken() : flag_(std::make_shared<std::atomic<bool>>(false)) {}
+
+  void cancel() { flag_->store(true, std::memory_order_release); }
+  bool cancelled() const { return flag_->load(std::memory_order_acquire); }
+  void throw_if_cancelled() const {
+    if (cancelled())
+      throw TaskCancelled();
+  }
+
+private:
+  std::shared_ptr<std::atomic<bool>> flag_;
+};
+
+// Each worker owns a deque. A worker pushes and pops its own tasks at the
+// back (newest first, while their data is still in cache); idle workers
+// steal from the front of the others' deques (oldest first, usually the
+// biggest pieces of work). Tasks submitted from outside the pool are
+// dealt round-robin.
+//
+// A task may wait on tasks it submitted through wait()/get(): a worker
+// that waits runs other pending tasks instead of blocking, so nested
+// parallelism cannot deadlock the pool. The destructor finishes every
+// queued task before joining.
+class ThreadPool {
+public:
+  explicit ThreadPool(std::size_t threads = default_threads()) {
+    if (threads == 0)
+      throw std::invalid_argument("ThreadPool needs at least one thread");
+    for (std::size_t i = 0; i < threads; ++i)
+      workers_.push_back(std::make_unique<Worker>());
+    for (std::size_t i = 0; i < threads; ++i)
+      workers_[i]->thread = std::thread([this, i] { work(i); });
+  }
+
+  ~ThreadPool() {
+    {
+      std::lock_guard<std::mutex> lock(sleep_mutex_);
+      stop_ = true;
+    }
+    wake_.notify_all();
+    for (auto &w : workers_)
+      w->thread.join();
+  }
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  // Run fn() on the pool; its result or exception arrives through the future
+  template <typename Fn>
+  std::future<std::invoke_result_t<Fn>> submit(Fn fn) {
+    using R = std::invoke_result_t<Fn>;
+    auto task = std::make_shared<std::packaged_task<R()>>(std::move(fn));
+    auto fut = task->get_future();
+    push([task] { (*task)(); });
+    return fut;
+  }
+
+  // As submit(), but skipped — its future throws TaskCancelled — if
+  // `token` is cancelled before the task starts
+  template <typename Fn>
+  std::future<std::invoke_result_t<Fn>> submit(const CancellationToken &token,
+                                               Fn fn) {
+    return submit([token, fn = std::move(fn)]() mutable {
+      token.throw_if_cancelled();
+      return fn();
+    });
+  }
+
+  // Fire-and-forget: no future. fn must not throw.
+  void execute(std::function<void()> fn) { push(std::move(fn)); }
+
+  // Block until `fut` is ready. On a pool worker, run other tasks meanwhile.
+  template <typename T> void wait(const std::future<T> &fut) {
+    if (!in_worker()) {
+      fut.wait();
+      return;
+    }
+    wait_until([&] {
+      return fut.wait_for(std::chrono::seconds(0)) ==
+             std::future_status::ready;
+    });
+  }
+
+  template <typename T> T get(std::future<T> &fut) {
+    wait(fut);
+    return fut.get();
+  }
+
+  // Wait until every future is ready, without consuming them. Call this
+  // before the first get() when tasks share the caller's state, so an early
+  // failure cannot unwind it under tasks that are still running.
+  template <typename T>
+  void wait_all(const std::vector<std::future<T>> &futs) {
+    for (auto &f : futs)
+      wait(f);
+  }
+
+  // Spin-help until done(): pool workers run pending tasks, other threads
+  // sleep briefly between checks. For waits whose wake-up is not a future.
+  template <typename Pred> void wait_until(Pred done) {
+    while (!done()) {
+      if (in_worker() && run_one())
+        continue;
+      std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+  }
+
+  // Run one pending task on the calling thread; false if none was queued
+  bool run_one() {
+    std::function<void()> task;
+    std::size_t self = in_worker() ? current_index() : 0;
+    if (!take(self, task))
+      return false;
+    task();
+    return true;
+  }
+
+  // True when called from one of this pool's workers
+  bool in_worker() const { return current_pool() == this; }
+
+  std::size_t size() const { return workers_.size(); }
+  std::size_t pending() const {
+    return pending_.load(std::memory_order_relaxed);
+  }
+  // Tasks taken from another worker's deque since construction
+  std::size_t steals() const { return steals_.load(std::memory_order_relaxed); }
+
+  // $BILLING_POOL_THREADS if set, else one thread per hardware thread
+  static std::size_t default_threads() {
+    if (const char *env = std::getenv("BILLING_POOL_THREADS"))
+      if (long n = std::strtol(env, nullptr, 10); n > 0)
+        return static_cast<std::size_t>(n);
+    return std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  // Process-wide pool shared by the services
+  static ThreadPool &instance() {
+    static ThreadPool pool;
+    return pool;
+  }
+
+private:
+  struct Worker {
+    std::mutex mutex;
+    std::deque<std::function<void()>> tasks;
+    std::thread thread;
+  };
+
+  static const ThreadPool *&current_pool() {
+    thread_local const ThreadPool *pool = nullptr;
+    return pool;
+  }
+  static std::size_t &current_index() {
+    thread_local std::size_t index = 0;
+    return index;
+  }
+
+  void push(std::function<void()> task) {
+    std::size_t i = in_worker()
+                        ? current_index()
+                        : next_.fetch_add(1, std::memory_order_relaxed) %
+                              workers_.size();
+    {
+      // Counted first (under the sleep lock, so a worker cannot miss the
+      // wake-up) so a take can never drive the count below zero
+      std::lock_guard<std::mutex> lock(sleep_mutex_);
+      pending_.fetch_add(1, std::memory_order_relaxed);
+    }
+    {
+      std::lock_guard<std::mutex> lock(workers_[i]->mutex);
+      workers_[i]->tasks.push_back(std::move(task));
+    }
+    wake_.notify_one();
+  }
+
+  // Own deque from the back, then the others' from the front
+  bool take(std::size_t self, std::function<void()> &out) {
+    {
+      Worker &w = *workers_[self];
+      std::lock_guard<std::mutex> lock(w.mutex);
+      if (!w.tasks.empty()) {
+        out = std::move(w.tasks.back());
+        w.tasks.pop_back();
+        pending_.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+      }
+    }
+    for (std::size_t k = 1; k < workers_.size(); ++k) {
+      Worker &victim = *workers_[(self + k) % workers_.size()];
+      std::lock_guard<std::mutex> lock(victim.mutex);
+      if (victim.tasks.empty())
+        continue;
+      out = std::move(victim.tasks.front());
+      victim.tasks.pop_front();
+      pending_.fetch_sub(1, std::memory_order_relaxed);
+      steals_.fetch_add(1, std::memory_order_relaxed);
+      return true;
+    }
+    return false;
+  }
+
+  void work(std::size_t self) {
+    current_pool() = this;
+    current_index() = self;
+    std::function<void()> task;
+    while (true) {
+      if (take(self, task)) {
+        task();
+        task = nullptr;
+        continue;
+      }
+      std::unique_lock<std::mutex> lock(sleep_mutex_);
+      wake_.wait(lock, [&] {
+        return stop_ || pending_.load(std::memory_order_relaxed) > 0;
+      });
+      if (stop_ && pending_.load(std::memory_order_relaxed) == 0)
+        return;
+    }
+  }
+
+  std::vector<std::unique_ptr<Worker>> workers_;
+  std::atomic<std::size_t> next_{0};
+  std::atomic<std::size_t> pending_{0};
+  std::atomic<std::size_t> steals_{0};
+  std::mutex sleep_mutex_;
+  std::condition_variable wake_;
+  bool stop_ = false;
+};
+
+} // namespace billing::core
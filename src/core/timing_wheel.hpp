@@ -0,0 +1,271 @@
+#pragma once
+// =============================================================================
+// timing_wheel.hpp — Hierarchical Timing Wheel for Due-Date Scheduling
+// Used for: Invoice due dates, keyed by id. Advancing the clock drains
+// whole expired buckets instead of popping entries one at a time.
+// Complexity: Schedule/Cancel O(1), Advance O(expired + cascaded),
+// Earliest O(levels + bucket)
+// =============================================================================
+#include <array>
+#include <cstdint>
+#include <ctime>
+#include <optional>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+namespace billing::core {
+
+// Ticks are split into 6-bit digits, one per level, with 64 slots per level;
+// 11 levels cover every 64-bit tick. An entry sits at the lowest level whose
+// higher digits it shares with the current tick, so every entry on a lower
+// level is due before any entry on a higher one, and slots within a level
+// are in due order. Moving the clock into a higher-level slot cascades that
+// slot's entries down a level or more; each entry cascades at most LEVELS
+// times in its life.
+//
+// Not thread-safe: callers serialize access. Callbacks passed to advance()
+// must not call back into the wheel.
+template <typename Id = int64_t> class TimingWheel {
+public:
+  static constexpr int SLOT_BITS = 6;
+  static constexpr std::size_t SLOTS = std::size_t{1} << SLOT_BITS;
+  static constexpr int LEVELS = 11;
+
+  struct Entry {
+    Id id;
+    std::time_t deadline;
+  };
+
+  explicit TimingWheel(std::time_t start = std::time(nullptr),
+                       std::time_t tick_seconds = 1)
+      : tick_seconds_(tick_seconds) {
+    if (tick_seconds <= 0)
+      throw std::invalid_argument("TimingWheel tick must be positive");
+    now_ = to_tick(start);
+    heads_.fill(NIL);
+    occupied_.fill(0);
+  }
+
+  // Insert `id`, or move it if already scheduled. Deadlines at or before the
+  // current tick land in the current slot and expire on the next advance().
+  // Returns true if `id` was not scheduled before — O(1)
+  bool schedule(Id id, std::time_t deadline) {
+    auto [it, inserted] = index_.try_emplace(id, NIL);
+    if (inserted) {
+      it->second = alloc_node(id, deadline);
+    } else {
+      unlink(it->second);
+      nodes_[it->second].deadline = deadline;
+    }
+    link(it->second);
+    return inserted;
+  }
+
+  // Remove `id`; false if it was not scheduled — O(1)
+  bool cancel(Id id) {
+    auto it = index_.find(id);
+    if (it == index_.end())
+      return false;
+    unlink(it->second);
+    free_.push_back(it->second);
+    index_.erase(it);
+    return true;
+  }
+
+  bool contains(Id id) const { return index_.count(id) != 0; }
+
+  std::optional<std::time_t> deadline_of(Id id) const {
+    auto it = index_.find(id);
+    if (it == index_.end())
+      return std::nullopt;
+    return nodes_[it->second].deadline;
+  }
+
+  // Move the clock to `now` and call fn(id, deadline) for every entry due
+  // at or before it, earliest bucket first. The clock never goes back.
+  // Returns the number of expired entries — O(expired + cascaded)
+  template <typename Fn> std::size_t advance(std::time_t now, Fn fn) {
+    uint64_t target = to_tick(now);
+    if (target < now_)
+      return 0;
+    std::size_t expired = 0;
+    while (true) {
+      // Level 0 holds the rest of the current 64-tick block
+      uint64_t block_end = now_ | (SLOTS - 1);
+      uint64_t last = target < block_end ? target : block_end;
+      uint64_t due = occupied_[0] & range_mask(digit(now_, 0), digit(last, 0));
+      for (; due; due &= due - 1)
+        expired += expire_slot(__builtin_ctzll(due), fn);
+      if (target <= block_end) {
+        now_ = target;
+        return expired;
+      }
+      // Jump straight to the next occupied higher-level slot, if due
+      now_ = block_end;
+      int level = 1;
+      while (level < LEVELS && !occupied_[level])
+        level++;
+      if (level == LEVELS) {
+        now_ = target;
+        return expired;
+      }
+      uint64_t d = __builtin_ctzll(occupied_[level]);
+      uint64_t start = above(now_, level + 1) | d << (level * SLOT_BITS);
+      if (start > target) {
+        now_ = target;
+        return expired;
+      }
+      now_ = start;
+      cascade(level, d);
+    }
+  }
+
+  // Earliest scheduled entry, without removing it — O(levels + bucket)
+  std::optional<Entry> earliest() const {
+    for (int level = 0; level < LEVELS; ++level) {
+      if (!occupied_[level])
+        continue;
+      std::size_t s = slot_index(level, __builtin_ctzll(occupied_[level]));
+      uint32_t best = heads_[s];
+      for (uint32_t n = nodes_[best].next; n != NIL; n = nodes_[n].next)
+        if (nodes_[n].deadline < nodes_[best].deadline)
+          best = n;
+      return Entry{nodes_[best].id, nodes_[best].deadline};
+    }
+    return std::nullopt;
+  }
+
+  // Pre-size node storage and the id index for `n` entries
+  void reserve(std::size_t n) {
+    nodes_.reserve(n);
+    index_.reserve(n);
+  }
+
+  std::size_t size() const { return index_.size(); }
+  bool empty() const { return index_.empty(); }
+  std::time_t now() const {
+    return static_cast<std::time_t>(now_) * tick_seconds_;
+  }
+
+  void clear() {
+    nodes_.clear();
+    free_.clear();
+    index_.clear();
+    heads_.fill(NIL);
+    occupied_.fill(0);
+  }
+
+private:
+  static constexpr uint32_t NIL = UINT32_MAX;
+
+  struct Node {
+    Id id;
+    std::time_t deadline;
+    uint32_t prev;
+    uint32_t next;
+    uint32_t slot;
+  };
+
+  uint64_t to_tick(std::time_t t) const {
+    return t <= 0 ? 0 : static_cast<uint64_t>(t / tick_seconds_);
+  }
+  static uint64_t digit(uint64_t tick, int level) {
+    return (tick >> (level * SLOT_BITS)) & (SLOTS - 1);
+  }
+  // The digits of `tick` from `level` upwards, lower digits cleared
+  static uint64_t above(uint64_t tick, int level) {
+    int shift = level * SLOT_BITS;
+    return shift >= 64 ? 0 : tick >> shift << shift;
+  }
+  static uint64_t range_mask(uint64_t lo, uint64_t hi) {
+    uint64_t upto = hi == SLOTS - 1 ? ~uint64_t{0} : (uint64_t{2} << hi) - 1;
+    return upto & ~((uint64_t{1} << lo) - 1);
+  }
+  static std::size_t slot_index(int level, uint64_t d) {
+    return static_cast<std::size_t>(level) * SLOTS + d;
+  }
+
+  uint32_t alloc_node(Id id, std::time_t deadline) {
+    Node node{id, deadline, NIL, NIL, 0};
+    if (!free_.empty()) {
+      uint32_t n = free_.back();
+      free_.pop_back();
+      nodes_[n] = node;
+      return n;
+    }
+    nodes_.push_back(node);
+    return static_cast<uint32_t>(nodes_.size() - 1);
+  }
+
+  // Place a node by its deadline relative to the current tick
+  void link(uint32_t n) {
+    uint64_t tick = to_tick(nodes_[n].deadline);
+    if (tick < now_)
+      tick = now_;
+    int level = 0;
+    if (uint64_t diff = tick ^ now_)
+      level = (63 - __builtin_clzll(diff)) / SLOT_BITS;
+    uint64_t d = digit(tick, level);
+    std::size_t s = slot_index(level, d);
+    Node &node = nodes_[n];
+    node.slot = static_cast<uint32_t>(s);
+    node.prev = NIL;
+    node.next = heads_[s];
+    if (node.next != NIL)
+      nodes_[node.next].prev = n;
+    heads_[s] = n;
+    occupied_[level] |= uint64_t{1} << d;
+  }
+
+  void unlink(uint32_t n) {
+    Node &node = nodes_[n];
+    if (node.prev != NIL)
+      nodes_[node.prev].next = node.next;
+    else
+      heads_[node.slot] = node.next;
+    if (node.next != NIL)
+      nodes_[node.next].prev = node.prev;
+    if (heads_[node.slot] == NIL)
+      occupied_[node.slot / SLOTS] &= ~(uint64_t{1} << node.slot % SLOTS);
+  }
+
+  // Detach a whole slot and return its first node
+  uint32_t take_slot(int level, uint64_t d) {
+    std::size_t s = slot_index(level, d);
+    uint32_t head = heads_[s];
+    heads_[s] = NIL;
+    occupied_[level] &= ~(uint64_t{1} << d);
+    return head;
+  }
+
+  template <typename Fn> std::size_t expire_slot(uint64_t d, Fn &fn) {
+    std::size_t count = 0;
+    for (uint32_t n = take_slot(0, d); n != NIL; count++) {
+      Node node = nodes_[n];
+      index_.erase(node.id);
+      free_.push_back(n);
+      fn(node.id, node.deadline);
+      n = node.next;
+    }
+    return count;
+  }
+
+  void cascade(int level, uint64_t d) {
+    for (uint32_t n = take_slot(level, d); n != NIL;) {
+      uint32_t next = nodes_[n].next;
+      link(n);
+      n = next;
+    }
+  }
+
+  std::time_t tick_seconds_;
+  uint64_t now_; // current tick
+  std::vector<Node> nodes_;
+  std::vector<uint32_t> free_;
+  std::unordered_map<Id, uint32_t> index_;
+  std::array<uint32_t, LEVELS * SLOTS> heads_;
+  std::array<uint64_t, LEVELS> occupied_; // bit per non-empty slot
+};
+
+} // namespace billing::core
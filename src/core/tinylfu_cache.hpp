@@ -0,0 +1,266 @@
+#pragma once
+// =============================================================================
+// tinylfu_cache.hpp — W-TinyLFU Cache (scan-resistant admission)
+// Used for: Record caches that must survive full-table scans (reports)
+// New entries land in a small LRU window (1% of capacity). An entry pushed
+// out of the window only enters the main cache if a count-min sketch says
+// it is used more often than the main cache's eviction victim, so a one-off
+// scan cannot flush the hot set. The main cache is a segmented LRU: hits in
+// probation (20%) promote to protected (80%).
+// Same interface as LRUCache, so repositories can take it as their Cache.
+// Complexity: Get O(1), Put O(1), Evict O(1); sketch update O(depth)
+// =============================================================================
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+namespace billing::core {
+
+// -----------------------------------------------------------------------------
+// Count-min sketch of access frequency: 4 rows of 4-bit-range counters
+// (saturating at 15). After 10 x capacity increments every counter is
+// halved, so old popularity fades.
+// -----------------------------------------------------------------------------
+class FrequencySketch {
+public:
+  static constexpr int DEPTH = 4;
+  static constexpr uint8_t MAX_COUNT = 15;
+
+  explicit FrequencySketch(std::size_t capacity)
+      : sample_size_(std::max<std::size_t>(capacity, 1) * 10) {
+    std::size_t width = 16;
+    while (width < capacity * 2)
+      width <<= 1;
+    mask_ = width - 1;
+    table_.assign(width * DEPTH, 0);
+  }
+
+  // Conservative update: only the counters at the current minimum grow
+  void increment(uint64_t hash) {
+    std::array<std::size_t, DEPTH> slots;
+    uint8_t min = MAX_COUNT;
+    for (int row = 0; row < DEPTH; ++row) {
+      slots[row] = slot(hash, row);
+      min = std::min(min, table_[slots[row]]);
+    }
+    if (min == MAX_COUNT)
+      return;
+    for (std::size_t s : slots)
+      if (table_[s] == min)
+        table_[s]++;
+    if (++additions_ >= sample_size_)
+      age();
+  }
+
+  uint8_t estimate(uint64_t hash) const {
+    uint8_t min = MAX_COUNT;
+    for (int row = 0; row < DEPTH; ++row)
+      min = std::min(min, table_[slot(hash, row)]);
+    return min;
+  }
+
+  void clear() {
+    std::fill(table_.begin(), table_.end(), 0);
+    additions_ = 0;
+  }
+
+private:
+  std::size_t slot(uint64_t hash, int row) const {
+    // splitmix64 finalizer with a per-row seed
+    uint64_t h = hash + 0x9E3779B97F4A7C15ULL * (row + 1);
+    h = (h ^ (h >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    h = (h ^ (h >> 27)) * 0x94D049BB133111EBULL;
+    h ^= h >> 31;
+    return (h & mask_) * DEPTH + row;
+  }
+
+  void age() {
+    for (auto &c : table_)
+      c >>= 1;
+    additions_ /= 2;
+  }
+
+  std::vector<uint8_t> table_;
+  std::size_t mask_ = 0;
+  std::size_t sample_size_;
+  std::size_t additions_ = 0;
+};
+
+template <typename Key, typename Value> class TinyLFUCache {
+  enum class Segment : uint8_t { WINDOW, PROBATION, PROTECTED };
+  using List = std::list<std::pair<Key, Value>>;
+  struct Slot {
+    typename List::iterator it;
+    Segment segment;
+  };
+
+public:
+  explicit TinyLFUCache(std::size_t capacity)
+      : capacity_(capacity), sketch_(capacity) {
+    if (capacity == 0)
+      throw std::invalid_argument("LRU capacity must be > 0");
+    // A single slot is all main cache
+    window_cap_ = capacity == 1 ? 0 : std::max<std::size_t>(1, capacity / 100);
+    main_cap_ = capacity - window_cap_;
+    protected_cap_ = main_cap_ * 8 / 10;
+  }
+
+  // Get value by key; records the access in the sketch — O(1)
+  std::optional<Value> get(const Key &key) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    sketch_.increment(hash(key));
+    auto it = map_.find(key);
+    if (it == map_.end()) {
+      misses_++;
+      return std::nullopt;
+    }
+    hits_++;
+    touch(it->second);
+    return it->second.it->second;
+  }
+
+  // Put key-value; a new key enters the window and may push a candidate
+  // through admission — O(1)
+  void put(const Key &key, const Value &value) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    sketch_.increment(hash(key));
+    auto it = map_.find(key);
+    if (it != map_.end()) {
+      it->second.it->second = value;
+      touch(it->second);
+      return;
+    }
+    if (window_cap_ == 0) {
+      admit(key, value);
+      return;
+    }
+    window_.emplace_front(key, value);
+    map_[key] = {window_.begin(), Segment::WINDOW};
+    if (window_.size() > window_cap_) {
+      auto candidate = std::move(window_.back());
+      window_.pop_back();
+      map_.erase(candidate.first);
+      admit(candidate.first, candidate.second);
+    }
+  }
+
+  // Invalidate a specific key — O(1)
+  bool evict(const Key &key) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = map_.find(key);
+    if (it == map_.end())
+      return false;
+    list_of(it->second.segment).erase(it->second.it);
+    map_.erase(it);
+    return true;
+  }
+
+  bool contains(const Key &key) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return map_.count(key) > 0;
+  }
+
+  // Set eviction callback (called for entries dropped by the policy,
+  // including candidates refused admission)
+  void set_evict_callback(std::function<void(const Key &, const Value &)> cb) {
+    evict_cb_ = std::move(cb);
+  }
+
+  std::size_t size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return map_.size();
+  }
+  std::size_t capacity() const { return capacity_; }
+  std::size_t hits() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return hits_;
+  }
+  std::size_t misses() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return misses_;
+  }
+  double hit_rate() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::size_t total = hits_ + misses_;
+    return total ? static_cast<double>(hits_) / total : 0.0;
+  }
+
+  void clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    window_.clear();
+    probation_.clear();
+    protected_.clear();
+    map_.clear();
+    sketch_.clear();
+  }
+
+private:
+  static uint64_t hash(const Key &key) {
+    return static_cast<uint64_t>(std::hash<Key>{}(key));
+  }
+
+  List &list_of(Segment s) {
+    return s == Segment::WINDOW      ? window_
+           : s == Segment::PROBATION ? probation_
+                                     : protected_;
+  }
+
+  // Hit: move to MRU of its segment; a probation hit is promoted, demoting
+  // the protected LRU back to probation if protected is full
+  void touch(Slot &slot) {
+    if (slot.segment == Segment::PROBATION) {
+      protected_.splice(protected_.begin(), probation_, slot.it);
+      slot.segment = Segment::PROTECTED;
+      if (protected_.size() > protected_cap_) {
+        auto demoted = std::prev(protected_.end());
+        probation_.splice(probation_.begin(), protected_, demoted);
+        map_[demoted->first].segment = Segment::PROBATION;
+      }
+      return;
+    }
+    List &list = list_of(slot.segment);
+    list.splice(list.begin(), list, slot.it);
+  }
+
+  // Candidate leaving the window: enters probation if there is room, or if
+  // it is more frequent than the probation LRU victim; otherwise dropped
+  void admit(const Key &key, const Value &value) {
+    if (probation_.size() + protected_.size() >= main_cap_) {
+      List &victims = probation_.empty() ? protected_ : probation_;
+      auto &victim = victims.back();
+      uint8_t victim_freq = sketch_.estimate(hash(victim.first));
+      if (sketch_.estimate(hash(key)) <= victim_freq) {
+        if (evict_cb_)
+          evict_cb_(key, value);
+        return;
+      }
+      if (evict_cb_)
+        evict_cb_(victim.first, victim.second);
+      map_.erase(victim.first);
+      victims.pop_back();
+    }
+    probation_.emplace_front(key, value);
+    map_[key] = {probation_.begin(), Segment::PROBATION};
+  }
+
+  std::size_t capacity_;
+  std::size_t window_cap_;
+  std::size_t main_cap_;
+  std::size_t protected_cap_;
+  FrequencySketch sketch_;
+  List window_, probation_, protected_;
+  std::unordered_map<Key, Slot> map_;
+  std::function<void(const Key &, const Value &)> evict_cb_;
+  mutable std::mutex mutex_;
+  std::size_t hits_ = 0;
+  std::size_t misses_ = 0;
+};
+
+} // namespace billing::core
@@ -0,0 +1,356 @@
+#pragma once
+// =============================================================================
+// write_ahead_log.hpp — Append-Only Write-Ahead Log
+// Used for: Record-level persistence of repository mutations
+// Frame format: [length u32][checksum u32][payload bytes]
+// Errors: a failed write is cut back off the segment; an fsync error, or a
+// write that cannot be cut back, fails the log and every later call throws
+// Complexity: Append O(record), Replay O(log size)
+// =============================================================================
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+namespace billing::core {
+
+// When an appended record is considered durable
+enum class SyncPolicy {
+  PER_OP,       // fsync inside every append
+  GROUP_COMMIT, // committers share one fsync (leader/follower)
+  PERIODIC      // background fsync every sync_interval
+};
+
+struct WALOptions {
+  SyncPolicy policy = SyncPolicy::GROUP_COMMIT;
+  std::chrono::milliseconds sync_interval{50}; // PERIODIC only
+  std::size_t checkpoint_bytes = 4u << 20;     // log size that compacts
+};
+
+class WriteAheadLog {
+public:
+  static constexpr std::size_t FRAME_HEADER = 2 * sizeof(uint32_t);
+
+  WriteAheadLog(const std::string &path, WALOptions opts = {})
+      : path_(path), opts_(opts) {}
+
+  ~WriteAheadLog() {
+    try {
+      close();
+    } catch (const std::exception &) {
+      // Nothing more to do; the failure was reported to the last committer
+    }
+  }
+
+  WriteAheadLog(const WriteAheadLog &) = delete;
+  WriteAheadLog &operator=(const WriteAheadLog &) = delete;
+
+  // Replay every intact frame of an existing log, drop any torn tail and open
+  // the file for appending. Returns the number of frames replayed.
+  std::size_t recover(
+      const std::function<void(const char *data, std::size_t len)> &fn) {
+    std::size_t valid_bytes = 0;
+    std::size_t frames = replay_file(path_, fn, &valid_bytes);
+    open_for_append(valid_bytes);
+    return frames;
+  }
+
+  // Append one record — O(record). Returns its LSN for commit().
+  uint64_t append(const std::string &payload) {
+    std::string frame;
+    encode_frame(frame, payload);
+    std::lock_guard<std::mutex> lock(append_mutex_);
+    check_usable();
+    try {
+      write_all(frame.data(), frame.size());
+    } catch (...) {
+      // Cut any partial frame off, or a later frame would land behind it
+      // and replay would stop at the tear
+      off_t start = static_cast<off_t>(segment_bytes_.load());
+      if (::ftruncate(fd_, start) != 0 || ::lseek(fd_, start, SEEK_SET) < 0)
+        failed_ = true;
+      throw;
+    }
+    if (opts_.policy == SyncPolicy::PER_OP)
+      sync_fd();
+    segment_bytes_ += frame.size();
+    return written_lsn_.fetch_add(frame.size()) + frame.size();
+  }
+
+  // Block until the record at `lsn` is durable under the configured policy.
+  // GROUP_COMMIT: the first waiter fsyncs on behalf of everyone queued behind.
+  void commit(uint64_t lsn) {
+    if (opts_.policy != SyncPolicy::GROUP_COMMIT)
+      return; // PER_OP already synced; PERIODIC syncs in the background
+    std::unique_lock<std::mutex> lk(sync_mutex_);
+    while (durable_lsn_ < lsn) {
+      if (!syncing_) {
+        lead_sync(lk);
+      } else {
+        sync_cv_.wait(lk);
+      }
+    }
+  }
+
+  // Force everything written so far to disk
+  void sync() {
+    std::unique_lock<std::mutex> lk(sync_mutex_);
+    uint64_t target = written_lsn_.load();
+    while (durable_lsn_ < target) {
+      if (!syncing_)
+        lead_sync(lk);
+      else
+        sync_cv_.wait(lk);
+    }
+  }
+
+  // Move the current segment to `archive_path` (appending if one is already
+  // there) and start an empty segment. Used by checkpointing: the caller
+  // snapshots its state under its own lock, rotates, then compacts offline.
+  void rotate(const std::string &archive_path) {
+    std::unique_lock<std::mutex> lk(sync_mutex_);
+    sync_cv_.wait(lk, [&] { return !syncing_; });
+    syncing_ = true; // keep leaders off fd_ while it is swapped
+    {
+      std::lock_guard<std::mutex> alock(append_mutex_);
+      try {
+        sync_fd();
+      } catch (...) {
+        syncing_ = false;
+        sync_cv_.notify_all();
+        throw;
+      }
+      ::close(fd_);
+      fd_ = -1;
+      struct stat st;
+      if (::stat(archive_path.c_str(), &st) == 0) {
+        append_file(path_, archive_path);
+        ::unlink(path_.c_str());
+      } else if (std::rename(path_.c_str(), archive_path.c_str()) != 0) {
+        syncing_ = false;
+        throw std::runtime_error("Cannot rotate WAL segment: " + path_);
+      }
+      open_for_append(0);
+      durable_lsn_ = written_lsn_.load();
+    }
+    syncing_ = false;
+    sync_cv_.notify_all();
+  }
+
+  // Sync and close; throws if the final sync fails (the fd is closed)
+  void close() {
+    stop_periodic();
+    if (fd_ < 0)
+      return;
+    struct Closer {
+      int &fd;
+      ~Closer() {
+        ::close(fd);
+        fd = -1;
+      }
+    } closer{fd_};
+    sync_fd();
+  }
+
+  // Bytes in the active segment (drives checkpoint scheduling)
+  std::size_t segment_bytes() const { return segment_bytes_.load(); }
+  uint64_t written_lsn() const { return written_lsn_.load(); }
+  uint64_t durable_lsn() const {
+    std::lock_guard<std::mutex> lk(sync_mutex_);
+    return durable_lsn_;
+  }
+  std::size_t fsync_count() const { return fsyncs_.load(); }
+  bool failed() const { return failed_.load(); }
+  const WALOptions &options() const { return opts_; }
+  const std::string &path() const { return path_; }
+
+  // Iterate intact frames of any log file. Stops at the first short or
+  // corrupt frame; `valid_bytes` receives the length of the intact prefix.
+  static std::size_t
+  replay_file(const std::string &path,
+              const std::function<void(const char *, std::size_t)> &fn,
+              std::size_t *valid_bytes = nullptr) {
+    if (valid_bytes)
+      *valid_bytes = 0;
+    std::ifstream f(path, std::ios::binary);
+    if (!f.is_open())
+      return 0;
+    std::string buf((std::istreambuf_iterator<char>(f)),
+                    std::istreambuf_iterator<char>());
+    std::size_t pos = 0, frames = 0;
+    while (pos + FRAME_HEADER <= buf.size()) {
+      uint32_t len = 0, sum = 0;
+      std::memcpy(&len, buf.data() + pos, sizeof(len));
+      std::memcpy(&sum, buf.data() + pos + sizeof(len), sizeof(sum));
+      if (pos + FRAME_HEADER + len > buf.size())
+        break; // torn write
+      const char *payload = buf.data() + pos + FRAME_HEADER;
+      if (checksum(payload, len) != sum)
+        break; // corrupt tail
+      fn(payload, len);
+      pos += FRAME_HEADER + len;
+      frames++;
+    }
+    if (valid_bytes)
+      *valid_bytes = pos;
+    return frames;
+  }
+
+  // FNV-1a — cheap integrity check for torn/partial frames
+  static uint32_t checksum(const char *data, std::size_t len) {
+    uint32_t h = 2166136261u;
+    for (std::size_t i = 0; i < len; ++i) {
+      h ^= static_cast<unsigned char>(data[i]);
+      h *= 16777619u;
+    }
+    return h;
+  }
+
+private:
+  static void encode_frame(std::string &out, const std::string &payload) {
+    uint32_t len = static_cast<uint32_t>(payload.size());
+    uint32_t sum = checksum(payload.data(), payload.size());
+    out.append(reinterpret_cast<const char *>(&len), sizeof(len));
+    out.append(reinterpret_cast<const char *>(&sum), sizeof(sum));
+    out.append(payload);
+  }
+
+  void open_for_append(std::size_t valid_bytes) {
+    fd_ = ::open(path_.c_str(), O_WRONLY | O_CREAT, 0644);
+    if (fd_ < 0)
+      throw std::runtime_error("Cannot open WAL for writing: " + path_);
+    // Drop a torn tail so new frames are not appended after garbage
+    if (::ftruncate(fd_, static_cast<off_t>(valid_bytes)) != 0 ||
+        ::lseek(fd_, 0, SEEK_END) < 0)
+      throw std::runtime_error("Cannot prepare WAL: " + path_);
+    segment_bytes_ = valid_bytes;
+    start_periodic();
+  }
+
+  void write_all(const char *data, std::size_t len) {
+    while (len > 0) {
+      ssize_t n = ::write(fd_, data, len);
+      if (n < 0) {
+        if (errno == EINTR)
+          continue;
+        throw std::runtime_error("WAL write failed: " + path_);
+      }
+      data += n;
+      len -= static_cast<std::size_t>(n);
+    }
+  }
+
+  void check_usable() const {
+    if (failed_)
+      throw std::runtime_error("WAL failed earlier, not usable: " + path_);
+  }
+
+  // An fsync error is not retried: the kernel may already have dropped the
+  // dirty pages, so a later success would prove nothing. The log fails.
+  void sync_fd() {
+    check_usable();
+#if defined(__linux__)
+    int rc = ::fdatasync(fd_);
+#else
+    int rc = ::fsync(fd_);
+#endif
+    fsyncs_++;
+    if (rc != 0) {
+      failed_ = true;
+      throw std::runtime_error("WAL fsync failed: " + path_);
+    }
+  }
+
+  // Caller holds sync_mutex_ and no sync is running. On error durable_lsn_
+  // stays put and the waiters are woken to find the log failed.
+  void lead_sync(std::unique_lock<std::mutex> &lk) {
+    syncing_ = true;
+    uint64_t target = written_lsn_.load();
+    lk.unlock();
+    try {
+      sync_fd();
+    } catch (...) {
+      lk.lock();
+      syncing_ = false;
+      sync_cv_.notify_all();
+      throw;
+    }
+    lk.lock();
+    if (target > durable_lsn_)
+      durable_lsn_ = target;
+    syncing_ = false;
+    sync_cv_.notify_all();
+  }
+
+  void start_periodic() {
+    if (opts_.policy != SyncPolicy::PERIODIC || periodic_.joinable())
+      return;
+    stop_ = false;
+    periodic_ = std::thread([this] {
+      std::unique_lock<std::mutex> lk(sync_mutex_);
+      while (!stop_) {
+        sync_cv_.wait_for(lk, opts_.sync_interval);
+        if (stop_)
+          break;
+        if (!syncing_ && durable_lsn_ < written_lsn_.load()) {
+          try {
+            lead_sync(lk);
+          } catch (const std::exception &) {
+            break; // failed; appends throw from now on
+          }
+        }
+      }
+    });
+  }
+
+  void stop_periodic() {
+    if (!periodic_.joinable())
+      return;
+    {
+      std::lock_guard<std::mutex> lk(sync_mutex_);
+      stop_ = true;
+    }
+    sync_cv_.notify_all();
+    periodic_.join();
+  }
+
+  static void append_file(const std::string &from, const std::string &to) {
+    std::ifstream in(from, std::ios::binary);
+    std::ofstream out(to, std::ios::binary | std::ios::app);
+    if (!out.is_open())
+      throw std::runtime_error("Cannot append WAL segment to: " + to);
+    out << in.rdbuf();
+  }
+
+  std::string path_;
+  WALOptions opts_;
+  int fd_ = -1;
+
+  std::mutex append_mutex_;
+  std::atomic<uint64_t> written_lsn_{0};
+  std::atomic<std::size_t> segment_bytes_{0};
+  std::atomic<std::size_t> fsyncs_{0};
+  std::atomic<bool> failed_{false};
+
+  mutable std::mutex sync_mutex_;
+  std::condition_variable sync_cv_;
+  uint64_t durable_lsn_ = 0;
+  bool syncing_ = false;
+
+  std::thread periodic_;
+  bool stop_ = false;
+};
+
+} // namespace billing::core
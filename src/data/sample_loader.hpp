@@ -29,49 +29,50 @@ public:
                            int target_invoices = 500) {
     std::cout << "Loading sample data...\n";
 
-    int customers_created = 0;
-    int invoices_created = 0;
+    // Generate customers — committed as one batch
+    std::vector<service::CustomerCreateRequest> customer_reqs;
+    customer_reqs.reserve(target_customers);
+    for (int i = 0; i < target_customers; ++i)
+      customer_reqs.push_back(generate_customer(i));
+    auto customers = cust_svc_.create_many(customer_reqs);
+    int customers_created = static_cast<int>(customers.size());
+    std::cout << "  Created " << customers_created << " customers...\n";
 
-    // Generate customers
     std::vector<int64_t> customer_ids;
-    for (int i = 0; i < target_customers; ++i) {
-      try {
-        auto c = generate_customer(i);
-        customer_ids.push_back(c.id);
-        customers_created++;
-        if (customers_created % 10 == 0)
-          std::cout << "  Created " << customers_created << " customers...\n";
-      } catch (...) { /* skip duplicates */
+    customer_ids.reserve(customers.size());
+    for (auto &c : customers)
+      customer_ids.push_back(c.id);
+
+    // Generate invoice requests, then price + persist them in one batch
+    std::vector<service::InvoiceRequest> invoice_reqs;
+    if (!customer_ids.empty()) {
+      int per_customer =
+          target_invoices / static_cast<int>(customer_ids.size());
+      if (per_customer < 1)
+        per_customer = 1;
+
+      for (auto cid : customer_ids) {
+        int count = std::uniform_int_distribution<>(per_customer,
+                                                    per_customer + 3)(rng_);
+        for (int j = 0; j < count &&
+                        static_cast<int>(invoice_reqs.size()) < target_invoices;
+             ++j)
+          invoice_reqs.push_back(generate_invoice(cid));
       }
-    }
 
-    // Generate invoices in batches
-    int per_customer = target_invoices / static_cast<int>(customer_ids.size());
-    if (per_customer < 1)
-      per_customer = 1;
-
-    for (auto cid : customer_ids) {
-      int count =
-          std::uniform_int_distribution<>(per_customer, per_customer + 3)(rng_);
-      for (int j = 0; j < count && invoices_created < target_invoices; ++j) {
-        try {
-          generate_invoice(cid);
-          invoices_created++;
-        } catch (...) { /* skip */
-        }
+      // Ensure we have at least target_invoices
+      while (static_cast<int>(invoice_reqs.size()) < target_invoices) {
+        int64_t cid = customer_ids[invoice_reqs.size() % customer_ids.size()];
+        invoice_reqs.push_back(generate_invoice(cid));
       }
     }
 
-    // Ensure we have at least target_invoices
-    while (invoices_created < target_invoices && !customer_ids.empty()) {
-      int64_t cid = customer_ids[invoices_created % customer_ids.size()];
-      try {
-        generate_invoice(cid);
-        invoices_created++;
-      } catch (...) {
-        break;
-      }
-    }
+    auto batch = billing_eng_.batch_create(invoice_reqs);
+    int invoices_created = static_cast<int>(batch.invoices.size());
+    if (!batch.failures.empty())
+      std::cerr << "Skipped " << batch.failures.size()
+                << " invoice requests (first: #" << batch.failures[0].index
+                << ", " << batch.failures[0].reason << ")\n";
 
     std::cout << "Sample data loaded: " << customers_created << " customers, "
               << invoices_created << " invoices.\n";
@@ -79,7 +80,7 @@ public:
   }
 
 private:
-  models::Customer generate_customer(int idx) {
+  service::CustomerCreateRequest generate_customer(int idx) {
     static const std::vector<std::string> first_names = {
         "James",     "Emma",      "Liam",    "Olivia",  "Noah",
         "Ava",       "William",   "Sophia",  "Mason",   "Isabella",
@@ -123,17 +124,10 @@ private:
     req.country = loc.first;
     req.state = loc.second;
 
-    auto c = cust_svc_.create(req);
-
-    // Randomize some attributes to make data varied
-    // Adjust credit score
-    std::uniform_int_distribution<> score_dist(400, 820);
-    // This is done via direct access (sample data only)
-    // In production, use the service method
-    return c;
+    return req;
   }
 
-  void generate_invoice(int64_t customer_id) {
+  service::InvoiceRequest generate_invoice(int64_t customer_id) {
     std::uniform_int_distribution<> type_dist(0, 2);
     std::uniform_int_distribution<> item_dist(1, 4);
     std::uniform_real_distribution<> price_dist(50.0, 2000.0);
@@ -187,7 +181,7 @@ private:
       req.line_items.push_back(li);
     }
 
-    billing_eng_.create_invoice(req);
+    return req;
   }
 
   service::CustomerService &cust_svc_;
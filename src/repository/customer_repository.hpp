@@ -2,11 +2,19 @@
 // =============================================================================
 // customer_repository.hpp — File-based Customer Persistence
 // Binary serialization with B+ Tree indexing + LRU Cache
+// The snapshot is memory-mapped and records are decoded on first access
+// Unique email index: case-normalized email -> id, enforced on every write
 // =============================================================================
 #include "../core/bplus_tree.hpp"
+#include "../core/deep_size.hpp"
 #include "../core/lru_cache.hpp"
 #include "../models/customer.hpp"
+#include "snapshot.hpp"
+#include "write_batch.hpp"
+#include <algorithm>
+#include <cctype>
 #include <fstream>
+#include <memory>
 #include <mutex>
 #include <optional>
 #include <stdexcept>
@@ -16,77 +24,226 @@
 
 namespace billing::repository {
 
-class CustomerRepository {
+// Snapshot codec — fixed-width customer header, strings in the heap
+struct CustomerCodec {
+  using Model = models::Customer;
+  static constexpr uint32_t KIND = 1;
+
+  struct Record {
+    int64_t id;
+    snapshot::HeapRef name;
+    snapshot::HeapRef email;
+    snapshot::HeapRef phone;
+    snapshot::HeapRef address;
+    snapshot::HeapRef country;
+    snapshot::HeapRef state;
+    models::CustomerTier tier;
+    models::CustomerStatus status;
+    int32_t credit_score;
+    int32_t reserved;
+    double credit_limit;
+    double current_balance;
+    double total_spent;
+    int64_t created_at;
+    int64_t updated_at;
+  };
+
+  static Record encode(const Model &c, snapshot::HeapWriter &heap) {
+    Record r{};
+    r.id = c.id;
+    r.name = heap.add(c.name);
+    r.email = heap.add(c.email);
+    r.phone = heap.add(c.phone);
+    r.address = heap.add(c.address);
+    r.country = heap.add(c.country);
+    r.state = heap.add(c.state);
+    r.tier = c.tier;
+    r.status = c.status;
+    r.credit_score = c.credit_score;
+    r.credit_limit = c.credit_limit;
+    r.current_balance = c.current_balance;
+    r.total_spent = c.total_spent;
+    r.created_at = c.created_at;
+    r.updated_at = c.updated_at;
+    return r;
+  }
+
+  static Model decode(const Record &r, const char *heap) {
+    Model c{};
+    c.id = r.id;
+    c.name = snapshot::str(heap, r.name);
+    c.email = snapshot::str(heap, r.email);
+    c.phone = snapshot::str(heap, r.phone);
+    c.address = snapshot::str(heap, r.address);
+    c.country = snapshot::str(heap, r.country);
+    c.state = snapshot::str(heap, r.state);
+    c.tier = r.tier;
+    c.status = r.status;
+    c.credit_score = r.credit_score;
+    c.credit_limit = r.credit_limit;
+    c.current_balance = r.current_balance;
+    c.total_spent = r.total_spent;
+    c.created_at = r.created_at;
+    c.updated_at = r.updated_at;
+    return c;
+  }
+
+  static Record rebase(const Record &src, const char *from,
+                       snapshot::HeapWriter &heap) {
+    Record r = src;
+    for (snapshot::HeapRef Record::*ref :
+         {&Record::name, &Record::email, &Record::phone, &Record::address,
+          &Record::country, &Record::state})
+      r.*ref = heap.add(snapshot::view(from, src.*ref));
+    return r;
+  }
+};
+
+// Cached records are immutable and shared: a hit hands out another reference
+// instead of copying the customer's strings
+using CustomerPtr = std::shared_ptr<const models::Customer>;
+
+// Cache: core::LRUCache or a drop-in such as core::ShardedLRUCache
+template <typename Cache = core::LRUCache<int64_t, CustomerPtr>>
+class BasicCustomerRepository {
 public:
-  explicit CustomerRepository(const std::string &data_dir)
-      : data_file_(data_dir + "/customers.bin"), index_(/* B+ Tree order 4 */),
+  using record_type = models::Customer;
+
+  explicit BasicCustomerRepository(const std::string &data_dir)
+      : data_file_(data_dir + "/customers.bin"), index_(/* B+ Tree order 64 */),
         cache_(256) {
     load_all();
   }
 
-  // Create — O(log n) index insert
+  // Create — O(log n) index insert; throws if another customer already
+  // holds the email (case-insensitive)
   void save(const models::Customer &customer) {
     std::lock_guard<std::mutex> lock(mutex_);
-    store_[customer.id] = customer;
-    index_.insert(customer.id, customer.id);
-    cache_.put(customer.id, customer);
+    check_email_free(normalize_email(customer.email), customer.id);
+    if (!store_.contains(customer.id))
+      index_.insert(customer.id, customer.id);
+    reindex_email(customer);
+    store_.put(customer);
+    cache_.put(customer.id, std::make_shared<const models::Customer>(customer));
     flush();
   }
 
-  // Read by ID — O(1) cache, O(log n) fallback
-  std::optional<models::Customer> find_by_id(int64_t id) {
-    // Try cache first
-    auto cached = cache_.get(id);
-    if (cached)
-      return cached;
-    // Fallback to index + store
+  // Read by ID without copying — O(1) cache hit (a refcount bump), O(log n)
+  // fallback. The record is immutable; later updates replace it rather
+  // than change it, so the pointer stays valid. nullptr if absent.
+  CustomerPtr find_shared(int64_t id) {
+    if (auto cached = cache_.get(id))
+      return std::move(*cached);
+    // Fallback to the store (decodes from the mapped snapshot)
     std::lock_guard<std::mutex> lock(mutex_);
-    auto it = store_.find(id);
-    if (it == store_.end())
+    auto c = store_.get(id);
+    if (!c)
+      return nullptr;
+    auto ptr = std::make_shared<const models::Customer>(std::move(*c));
+    cache_.put(id, ptr);
+    return ptr;
+  }
+
+  // Read by ID as a private copy the caller may edit
+  std::optional<models::Customer> find_by_id(int64_t id) {
+    auto c = find_shared(id);
+    if (!c)
       return std::nullopt;
-    cache_.put(id, it->second);
-    return it->second;
+    return *c;
   }
 
-  // Find by email — O(n) linear scan (in production: secondary index)
+  // Find by email — O(1) hash index, case-insensitive
   std::optional<models::Customer> find_by_email(const std::string &email) {
     std::lock_guard<std::mutex> lock(mutex_);
-    for (auto &[id, c] : store_)
-      if (c.email == email)
-        return c;
-    return std::nullopt;
+    auto it = by_email_.find(normalize_email(email));
+    if (it == by_email_.end())
+      return std::nullopt;
+    return store_.get(it->second);
+  }
+
+  bool email_taken(const std::string &email) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return by_email_.count(normalize_email(email)) > 0;
   }
 
-  // Update — O(log n)
+  // Update — O(log n); throws if the new email belongs to another customer
   bool update(const models::Customer &customer) {
     std::lock_guard<std::mutex> lock(mutex_);
-    if (store_.find(customer.id) == store_.end())
+    if (!store_.contains(customer.id))
       return false;
-    store_[customer.id] = customer;
-    index_.update(customer.id, customer.id);
-    cache_.put(customer.id, customer);
-    flush();
+    update_locked(customer);
+    return true;
+  }
+
+  // Copy-on-write update: `fn(models::Customer &)` edits a copy of the
+  // current record, which then replaces it atomically with respect to other
+  // writers. Readers still holding the old pointer keep the old version.
+  // False if the id is unknown; if fn throws nothing is changed.
+  template <typename Fn> bool modify(int64_t id, Fn &&fn) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto c = store_.get(id);
+    if (!c)
+      return false;
+    fn(*c);
+    c->id = id;
+    update_locked(*c);
     return true;
   }
 
   // Delete — O(log n)
   bool remove(int64_t id) {
     std::lock_guard<std::mutex> lock(mutex_);
-    if (store_.erase(id) == 0)
+    if (!store_.contains(id))
       return false;
+    unindex_email(id);
+    store_.erase(id);
     index_.remove(id);
     cache_.evict(id);
     flush();
     return true;
   }
 
+  // Apply a staged batch under one lock with a single flush — O(k + n).
+  // Email uniqueness is checked for the whole batch before anything is
+  // applied, so a conflicting batch throws and changes nothing.
+  std::size_t apply(const std::vector<WriteOp<models::Customer>> &ops) {
+    if (ops.empty())
+      return 0;
+    std::lock_guard<std::mutex> lock(mutex_);
+    check_batch_emails(ops);
+    std::size_t applied = 0;
+    for (const auto &op : ops) {
+      bool exists = store_.contains(op.id);
+      if (op.kind == WriteKind::REMOVE) {
+        if (!exists)
+          continue;
+        unindex_email(op.id);
+        store_.erase(op.id);
+        index_.remove(op.id);
+        cache_.evict(op.id);
+      } else {
+        if (!exists) {
+          if (op.kind == WriteKind::UPDATE)
+            continue;
+          index_.insert(op.id, op.id);
+        }
+        reindex_email(op.record);
+        store_.put(op.record);
+        cache_.put(op.id, std::make_shared<const models::Customer>(op.record));
+      }
+      applied++;
+    }
+    if (applied)
+      flush();
+    return applied;
+  }
+
   // Get all customers — O(n)
   std::vector<models::Customer> find_all() const {
     std::lock_guard<std::mutex> lock(mutex_);
     std::vector<models::Customer> result;
     result.reserve(store_.size());
-    for (auto &[id, c] : store_)
-      result.push_back(c);
+    store_.for_each([&](const models::Customer &c) { result.push_back(c); });
     return result;
   }
 
@@ -96,9 +253,9 @@ public:
     std::vector<models::Customer> result;
     std::lock_guard<std::mutex> lock(mutex_);
     for (auto &[id, _] : ids) {
-      auto it = store_.find(id);
-      if (it != store_.end())
-        result.push_back(it->second);
+      auto c = store_.get(id);
+      if (c)
+        result.push_back(std::move(*c));
     }
     return result;
   }
@@ -106,11 +263,7 @@ public:
   // Find by tier — O(n)
   std::vector<models::Customer> find_by_tier(models::CustomerTier tier) const {
     std::lock_guard<std::mutex> lock(mutex_);
-    std::vector<models::Customer> result;
-    for (auto &[id, c] : store_)
-      if (c.tier == tier)
-        result.push_back(c);
-    return result;
+    return store_.select([&](const auto &c) { return c.tier == tier; });
   }
 
   std::size_t count() const {
@@ -120,37 +273,162 @@ public:
 
   double cache_hit_rate() const { return cache_.hit_rate(); }
 
+  // Bound the record cache by memory instead of entry count; entries are
+  // charged cached_bytes(). Needs a Cache with set_byte_budget (LRUCache).
+  void set_cache_byte_budget(std::size_t max_bytes) {
+    cache_.set_byte_budget(max_bytes, &cached_bytes);
+  }
+  std::size_t cache_bytes() const { return cache_.bytes(); }
+
+  // Approximate memory held by one cached customer
+  static std::size_t cached_bytes(const int64_t &, const CustomerPtr &p) {
+    const models::Customer &c = *p;
+    return core::heap_bytes_of(p, c.name, c.email, c.phone, c.address,
+                               c.country, c.state);
+  }
+
+  // Index key for an email: surrounding whitespace trimmed, ASCII lowercase
+  static std::string normalize_email(const std::string &email) {
+    auto first = email.find_first_not_of(" \t\r\n");
+    if (first == std::string::npos)
+      return {};
+    auto last = email.find_last_not_of(" \t\r\n");
+    std::string key = email.substr(first, last - first + 1);
+    for (char &ch : key)
+      ch = static_cast<char>(std::tolower(static_cast<unsigned char>(ch)));
+    return key;
+  }
+
 private:
-  void load_all() {
-    std::ifstream f(data_file_, std::ios::binary);
-    if (!f.is_open())
-      return; // file doesn't exist yet
-    std::size_t count = 0;
-    f.read(reinterpret_cast<char *>(&count), sizeof(count));
-    for (std::size_t i = 0; i < count; ++i) {
-      models::Customer c;
-      read_customer(f, c);
-      store_[c.id] = c;
-      index_.insert(c.id, c.id);
-    }
+  // Replace an existing record (caller holds mutex_); throws before
+  // changing anything if the new email belongs to another customer
+  void update_locked(const models::Customer &customer) {
+    check_email_free(normalize_email(customer.email), customer.id);
+    reindex_email(customer);
+    store_.put(customer);
+    index_.update(customer.id, customer.id);
+    cache_.put(customer.id, std::make_shared<const models::Customer>(customer));
+    flush();
+  }
+
+  // --- Email index (caller holds mutex_) ------------------------------------
+  void check_email_free(const std::string &key, int64_t id) const {
+    if (key.empty())
+      return;
+    auto it = by_email_.find(key);
+    if (it != by_email_.end() && it->second != id)
+      throw std::runtime_error("Email already registered: " + key);
   }
 
-  void flush() {
-    std::ofstream f(data_file_, std::ios::binary | std::ios::trunc);
-    if (!f.is_open())
-      throw std::runtime_error("Cannot open customer data file for writing");
-    std::size_t count = store_.size();
-    f.write(reinterpret_cast<const char *>(&count), sizeof(count));
-    for (auto &[id, c] : store_)
-      write_customer(f, c);
+  // Normalized email currently stored for `id` (empty if none)
+  std::string stored_email_key(int64_t id) const {
+    std::string key;
+    store_.peek(id, [&](const auto &c) { key = normalize_email(email_of(c)); });
+    return key;
   }
 
-  static void write_string(std::ofstream &f, const std::string &s) {
-    std::size_t len = s.size();
-    f.write(reinterpret_cast<const char *>(&len), sizeof(len));
-    f.write(s.data(), static_cast<std::streamsize>(len));
+  std::string email_of(const models::Customer &c) const { return c.email; }
+  std::string email_of(const CustomerCodec::Record &r) const {
+    return snapshot::str(store_.heap(), r.email);
   }
 
+  void reindex_email(const models::Customer &c) {
+    std::string key = normalize_email(c.email);
+    std::string old = stored_email_key(c.id);
+    if (old == key)
+      return;
+    release_email(old, c.id);
+    if (!key.empty())
+      by_email_[key] = c.id;
+  }
+
+  void unindex_email(int64_t id) { release_email(stored_email_key(id), id); }
+
+  // Drop `key` only if `id` owns it: a duplicate that lost to the first
+  // owner when the index was built must not take the owner's entry along
+  void release_email(const std::string &key, int64_t id) {
+    auto it = by_email_.find(key);
+    if (it != by_email_.end() && it->second == id)
+      by_email_.erase(it);
+  }
+
+  // Replay the batch's email changes against a scratch view of the index
+  void check_batch_emails(const std::vector<WriteOp<models::Customer>> &ops) {
+    // email -> claiming id (0 = released); id -> email (nullopt = removed)
+    std::unordered_map<std::string, int64_t> claims;
+    std::unordered_map<int64_t, std::optional<std::string>> seen;
+    auto exists = [&](int64_t id) {
+      auto it = seen.find(id);
+      return it != seen.end() ? it->second.has_value() : store_.contains(id);
+    };
+    auto key_of = [&](int64_t id) -> std::string {
+      auto it = seen.find(id);
+      if (it != seen.end())
+        return it->second.value_or("");
+      return stored_email_key(id);
+    };
+    auto owner_of = [&](const std::string &key) -> int64_t {
+      auto it = claims.find(key);
+      if (it != claims.end())
+        return it->second;
+      auto idx = by_email_.find(key);
+      return idx != by_email_.end() ? idx->second : 0;
+    };
+    for (const auto &op : ops) {
+      if (op.kind != WriteKind::SAVE && !exists(op.id))
+        continue;
+      std::string old = key_of(op.id);
+      if (!old.empty() && owner_of(old) == op.id)
+        claims[old] = 0;
+      if (op.kind == WriteKind::REMOVE) {
+        seen[op.id] = std::nullopt;
+        continue;
+      }
+      std::string key = normalize_email(op.record.email);
+      if (!key.empty()) {
+        int64_t owner = owner_of(key);
+        if (owner != 0 && owner != op.id)
+          throw std::runtime_error("Email already registered: " + key);
+        claims[key] = op.id;
+      }
+      seen[op.id] = key;
+    }
+  }
+
+  void load_all() {
+    if (!store_.open(data_file_)) {
+      std::ifstream f(data_file_, std::ios::binary);
+      if (!f.is_open())
+        return; // file doesn't exist yet
+      // Legacy stream format: read once, rewrite as a mapped snapshot
+      std::size_t count = 0;
+      f.read(reinterpret_cast<char *>(&count), sizeof(count));
+      for (std::size_t i = 0; i < count && f; ++i) {
+        models::Customer c;
+        read_customer(f, c);
+        store_.put(c);
+      }
+      f.close();
+      flush();
+    }
+    // Collect ids, sort once, then build the id index bottom-up
+    std::vector<std::pair<int64_t, int64_t>> ids;
+    ids.reserve(store_.size());
+    auto build = [&](const auto &c) {
+      ids.emplace_back(c.id, c.id);
+      std::string key = normalize_email(email_of(c));
+      if (!key.empty())
+        by_email_.emplace(key, c.id); // pre-index duplicates: first wins
+    };
+    store_.for_each_overlay(build);
+    store_.for_each_snapshot_record(build);
+    std::sort(ids.begin(), ids.end());
+    index_.bulk_load(ids.begin(), ids.end());
+  }
+
+  // Merge the overlay into a new snapshot (temp file + rename) and remap it
+  void flush() { store_.checkpoint(data_file_); }
+
   static void read_string(std::ifstream &f, std::string &s) {
     std::size_t len = 0;
     f.read(reinterpret_cast<char *>(&len), sizeof(len));
@@ -158,31 +436,7 @@ private:
     f.read(s.data(), static_cast<std::streamsize>(len));
   }
 
-  void write_customer(std::ofstream &f, const models::Customer &c) {
-    f.write(reinterpret_cast<const char *>(&c.id), sizeof(c.id));
-    write_string(f, c.name);
-    write_string(f, c.email);
-    write_string(f, c.phone);
-    write_string(f, c.address);
-    write_string(f, c.country);
-    write_string(f, c.state);
-    f.write(reinterpret_cast<const char *>(&c.tier), sizeof(c.tier));
-    f.write(reinterpret_cast<const char *>(&c.status), sizeof(c.status));
-    f.write(reinterpret_cast<const char *>(&c.credit_score),
-            sizeof(c.credit_score));
-    f.write(reinterpret_cast<const char *>(&c.credit_limit),
-            sizeof(c.credit_limit));
-    f.write(reinterpret_cast<const char *>(&c.current_balance),
-            sizeof(c.current_balance));
-    f.write(reinterpret_cast<const char *>(&c.total_spent),
-            sizeof(c.total_spent));
-    f.write(reinterpret_cast<const char *>(&c.created_at),
-            sizeof(c.created_at));
-    f.write(reinterpret_cast<const char *>(&c.updated_at),
-            sizeof(c.updated_at));
-  }
-
-  void read_customer(std::ifstream &f, models::Customer &c) {
+  static void read_customer(std::ifstream &f, models::Customer &c) {
     f.read(reinterpret_cast<char *>(&c.id), sizeof(c.id));
     read_string(f, c.name);
     read_string(f, c.email);
@@ -202,10 +456,13 @@ private:
   }
 
   std::string data_file_;
-  std::unordered_map<int64_t, models::Customer> store_;
+  RecordStore<CustomerCodec> store_;
   core::BPlusTree<int64_t, int64_t> index_;
-  mutable core::LRUCache<int64_t, models::Customer> cache_;
+  std::unordered_map<std::string, int64_t> by_email_; // normalized -> id
+  mutable Cache cache_;
   mutable std::mutex mutex_;
 };
 
+using CustomerRepository = BasicCustomerRepository<>;
+
 } // namespace billing::repository
@@ -2,124 +2,716 @@
 // =============================================================================
 // invoice_repository.hpp — File-based Invoice Persistence
 // Binary serialization with B+ Tree indexing + LRU Cache
+// Durability: snapshot (invoices.bin) + write-ahead log (invoices.wal);
+// mutations append one record, a background checkpoint compacts the log.
+// The snapshot is memory-mapped and records are decoded on first access.
+// Secondary indexes: customer_id, status, due_date over open invoices, and
+// next_billing_date over scheduled recurring invoices
 // =============================================================================
 #include "../core/bplus_tree.hpp"
+#include "../core/deep_size.hpp"
 #include "../core/lru_cache.hpp"
+#include "../core/write_ahead_log.hpp"
 #include "../models/invoice.hpp"
+#include "snapshot.hpp"
+#include "write_batch.hpp"
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <deque>
 #include <fstream>
+#include <limits>
+#include <memory>
+#include <memory_resource>
 #include <mutex>
 #include <optional>
+#include <sstream>
 #include <stdexcept>
 #include <string>
+#include <thread>
 #include <unordered_map>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
 namespace billing::repository {
 
-class InvoiceRepository {
+// -----------------------------------------------------------------------------
+// Snapshot codec — fixed-width invoice header, strings and line items in heap
+// -----------------------------------------------------------------------------
+struct InvoiceCodec {
+  using Model = models::Invoice;
+  static constexpr uint32_t KIND = 2;
+
+  struct LineItemRecord {
+    snapshot::HeapRef description;
+    int32_t quantity;
+    int32_t reserved;
+    double unit_price;
+  };
+
+  struct Record {
+    int64_t id;
+    int64_t customer_id;
+    int64_t parent_invoice_id;
+    snapshot::HeapRef invoice_number;
+    snapshot::HeapRef line_items; // LineItemRecord[size]
+    snapshot::HeapRef currency;
+    snapshot::HeapRef jurisdiction;
+    snapshot::HeapRef notes;
+    models::InvoiceType type;
+    models::RecurringPeriod period;
+    models::InvoiceStatus status;
+    int32_t reserved;
+    double subtotal;
+    double discount_amount;
+    double tax_amount;
+    double total_amount;
+    double amount_paid;
+    int64_t issue_date;
+    int64_t due_date;
+    int64_t paid_date;
+    int64_t next_billing_date;
+    int64_t period_start;
+    int64_t period_end;
+  };
+
+  static Record encode(const Model &inv, snapshot::HeapWriter &heap) {
+    std::vector<LineItemRecord> items;
+    items.reserve(inv.line_items.size());
+    for (auto &li : inv.line_items)
+      items.push_back({heap.add(li.description), li.quantity, 0,
+                       li.unit_price});
+    Record r = header(inv);
+    r.invoice_number = heap.add(inv.invoice_number);
+    r.line_items = heap.add_array(items.data(), items.size());
+    r.currency = heap.add(inv.currency);
+    r.jurisdiction = heap.add(inv.jurisdiction);
+    r.notes = heap.add(inv.notes);
+    return r;
+  }
+
+  static Model decode(const Record &r, const char *heap) {
+    Model inv{};
+    inv.id = r.id;
+    inv.customer_id = r.customer_id;
+    inv.parent_invoice_id = r.parent_invoice_id;
+    inv.invoice_number = snapshot::str(heap, r.invoice_number);
+    inv.type = r.type;
+    inv.period = r.period;
+    inv.status = r.status;
+    auto *items = snapshot::array<LineItemRecord>(heap, r.line_items);
+    inv.line_items.reserve(r.line_items.size);
+    for (uint64_t i = 0; i < r.line_items.size; ++i)
+      inv.line_items.push_back({snapshot::str(heap, items[i].description),
+                                items[i].quantity, items[i].unit_price});
+    inv.subtotal = r.subtotal;
+    inv.discount_amount = r.discount_amount;
+    inv.tax_amount = r.tax_amount;
+    inv.total_amount = r.total_amount;
+    inv.amount_paid = r.amount_paid;
+    inv.currency = snapshot::str(heap, r.currency);
+    inv.jurisdiction = snapshot::str(heap, r.jurisdiction);
+    inv.notes = snapshot::str(heap, r.notes);
+    inv.issue_date = r.issue_date;
+    inv.due_date = r.due_date;
+    inv.paid_date = r.paid_date;
+    inv.next_billing_date = r.next_billing_date;
+    inv.period_start = r.period_start;
+    inv.period_end = r.period_end;
+    return inv;
+  }
+
+  // Copy a record between snapshots without materializing it
+  static Record rebase(const Record &src, const char *from,
+                       snapshot::HeapWriter &heap) {
+    auto *old_items = snapshot::array<LineItemRecord>(from, src.line_items);
+    std::vector<LineItemRecord> items(old_items,
+                                      old_items + src.line_items.size);
+    for (auto &li : items)
+      li.description = heap.add(snapshot::view(from, li.description));
+    Record r = src;
+    r.invoice_number = heap.add(snapshot::view(from, src.invoice_number));
+    r.line_items = heap.add_array(items.data(), items.size());
+    r.currency = heap.add(snapshot::view(from, src.currency));
+    r.jurisdiction = heap.add(snapshot::view(from, src.jurisdiction));
+    r.notes = heap.add(snapshot::view(from, src.notes));
+    return r;
+  }
+
+private:
+  static Record header(const Model &inv) {
+    Record r{};
+    r.id = inv.id;
+    r.customer_id = inv.customer_id;
+    r.parent_invoice_id = inv.parent_invoice_id;
+    r.type = inv.type;
+    r.period = inv.period;
+    r.status = inv.status;
+    r.subtotal = inv.subtotal;
+    r.discount_amount = inv.discount_amount;
+    r.tax_amount = inv.tax_amount;
+    r.total_amount = inv.total_amount;
+    r.amount_paid = inv.amount_paid;
+    r.issue_date = inv.issue_date;
+    r.due_date = inv.due_date;
+    r.paid_date = inv.paid_date;
+    r.next_billing_date = inv.next_billing_date;
+    r.period_start = inv.period_start;
+    r.period_end = inv.period_end;
+    return r;
+  }
+};
+
+// Cached records are immutable and shared: a hit hands out another reference
+// instead of copying the invoice and its line items
+using InvoicePtr = std::shared_ptr<const models::Invoice>;
+
+// Cache: core::LRUCache or a drop-in such as core::ShardedLRUCache
+template <typename Cache = core::LRUCache<int64_t, InvoicePtr>>
+class BasicInvoiceRepository {
 public:
-  explicit InvoiceRepository(const std::string &data_dir)
-      : data_file_(data_dir + "/invoices.bin"), index_(), cache_(512) {
+  using record_type = models::Invoice;
+
+  explicit BasicInvoiceRepository(const std::string &data_dir,
+                             core::WALOptions wal_opts = {})
+      : data_dir_(data_dir), data_file_(data_dir + "/invoices.bin"),
+        archive_file_(data_dir + "/invoices.wal.1"),
+        wal_(data_dir + "/invoices.wal", wal_opts), index_(), cache_(512) {
     load_all();
+    checkpointer_ = std::thread([this] { checkpoint_loop(); });
+  }
+
+  ~BasicInvoiceRepository() {
+    {
+      std::lock_guard<std::mutex> lk(checkpoint_mutex_);
+      stop_ = true;
+    }
+    checkpoint_cv_.notify_all();
+    if (checkpointer_.joinable())
+      checkpointer_.join();
   }
 
+  BasicInvoiceRepository(const BasicInvoiceRepository &) = delete;
+  BasicInvoiceRepository &operator=(const BasicInvoiceRepository &) = delete;
+
+  // Create — O(log n) index inserts + O(record) log append
   void save(const models::Invoice &inv) {
+    uint64_t lsn;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      lsn = put_logged(inv);
+    }
+    wal_.commit(lsn);
+    maybe_checkpoint();
+  }
+
+  // Read by ID without copying — O(1) cache hit (a refcount bump); a miss
+  // decodes the record from the mapped snapshot in O(log n). The record is
+  // immutable; later updates replace it rather than change it, so the
+  // pointer stays valid. nullptr if absent.
+  InvoicePtr find_shared(int64_t id) {
+    if (auto cached = cache_.get(id))
+      return std::move(*cached);
     std::lock_guard<std::mutex> lock(mutex_);
-    store_[inv.id] = inv;
-    index_.insert(inv.id, inv.id);
-    cache_.put(inv.id, inv);
-    flush();
+    auto inv = store_.get(id);
+    if (!inv)
+      return nullptr;
+    auto ptr = std::make_shared<const models::Invoice>(std::move(*inv));
+    cache_.put(id, ptr);
+    return ptr;
   }
 
+  // Read by ID as a private copy the caller may edit
   std::optional<models::Invoice> find_by_id(int64_t id) {
-    auto cached = cache_.get(id);
-    if (cached)
-      return cached;
-    std::lock_guard<std::mutex> lock(mutex_);
-    auto it = store_.find(id);
-    if (it == store_.end())
+    auto inv = find_shared(id);
+    if (!inv)
       return std::nullopt;
-    cache_.put(id, it->second);
-    return it->second;
+    return *inv;
   }
 
   bool update(const models::Invoice &inv) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    if (store_.find(inv.id) == store_.end())
-      return false;
-    store_[inv.id] = inv;
-    cache_.put(inv.id, inv);
-    flush();
+    uint64_t lsn;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (!store_.contains(inv.id))
+        return false;
+      lsn = put_logged(inv);
+    }
+    wal_.commit(lsn);
+    maybe_checkpoint();
     return true;
   }
 
+  // Copy-on-write update: `fn(models::Invoice &)` edits a copy of the
+  // current record, which then replaces it atomically with respect to other
+  // writers. Readers still holding the old pointer keep the old version.
+  // False if the id is unknown; if fn throws nothing is changed.
+  template <typename Fn> bool modify(int64_t id, Fn &&fn) {
+    uint64_t lsn;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      auto inv = store_.get(id);
+      if (!inv)
+        return false;
+      fn(*inv);
+      inv->id = id;
+      lsn = put_logged(*inv);
+    }
+    wal_.commit(lsn);
+    maybe_checkpoint();
+    return true;
+  }
+
+  // modify() over many ids under one lock and one log frame. Each record's
+  // header is read as a Balance without decoding; only those passing
+  // pred(balance) are decoded, edited by fn(models::Invoice &) and replaced.
+  // The frame is appended before memory changes, so a failed append leaves
+  // every record as it was. Returns the new versions in `ids` order —
+  // O(k log n + matches decoded)
+  template <typename Ids, typename Pred, typename Fn>
+  std::vector<models::Invoice> modify_many(const Ids &ids, Pred &&pred,
+                                           Fn &&fn) {
+    std::vector<models::Invoice> changed;
+    uint64_t lsn;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      std::vector<std::string> records;
+      for (int64_t id : ids) {
+        bool match = false;
+        store_.peek(id, [&](const auto &r) { match = pred(balance_of(r)); });
+        if (!match)
+          continue;
+        auto inv = store_.get(id);
+        fn(*inv);
+        inv->id = id;
+        records.push_back(encode_put(*inv));
+        changed.push_back(std::move(*inv));
+      }
+      if (records.empty())
+        return changed;
+      lsn = wal_.append(encode_batch(records));
+      for (const auto &inv : changed) {
+        put_indexed(inv);
+        cache_.put(inv.id, std::make_shared<const models::Invoice>(inv));
+      }
+    }
+    wal_.commit(lsn);
+    maybe_checkpoint();
+    return changed;
+  }
+
   bool remove(int64_t id) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    if (store_.erase(id) == 0)
-      return false;
-    index_.remove(id);
-    cache_.evict(id);
-    flush();
+    uint64_t lsn;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (!store_.contains(id))
+        return false;
+      lsn = wal_.append(encode_erase(id));
+      erase_indexed(id);
+      cache_.evict(id);
+    }
+    wal_.commit(lsn);
+    maybe_checkpoint();
     return true;
   }
 
+  // Apply a staged batch: one lock acquisition and one log frame, so the
+  // whole batch becomes durable (or is lost) together; it is applied only
+  // once the frame is appended, so a failed append shows none of it. MODIFY
+  // edits see the record as earlier ops in the batch left it — O(k)
+  std::size_t apply(const std::vector<WriteOp<models::Invoice>> &ops) {
+    if (ops.empty())
+      return 0;
+    // (id, record it leaves) per op that applies; null means erased
+    std::vector<std::pair<int64_t, const models::Invoice *>> live;
+    std::deque<models::Invoice> edited; // MODIFY results, stable addresses
+    uint64_t lsn;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      // Dry pass: which ops apply, tracking each id through the batch.
+      // Nothing is visible until the frame is appended.
+      std::unordered_map<int64_t, const models::Invoice *> staged;
+      auto exists = [&](int64_t id) {
+        auto it = staged.find(id);
+        return it != staged.end() ? it->second != nullptr
+                                  : store_.contains(id);
+      };
+      std::vector<std::string> records;
+      records.reserve(ops.size());
+      for (const auto &op : ops) {
+        const models::Invoice *rec = &op.record;
+        if (op.kind == WriteKind::REMOVE) {
+          if (!exists(op.id))
+            continue;
+          rec = nullptr;
+          records.push_back(encode_erase(op.id));
+        } else if (op.kind == WriteKind::MODIFY) {
+          if (!exists(op.id))
+            continue;
+          auto it = staged.find(op.id);
+          models::Invoice cur =
+              it != staged.end() ? *it->second : *store_.get(op.id);
+          if (!op.edit(cur))
+            continue;
+          cur.id = op.id;
+          rec = &edited.emplace_back(std::move(cur));
+          records.push_back(encode_put(*rec));
+        } else {
+          if (op.kind == WriteKind::UPDATE && !exists(op.id))
+            continue;
+          records.push_back(encode_put(op.record));
+        }
+        staged[op.id] = rec;
+        live.emplace_back(op.id, rec);
+      }
+      if (records.empty())
+        return 0;
+      lsn = wal_.append(encode_batch(records));
+      for (const auto &[id, rec] : live) {
+        if (!rec) {
+          erase_indexed(id);
+          cache_.evict(id);
+        } else {
+          put_indexed(*rec);
+          cache_.put(id, std::make_shared<const models::Invoice>(*rec));
+        }
+      }
+    }
+    wal_.commit(lsn);
+    maybe_checkpoint();
+    return live.size();
+  }
+
   std::vector<models::Invoice> find_all() const {
     std::lock_guard<std::mutex> lock(mutex_);
     std::vector<models::Invoice> result;
     result.reserve(store_.size());
-    for (auto &[id, inv] : store_)
-      result.push_back(inv);
+    store_.for_each([&](const models::Invoice &inv) { result.push_back(inv); });
     return result;
   }
 
+  // Amounts and dates of one invoice — all an aggregate report needs
+  struct Balance {
+    int64_t id;
+    models::InvoiceStatus status;
+    double total_amount;
+    double amount_paid;
+    std::time_t due_date;
+
+    double amount_due() const { return total_amount - amount_paid; }
+    // Same rules as models::Invoice::is_overdue/days_overdue at `now`
+    bool is_overdue(std::time_t now) const {
+      return status != models::InvoiceStatus::PAID &&
+             status != models::InvoiceStatus::CANCELLED && now > due_date;
+    }
+    int days_overdue(std::time_t now) const {
+      if (!is_overdue(now))
+        return 0;
+      return static_cast<int>(std::difftime(now, due_date) / 86400.0);
+    }
+  };
+
+  // Every invoice as a Balance, in find_all() order, read from record
+  // headers without decoding any strings. The vector is allocated from
+  // `mr` (e.g. a report's scratch arena) — O(n)
+  std::pmr::vector<Balance> balances(
+      std::pmr::memory_resource *mr = std::pmr::get_default_resource()) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::pmr::vector<Balance> result(mr);
+    result.reserve(store_.size());
+    auto add = [&](const auto &r) { result.push_back(balance_of(r)); };
+    store_.for_each_overlay(add);
+    store_.for_each_snapshot_record(add);
+    return result;
+  }
+
+  // Decode the given ids under one lock, skipping any that no longer
+  // exist — O(k log n)
+  template <typename Ids>
+  std::vector<models::Invoice> find_many(const Ids &ids) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<models::Invoice> result;
+    result.reserve(ids.size());
+    for (int64_t id : ids)
+      if (auto inv = store_.get(id))
+        result.push_back(std::move(*inv));
+    return result;
+  }
+
+  // Secondary index lookups — O(log n + k), only matches are decoded
   std::vector<models::Invoice> find_by_customer(int64_t customer_id) const {
     std::lock_guard<std::mutex> lock(mutex_);
+    auto hits = by_customer_.range({customer_id, INT64_MIN},
+                                   {customer_id, INT64_MAX});
     std::vector<models::Invoice> result;
-    for (auto &[id, inv] : store_)
-      if (inv.customer_id == customer_id)
-        result.push_back(inv);
+    result.reserve(hits.size());
+    for (auto &[key, id] : hits)
+      result.push_back(*store_.get(id));
     return result;
   }
 
+  // O(k) over the status bucket
   std::vector<models::Invoice>
   find_by_status(models::InvoiceStatus status) const {
     std::lock_guard<std::mutex> lock(mutex_);
+    const auto &ids = by_status_[static_cast<std::size_t>(status)];
     std::vector<models::Invoice> result;
-    for (auto &[id, inv] : store_)
-      if (inv.status == status)
-        result.push_back(inv);
+    result.reserve(ids.size());
+    for (int64_t id : ids)
+      result.push_back(*store_.get(id));
     return result;
   }
 
+  // Open invoices with due_date < now: one range scan of the due index,
+  // oldest first — O(log n + k)
   std::vector<models::Invoice> find_overdue() const {
+    return find_due_before(std::time(nullptr));
+  }
+
+  std::vector<models::Invoice> find_due_before(std::time_t t) const {
     std::lock_guard<std::mutex> lock(mutex_);
+    constexpr std::time_t earliest = std::numeric_limits<std::time_t>::min();
+    auto hits = due_index_.range({earliest, INT64_MIN}, {t - 1, INT64_MAX});
     std::vector<models::Invoice> result;
-    for (auto &[id, inv] : store_)
-      if (inv.is_overdue())
-        result.push_back(inv);
+    result.reserve(hits.size());
+    for (auto &[key, id] : hits)
+      result.push_back(*store_.get(id));
     return result;
   }
 
+  // Ids of scheduled recurring invoices with next_billing_date <= t, in
+  // billing-date order: one range scan of the billing index — O(log n + k)
+  std::vector<int64_t> billing_due_ids(std::time_t t) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    constexpr std::time_t earliest = std::numeric_limits<std::time_t>::min();
+    auto hits = billing_index_.range({earliest, INT64_MIN}, {t, INT64_MAX});
+    std::vector<int64_t> ids;
+    ids.reserve(hits.size());
+    for (auto &[key, id] : hits)
+      ids.push_back(id);
+    return ids;
+  }
+
+  // Rebuild every secondary index from the store and compare with the
+  // maintained ones — O(n log n), for tests and diagnostics
+  bool verify_indexes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::size_t records = 0, open = 0, scheduled = 0;
+    bool ok = true;
+    auto check = [&](const auto &r) {
+      IndexKeys k = keys_of(r);
+      records++;
+      ok = ok && index_.search(r.id).has_value() &&
+           by_customer_.search({k.customer_id, r.id}).has_value() &&
+           by_status_[static_cast<std::size_t>(k.status)].count(r.id);
+      if (is_open(k.status)) {
+        open++;
+        ok = ok && due_index_.search({k.due_date, r.id}).has_value();
+      }
+      if (k.next_billing) {
+        scheduled++;
+        ok = ok &&
+             billing_index_.search({k.next_billing, r.id}).has_value();
+      }
+    };
+    store_.for_each_overlay(check);
+    store_.for_each_snapshot_record(check);
+    std::size_t by_status = 0;
+    for (const auto &ids : by_status_)
+      by_status += ids.size();
+    return ok && index_.size() == records && by_customer_.size() == records &&
+           by_status == records && due_index_.size() == open &&
+           billing_index_.size() == scheduled;
+  }
+
   std::size_t count() const {
     std::lock_guard<std::mutex> lock(mutex_);
     return store_.size();
   }
 
+  // Directory holding this repository's files, for state kept beside it
+  const std::string &data_dir() const { return data_dir_; }
+
+  // Bound the record cache by memory instead of entry count; entries are
+  // charged cached_bytes(). Needs a Cache with set_byte_budget (LRUCache).
+  void set_cache_byte_budget(std::size_t max_bytes) {
+    cache_.set_byte_budget(max_bytes, &cached_bytes);
+  }
+  std::size_t cache_bytes() const { return cache_.bytes(); }
+
+  // Approximate memory held by one cached invoice — line items and notes
+  // dominate for large invoices
+  static std::size_t cached_bytes(const int64_t &, const InvoicePtr &p) {
+    const models::Invoice &inv = *p;
+    std::size_t n = core::heap_bytes_of(p, inv.line_items);
+    for (const auto &li : inv.line_items)
+      n += core::heap_bytes(li.description);
+    return n + core::heap_bytes_of(inv.invoice_number, inv.currency,
+                                   inv.jurisdiction, inv.notes);
+  }
+
+  // Compact the log into a fresh snapshot. Only the overlay of records
+  // written since the last snapshot is copied under the lock; the merge with
+  // the mapped snapshot is written without blocking writers.
+  void checkpoint() {
+    std::lock_guard<std::mutex> ck(checkpoint_run_mutex_);
+    Store::Frozen frozen;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      frozen = store_.freeze();
+      wal_.rotate(archive_file_);
+    }
+    Store::write(data_file_, frozen);
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      store_.install(data_file_, frozen);
+    }
+    std::remove(archive_file_.c_str());
+    checkpoints_++;
+  }
+
+  std::size_t wal_bytes() const { return wal_.segment_bytes(); }
+  std::size_t checkpoints() const { return checkpoints_; }
+
 private:
-  static void write_string(std::ofstream &f, const std::string &s) {
+  enum class LogOp : char { PUT = 1, ERASE = 2, BATCH = 3 };
+
+  static constexpr std::size_t STATUS_COUNT =
+      static_cast<std::size_t>(models::InvoiceStatus::REFUNDED) + 1;
+
+  // Fields the secondary indexes are keyed on
+  struct IndexKeys {
+    int64_t customer_id;
+    models::InvoiceStatus status;
+    std::time_t due_date;
+    std::time_t next_billing; // 0 unless a scheduled recurring invoice
+
+    bool operator==(const IndexKeys &o) const {
+      return customer_id == o.customer_id && status == o.status &&
+             due_date == o.due_date && next_billing == o.next_billing;
+    }
+  };
+
+  // Works on both models::Invoice and the snapshot's InvoiceCodec::Record
+  template <typename R> static Balance balance_of(const R &r) {
+    return {r.id, r.status, r.total_amount, r.amount_paid,
+            static_cast<std::time_t>(r.due_date)};
+  }
+
+  template <typename R> static IndexKeys keys_of(const R &r) {
+    bool scheduled = r.type == models::InvoiceType::RECURRING &&
+                     r.status != models::InvoiceStatus::CANCELLED;
+    return {r.customer_id, r.status, static_cast<std::time_t>(r.due_date),
+            scheduled ? static_cast<std::time_t>(r.next_billing_date) : 0};
+  }
+
+  // Invoices that can still become overdue (mirrors Invoice::is_overdue)
+  static bool is_open(models::InvoiceStatus s) {
+    return s != models::InvoiceStatus::PAID &&
+           s != models::InvoiceStatus::CANCELLED;
+  }
+
+  std::optional<IndexKeys> current_keys(int64_t id) const {
+    std::optional<IndexKeys> keys;
+    store_.peek(id, [&](const auto &r) { keys = keys_of(r); });
+    return keys;
+  }
+
+  void index_add(int64_t id, const IndexKeys &k) {
+    by_customer_.insert({k.customer_id, id}, id);
+    by_status_[static_cast<std::size_t>(k.status)].insert(id);
+    if (is_open(k.status))
+      due_index_.insert({k.due_date, id}, id);
+    if (k.next_billing)
+      billing_index_.insert({k.next_billing, id}, id);
+  }
+
+  void index_remove(int64_t id, const IndexKeys &k) {
+    by_customer_.remove({k.customer_id, id});
+    by_status_[static_cast<std::size_t>(k.status)].erase(id);
+    if (is_open(k.status))
+      due_index_.remove({k.due_date, id});
+    if (k.next_billing)
+      billing_index_.remove({k.next_billing, id});
+  }
+
+  // Move id from `old` to `now` keys, touching only the indexes whose key
+  // changed — a status flip leaves the customer and billing trees alone
+  void index_update(int64_t id, const IndexKeys &old, const IndexKeys &now) {
+    if (old.customer_id != now.customer_id) {
+      by_customer_.remove({old.customer_id, id});
+      by_customer_.insert({now.customer_id, id}, id);
+    }
+    if (old.status != now.status) {
+      by_status_[static_cast<std::size_t>(old.status)].erase(id);
+      by_status_[static_cast<std::size_t>(now.status)].insert(id);
+    }
+    bool was_open = is_open(old.status), open = is_open(now.status);
+    if (was_open != open || (open && old.due_date != now.due_date)) {
+      if (was_open)
+        due_index_.remove({old.due_date, id});
+      if (open)
+        due_index_.insert({now.due_date, id}, id);
+    }
+    if (old.next_billing != now.next_billing) {
+      if (old.next_billing)
+        billing_index_.remove({old.next_billing, id});
+      if (now.next_billing)
+        billing_index_.insert({now.next_billing, id}, id);
+    }
+  }
+
+  // Append the log record, then upsert and refresh the cache, so a failed
+  // append changes nothing; caller holds mutex_ and commits the returned
+  // LSN after releasing it
+  uint64_t put_logged(const models::Invoice &inv) {
+    uint64_t lsn = wal_.append(encode_put(inv));
+    put_indexed(inv);
+    cache_.put(inv.id, std::make_shared<const models::Invoice>(inv));
+    return lsn;
+  }
+
+  // Upsert into the store and every index; caller holds mutex_
+  void put_indexed(const models::Invoice &inv) {
+    IndexKeys keys = keys_of(inv);
+    auto old = current_keys(inv.id);
+    if (!old) {
+      index_.insert(inv.id, inv.id);
+      index_add(inv.id, keys);
+    } else if (!(*old == keys)) {
+      index_update(inv.id, *old, keys);
+    }
+    store_.put(inv);
+  }
+
+  bool erase_indexed(int64_t id) {
+    auto old = current_keys(id);
+    if (!old)
+      return false;
+    index_remove(id, *old);
+    index_.remove(id);
+    store_.erase(id);
+    return true;
+  }
+
+  static void write_string(std::ostream &f, const std::string &s) {
     std::size_t len = s.size();
     f.write(reinterpret_cast<const char *>(&len), sizeof(len));
     f.write(s.data(), static_cast<std::streamsize>(len));
   }
-  static void read_string(std::ifstream &f, std::string &s) {
+  static void read_string(std::istream &f, std::string &s) {
     std::size_t len = 0;
     f.read(reinterpret_cast<char *>(&len), sizeof(len));
     s.resize(len);
     f.read(s.data(), static_cast<std::streamsize>(len));
   }
 
-  void write_invoice(std::ofstream &f, const models::Invoice &inv) {
+  static void write_invoice(std::ostream &f, const models::Invoice &inv) {
     f.write(reinterpret_cast<const char *>(&inv.id), sizeof(inv.id));
     f.write(reinterpret_cast<const char *>(&inv.customer_id),
             sizeof(inv.customer_id));
@@ -168,7 +760,7 @@ private:
             sizeof(inv.period_end));
   }
 
-  void read_invoice(std::ifstream &f, models::Invoice &inv) {
+  static void read_invoice(std::istream &f, models::Invoice &inv) {
     f.read(reinterpret_cast<char *>(&inv.id), sizeof(inv.id));
     f.read(reinterpret_cast<char *>(&inv.customer_id), sizeof(inv.customer_id));
     f.read(reinterpret_cast<char *>(&inv.parent_invoice_id),
@@ -207,35 +799,175 @@ private:
     f.read(reinterpret_cast<char *>(&inv.period_end), sizeof(inv.period_end));
   }
 
+  static std::string encode_put(const models::Invoice &inv) {
+    std::ostringstream os(std::ios::binary);
+    os.put(static_cast<char>(LogOp::PUT));
+    write_invoice(os, inv);
+    return os.str();
+  }
+
+  static std::string encode_erase(int64_t id) {
+    std::string rec(1, static_cast<char>(LogOp::ERASE));
+    rec.append(reinterpret_cast<const char *>(&id), sizeof(id));
+    return rec;
+  }
+
+  // BATCH: [op][count u32] then per record [len u32][record]
+  static std::string encode_batch(const std::vector<std::string> &records) {
+    std::string rec(1, static_cast<char>(LogOp::BATCH));
+    uint32_t count = static_cast<uint32_t>(records.size());
+    rec.append(reinterpret_cast<const char *>(&count), sizeof(count));
+    for (const auto &r : records) {
+      uint32_t len = static_cast<uint32_t>(r.size());
+      rec.append(reinterpret_cast<const char *>(&len), sizeof(len));
+      rec.append(r);
+    }
+    return rec;
+  }
+
+  // Apply one log record to the in-memory store (recovery only)
+  void apply_record(const char *data, std::size_t len) {
+    if (len < 1)
+      return;
+    if (static_cast<LogOp>(data[0]) == LogOp::BATCH) {
+      uint32_t count = 0;
+      std::size_t pos = 1 + sizeof(count);
+      if (len < pos)
+        return;
+      std::memcpy(&count, data + 1, sizeof(count));
+      for (uint32_t i = 0; i < count && pos + sizeof(uint32_t) <= len; ++i) {
+        uint32_t rlen = 0;
+        std::memcpy(&rlen, data + pos, sizeof(rlen));
+        pos += sizeof(rlen);
+        if (pos + rlen > len)
+          return;
+        apply_record(data + pos, rlen);
+        pos += rlen;
+      }
+    } else if (static_cast<LogOp>(data[0]) == LogOp::PUT) {
+      std::istringstream is(std::string(data + 1, len - 1), std::ios::binary);
+      models::Invoice inv;
+      read_invoice(is, inv);
+      store_.put(inv);
+    } else if (static_cast<LogOp>(data[0]) == LogOp::ERASE &&
+               len >= 1 + sizeof(int64_t)) {
+      int64_t id;
+      std::memcpy(&id, data + 1, sizeof(id));
+      store_.erase(id);
+    }
+  }
+
+  // Recovery: map the snapshot (or read a legacy stream-format file), then
+  // replay the archived segment of an interrupted checkpoint (if any), then
+  // the active log
   void load_all() {
+    bool legacy = !store_.open(data_file_) && load_legacy();
+    auto apply = [this](const char *d, std::size_t n) { apply_record(d, n); };
+    bool interrupted =
+        core::WriteAheadLog::replay_file(archive_file_, apply) > 0;
+    wal_.recover(apply);
+    build_indexes();
+    if (interrupted || legacy)
+      checkpoint(); // also migrates a legacy file to the mapped format
+  }
+
+  // Collect every index's entries in one pass, sort each once and build the
+  // trees bottom-up — O(n log n) sort instead of n random-order inserts
+  void build_indexes() {
+    std::vector<std::pair<int64_t, int64_t>> ids;
+    std::vector<std::pair<std::pair<int64_t, int64_t>, int64_t>> customers;
+    std::vector<std::pair<std::pair<std::time_t, int64_t>, int64_t>> due;
+    std::vector<std::pair<std::pair<std::time_t, int64_t>, int64_t>> billing;
+    ids.reserve(store_.size());
+    customers.reserve(store_.size());
+    auto build = [&](const auto &r) {
+      IndexKeys k = keys_of(r);
+      ids.emplace_back(r.id, r.id);
+      customers.push_back({{k.customer_id, r.id}, r.id});
+      by_status_[static_cast<std::size_t>(k.status)].insert(r.id);
+      if (is_open(k.status))
+        due.push_back({{k.due_date, r.id}, r.id});
+      if (k.next_billing)
+        billing.push_back({{k.next_billing, r.id}, r.id});
+    };
+    store_.for_each_overlay(build);
+    store_.for_each_snapshot_record(build);
+    std::sort(ids.begin(), ids.end());
+    std::sort(customers.begin(), customers.end());
+    std::sort(due.begin(), due.end());
+    std::sort(billing.begin(), billing.end());
+    index_.bulk_load(ids.begin(), ids.end());
+    by_customer_.bulk_load(customers.begin(), customers.end());
+    due_index_.bulk_load(due.begin(), due.end());
+    billing_index_.bulk_load(billing.begin(), billing.end());
+  }
+
+  // Pre-snapshot format: [count][record...] read through the stream codec
+  bool load_legacy() {
     std::ifstream f(data_file_, std::ios::binary);
     if (!f.is_open())
-      return;
+      return false;
     std::size_t count = 0;
     f.read(reinterpret_cast<char *>(&count), sizeof(count));
-    for (std::size_t i = 0; i < count; ++i) {
+    for (std::size_t i = 0; i < count && f; ++i) {
       models::Invoice inv;
       read_invoice(f, inv);
-      store_[inv.id] = inv;
-      index_.insert(inv.id, inv.id);
+      store_.put(inv);
+    }
+    return true;
+  }
+
+  void maybe_checkpoint() {
+    if (wal_.segment_bytes() < wal_.options().checkpoint_bytes)
+      return;
+    {
+      std::lock_guard<std::mutex> lk(checkpoint_mutex_);
+      checkpoint_requested_ = true;
     }
+    checkpoint_cv_.notify_one();
   }
 
-  void flush() {
-    std::ofstream f(data_file_, std::ios::binary | std::ios::trunc);
-    if (!f.is_open())
-      throw std::runtime_error("Cannot open invoice data file for writing");
-    std::size_t count = store_.size();
-    f.write(reinterpret_cast<const char *>(&count), sizeof(count));
-    for (auto &[id, inv] : store_)
-      write_invoice(f, inv);
+  void checkpoint_loop() {
+    std::unique_lock<std::mutex> lk(checkpoint_mutex_);
+    while (true) {
+      checkpoint_cv_.wait(lk, [&] { return stop_ || checkpoint_requested_; });
+      if (stop_)
+        return;
+      checkpoint_requested_ = false;
+      lk.unlock();
+      try {
+        checkpoint();
+      } catch (const std::exception &) {
+        // Log is still intact; the next trigger retries the compaction
+      }
+      lk.lock();
+    }
   }
 
+  std::string data_dir_;
   std::string data_file_;
-  std::unordered_map<int64_t, models::Invoice> store_;
+  std::string archive_file_;
+  core::WriteAheadLog wal_;
+  using Store = RecordStore<InvoiceCodec>;
+  Store store_;
   core::BPlusTree<int64_t, int64_t> index_;
-  mutable core::LRUCache<int64_t, models::Invoice> cache_;
+  core::BPlusTree<std::pair<int64_t, int64_t>, int64_t> by_customer_;
+  std::array<std::unordered_set<int64_t>, STATUS_COUNT> by_status_;
+  core::BPlusTree<std::pair<std::time_t, int64_t>, int64_t> due_index_;
+  core::BPlusTree<std::pair<std::time_t, int64_t>, int64_t> billing_index_;
+  mutable Cache cache_;
   mutable std::mutex mutex_;
+
+  // Background checkpointing
+  std::thread checkpointer_;
+  std::mutex checkpoint_mutex_;
+  std::mutex checkpoint_run_mutex_;
+  std::condition_variable checkpoint_cv_;
+  bool checkpoint_requested_ = false;
+  bool stop_ = false;
+  std::atomic<std::size_t> checkpoints_{0};
 };
 
+using InvoiceRepository = BasicInvoiceRepository<>;
+
 } // namespace billing::repository
@@ -1,70 +1,252 @@
 #pragma once
 // =============================================================================
 // payment_repository.hpp — File-based Payment Persistence
+// B+ Tree id index, posting lists by invoice and customer, and a
+// completed_at-ordered B+ Tree over completed payments for time windows.
+// The snapshot is memory-mapped and records are decoded on first access
 // =============================================================================
+#include "../core/bplus_tree.hpp"
+#include "../core/deep_size.hpp"
 #include "../core/lru_cache.hpp"
 #include "../models/payment.hpp"
+#include "snapshot.hpp"
+#include "write_batch.hpp"
+#include <algorithm>
+#include <ctime>
 #include <fstream>
+#include <limits>
+#include <memory>
+#include <memory_resource>
 #include <mutex>
 #include <optional>
 #include <stdexcept>
 #include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace billing::repository {
 
-class PaymentRepository {
+// Snapshot codec — fixed-width payment header, strings in the heap
+struct PaymentCodec {
+  using Model = models::Payment;
+  static constexpr uint32_t KIND = 3;
+
+  struct Record {
+    int64_t id;
+    int64_t invoice_id;
+    int64_t customer_id;
+    snapshot::HeapRef gateway_ref;
+    snapshot::HeapRef currency;
+    snapshot::HeapRef notes;
+    models::PaymentMethod method;
+    models::PaymentStatus status;
+    double amount;
+    double refund_amount;
+    int32_t retry_count;
+    int32_t fraud_flagged;
+    int64_t created_at;
+    int64_t completed_at;
+  };
+
+  static Record encode(const Model &p, snapshot::HeapWriter &heap) {
+    Record r{};
+    r.id = p.id;
+    r.invoice_id = p.invoice_id;
+    r.customer_id = p.customer_id;
+    r.gateway_ref = heap.add(p.gateway_ref);
+    r.currency = heap.add(p.currency);
+    r.notes = heap.add(p.notes);
+    r.method = p.method;
+    r.status = p.status;
+    r.amount = p.amount;
+    r.refund_amount = p.refund_amount;
+    r.retry_count = p.retry_count;
+    r.fraud_flagged = p.fraud_flagged ? 1 : 0;
+    r.created_at = p.created_at;
+    r.completed_at = p.completed_at;
+    return r;
+  }
+
+  static Model decode(const Record &r, const char *heap) {
+    Model p{};
+    p.id = r.id;
+    p.invoice_id = r.invoice_id;
+    p.customer_id = r.customer_id;
+    p.method = r.method;
+    p.status = r.status;
+    p.amount = r.amount;
+    p.refund_amount = r.refund_amount;
+    p.gateway_ref = snapshot::str(heap, r.gateway_ref);
+    p.currency = snapshot::str(heap, r.currency);
+    p.notes = snapshot::str(heap, r.notes);
+    p.retry_count = r.retry_count;
+    p.fraud_flagged = r.fraud_flagged != 0;
+    p.created_at = r.created_at;
+    p.completed_at = r.completed_at;
+    return p;
+  }
+
+  static Record rebase(const Record &src, const char *from,
+                       snapshot::HeapWriter &heap) {
+    Record r = src;
+    r.gateway_ref = heap.add(snapshot::view(from, src.gateway_ref));
+    r.currency = heap.add(snapshot::view(from, src.currency));
+    r.notes = heap.add(snapshot::view(from, src.notes));
+    return r;
+  }
+};
+
+// Cached records are immutable and shared: a hit hands out another reference
+// instead of copying the payment
+using PaymentPtr = std::shared_ptr<const models::Payment>;
+
+// Cache: core::LRUCache or a drop-in such as core::ShardedLRUCache
+template <typename Cache = core::LRUCache<int64_t, PaymentPtr>>
+class BasicPaymentRepository {
 public:
-  explicit PaymentRepository(const std::string &data_dir)
+  using record_type = models::Payment;
+
+  explicit BasicPaymentRepository(const std::string &data_dir)
       : data_file_(data_dir + "/payments.bin"), cache_(256) {
     load_all();
   }
 
+  // Create — O(log n) index inserts
   void save(const models::Payment &p) {
     std::lock_guard<std::mutex> lock(mutex_);
-    store_[p.id] = p;
-    cache_.put(p.id, p);
+    put_cached(p);
     flush();
   }
 
-  std::optional<models::Payment> find_by_id(int64_t id) {
-    auto cached = cache_.get(id);
-    if (cached)
-      return cached;
+  // Read by ID without copying — O(1) cache hit (a refcount bump), O(log n)
+  // fallback. The record is immutable; later updates replace it rather
+  // than change it, so the pointer stays valid. nullptr if absent.
+  PaymentPtr find_shared(int64_t id) {
+    if (auto cached = cache_.get(id))
+      return std::move(*cached);
     std::lock_guard<std::mutex> lock(mutex_);
-    auto it = store_.find(id);
-    if (it == store_.end())
+    auto p = store_.get(id);
+    if (!p)
+      return nullptr;
+    auto ptr = std::make_shared<const models::Payment>(std::move(*p));
+    cache_.put(id, ptr);
+    return ptr;
+  }
+
+  // Read by ID as a private copy the caller may edit
+  std::optional<models::Payment> find_by_id(int64_t id) {
+    auto p = find_shared(id);
+    if (!p)
       return std::nullopt;
-    cache_.put(id, it->second);
-    return it->second;
+    return *p;
   }
 
   bool update(const models::Payment &p) {
     std::lock_guard<std::mutex> lock(mutex_);
-    if (store_.find(p.id) == store_.end())
+    if (!store_.contains(p.id))
+      return false;
+    put_cached(p);
+    flush();
+    return true;
+  }
+
+  // Copy-on-write update: `fn(models::Payment &)` edits a copy of the
+  // current record, which then replaces it atomically with respect to other
+  // writers. Readers still holding the old pointer keep the old version.
+  // False if the id is unknown; if fn throws nothing is changed.
+  template <typename Fn> bool modify(int64_t id, Fn &&fn) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto p = store_.get(id);
+    if (!p)
       return false;
-    store_[p.id] = p;
-    cache_.put(p.id, p);
+    fn(*p);
+    p->id = id;
+    put_cached(*p);
     flush();
     return true;
   }
 
+  // Apply a staged batch under one lock with a single flush — O(k + n)
+  std::size_t apply(const std::vector<WriteOp<models::Payment>> &ops) {
+    if (ops.empty())
+      return 0;
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::size_t applied = 0;
+    for (const auto &op : ops) {
+      if (op.kind == WriteKind::REMOVE) {
+        if (!erase_indexed(op.id))
+          continue;
+        cache_.evict(op.id);
+      } else {
+        if (op.kind == WriteKind::UPDATE && !store_.contains(op.id))
+          continue;
+        put_cached(op.record);
+      }
+      applied++;
+    }
+    if (applied)
+      flush();
+    return applied;
+  }
+
+  // Posting-list lookups — O(k)
   std::vector<models::Payment> find_by_invoice(int64_t invoice_id) const {
     std::lock_guard<std::mutex> lock(mutex_);
-    std::vector<models::Payment> result;
-    for (auto &[id, p] : store_)
-      if (p.invoice_id == invoice_id)
-        result.push_back(p);
-    return result;
+    return materialize(by_invoice_, invoice_id);
   }
 
   std::vector<models::Payment> find_by_customer(int64_t customer_id) const {
     std::lock_guard<std::mutex> lock(mutex_);
+    return materialize(by_customer_, customer_id);
+  }
+
+  // Sum of COMPLETED amounts for one customer — O(k), reads only the fixed
+  // record headers (no decoding)
+  double completed_total_for_customer(int64_t customer_id) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    double total = 0.0;
+    auto it = by_customer_.find(customer_id);
+    if (it == by_customer_.end())
+      return total;
+    for (int64_t id : it->second)
+      store_.peek(id, [&](const auto &p) {
+        if (p.status == models::PaymentStatus::COMPLETED)
+          total += p.amount;
+      });
+    return total;
+  }
+
+  // COMPLETED payments with completed_at in [from, to], oldest first —
+  // O(log n + k)
+  std::vector<models::Payment> find_completed_between(std::time_t from,
+                                                      std::time_t to) const {
+    std::lock_guard<std::mutex> lock(mutex_);
     std::vector<models::Payment> result;
-    for (auto &[id, p] : store_)
-      if (p.customer_id == customer_id)
-        result.push_back(p);
+    for (auto &[key, amount] : completed_window(from, to))
+      result.push_back(*store_.get(key.second));
+    return result;
+  }
+
+  // (completed_at, amount) of COMPLETED payments in [from, to], oldest
+  // first — answered from the index alone
+  std::vector<std::pair<std::time_t, double>>
+  completed_amounts(std::time_t from = std::numeric_limits<std::time_t>::min(),
+                    std::time_t to = std::numeric_limits<std::time_t>::max())
+      const {
+    std::vector<std::pair<std::time_t, double>> result;
+    fill_completed_amounts(result, from, to);
+    return result;
+  }
+
+  // Same, with the result allocated from `mr` (e.g. a report's arena)
+  std::pmr::vector<std::pair<std::time_t, double>>
+  completed_amounts(std::pmr::memory_resource *mr,
+                    std::time_t from = std::numeric_limits<std::time_t>::min(),
+                    std::time_t to = std::numeric_limits<std::time_t>::max())
+      const {
+    std::pmr::vector<std::pair<std::time_t, double>> result(mr);
+    fill_completed_amounts(result, from, to);
     return result;
   }
 
@@ -72,8 +254,7 @@ public:
     std::lock_guard<std::mutex> lock(mutex_);
     std::vector<models::Payment> result;
     result.reserve(store_.size());
-    for (auto &[id, p] : store_)
-      result.push_back(p);
+    store_.for_each([&](const models::Payment &p) { result.push_back(p); });
     return result;
   }
 
@@ -82,12 +263,168 @@ public:
     return store_.size();
   }
 
+  // Bound the record cache by memory instead of entry count; entries are
+  // charged cached_bytes(). Needs a Cache with set_byte_budget (LRUCache).
+  void set_cache_byte_budget(std::size_t max_bytes) {
+    cache_.set_byte_budget(max_bytes, &cached_bytes);
+  }
+  std::size_t cache_bytes() const { return cache_.bytes(); }
+
+  // Approximate memory held by one cached payment
+  static std::size_t cached_bytes(const int64_t &, const PaymentPtr &ptr) {
+    const models::Payment &p = *ptr;
+    return core::heap_bytes_of(ptr, p.gateway_ref, p.currency, p.notes);
+  }
+
+  // Rebuild the expected index state from the store and compare — O(n log n)
+  bool verify_indexes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::size_t records = 0, completed = 0;
+    bool ok = true;
+    auto listed = [](const Postings &lists, int64_t key, int64_t id) {
+      auto it = lists.find(key);
+      return it != lists.end() &&
+             std::find(it->second.begin(), it->second.end(), id) !=
+                 it->second.end();
+    };
+    auto check = [&](const auto &p) {
+      IndexKeys k = keys_of(p);
+      records++;
+      ok = ok && index_.search(p.id).has_value() &&
+           listed(by_invoice_, k.invoice_id, p.id) &&
+           listed(by_customer_, k.customer_id, p.id);
+      if (k.status == models::PaymentStatus::COMPLETED) {
+        completed++;
+        auto amount = completed_.search({k.completed_at, p.id});
+        ok = ok && amount && *amount == k.amount;
+      }
+    };
+    store_.for_each_overlay(check);
+    store_.for_each_snapshot_record(check);
+    auto total = [](const Postings &lists) {
+      std::size_t n = 0;
+      for (auto &[key, ids] : lists)
+        n += ids.size();
+      return n;
+    };
+    return ok && index_.size() == records && total(by_invoice_) == records &&
+           total(by_customer_) == records && completed_.size() == completed;
+  }
+
 private:
-  static void write_str(std::ofstream &f, const std::string &s) {
-    std::size_t len = s.size();
-    f.write(reinterpret_cast<const char *>(&len), sizeof(len));
-    f.write(s.data(), static_cast<std::streamsize>(len));
+  using Postings = std::unordered_map<int64_t, std::vector<int64_t>>;
+
+  // Fields the indexes are keyed on
+  struct IndexKeys {
+    int64_t invoice_id;
+    int64_t customer_id;
+    models::PaymentStatus status;
+    std::time_t completed_at;
+    double amount;
+
+    bool operator==(const IndexKeys &o) const {
+      return invoice_id == o.invoice_id && customer_id == o.customer_id &&
+             status == o.status && completed_at == o.completed_at &&
+             amount == o.amount;
+    }
+  };
+
+  // Works on both models::Payment and PaymentCodec::Record
+  template <typename R> static IndexKeys keys_of(const R &r) {
+    return {r.invoice_id, r.customer_id, r.status,
+            static_cast<std::time_t>(r.completed_at), r.amount};
+  }
+
+  std::optional<IndexKeys> current_keys(int64_t id) const {
+    std::optional<IndexKeys> keys;
+    store_.peek(id, [&](const auto &r) { keys = keys_of(r); });
+    return keys;
   }
+
+  static void unlist(Postings &lists, int64_t key, int64_t id) {
+    auto it = lists.find(key);
+    if (it == lists.end())
+      return;
+    auto &ids = it->second;
+    ids.erase(std::remove(ids.begin(), ids.end(), id), ids.end());
+    if (ids.empty())
+      lists.erase(it);
+  }
+
+  void index_add(int64_t id, const IndexKeys &k) {
+    by_invoice_[k.invoice_id].push_back(id);
+    by_customer_[k.customer_id].push_back(id);
+    if (k.status == models::PaymentStatus::COMPLETED)
+      completed_.insert({k.completed_at, id}, k.amount);
+  }
+
+  void index_remove(int64_t id, const IndexKeys &k) {
+    unlist(by_invoice_, k.invoice_id, id);
+    unlist(by_customer_, k.customer_id, id);
+    if (k.status == models::PaymentStatus::COMPLETED)
+      completed_.remove({k.completed_at, id});
+  }
+
+  // Upsert and refresh the cached copy; caller holds mutex_
+  void put_cached(const models::Payment &p) {
+    put_indexed(p);
+    cache_.put(p.id, std::make_shared<const models::Payment>(p));
+  }
+
+  // Upsert into the store and every index; caller holds mutex_
+  void put_indexed(const models::Payment &p) {
+    IndexKeys keys = keys_of(p);
+    auto old = current_keys(p.id);
+    if (!old) {
+      index_.insert(p.id, p.id);
+      index_add(p.id, keys);
+    } else if (!(*old == keys)) {
+      index_remove(p.id, *old);
+      index_add(p.id, keys);
+    }
+    store_.put(p);
+  }
+
+  bool erase_indexed(int64_t id) {
+    auto old = current_keys(id);
+    if (!old)
+      return false;
+    index_remove(id, *old);
+    index_.remove(id);
+    store_.erase(id);
+    return true;
+  }
+
+  using TimeKey = std::pair<std::time_t, int64_t>; // (completed_at, id)
+
+  std::vector<std::pair<TimeKey, double>>
+  completed_window(std::time_t from, std::time_t to) const {
+    return completed_.range({from, INT64_MIN}, {to, INT64_MAX});
+  }
+
+  template <typename Out>
+  void fill_completed_amounts(Out &out, std::time_t from,
+                              std::time_t to) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    completed_.range_for_each(
+        {from, INT64_MIN}, {to, INT64_MAX},
+        [&](const auto &key, double amount) {
+          out.emplace_back(key.first, amount);
+        });
+  }
+
+  std::vector<models::Payment> materialize(const Postings &lists,
+                                           int64_t key) const {
+    std::vector<models::Payment> result;
+    auto it = lists.find(key);
+    if (it == lists.end())
+      return result;
+    result.reserve(it->second.size());
+    for (int64_t id : it->second)
+      result.push_back(*store_.get(id));
+    return result;
+  }
+
   static void read_str(std::ifstream &f, std::string &s) {
     std::size_t len = 0;
     f.read(reinterpret_cast<char *>(&len), sizeof(len));
@@ -95,31 +432,7 @@ private:
     f.read(s.data(), static_cast<std::streamsize>(len));
   }
 
-  void write_payment(std::ofstream &f, const models::Payment &p) {
-    f.write(reinterpret_cast<const char *>(&p.id), sizeof(p.id));
-    f.write(reinterpret_cast<const char *>(&p.invoice_id),
-            sizeof(p.invoice_id));
-    f.write(reinterpret_cast<const char *>(&p.customer_id),
-            sizeof(p.customer_id));
-    f.write(reinterpret_cast<const char *>(&p.method), sizeof(p.method));
-    f.write(reinterpret_cast<const char *>(&p.status), sizeof(p.status));
-    f.write(reinterpret_cast<const char *>(&p.amount), sizeof(p.amount));
-    f.write(reinterpret_cast<const char *>(&p.refund_amount),
-            sizeof(p.refund_amount));
-    write_str(f, p.gateway_ref);
-    write_str(f, p.currency);
-    write_str(f, p.notes);
-    f.write(reinterpret_cast<const char *>(&p.retry_count),
-            sizeof(p.retry_count));
-    f.write(reinterpret_cast<const char *>(&p.fraud_flagged),
-            sizeof(p.fraud_flagged));
-    f.write(reinterpret_cast<const char *>(&p.created_at),
-            sizeof(p.created_at));
-    f.write(reinterpret_cast<const char *>(&p.completed_at),
-            sizeof(p.completed_at));
-  }
-
-  void read_payment(std::ifstream &f, models::Payment &p) {
+  static void read_payment(std::ifstream &f, models::Payment &p) {
     f.read(reinterpret_cast<char *>(&p.id), sizeof(p.id));
     f.read(reinterpret_cast<char *>(&p.invoice_id), sizeof(p.invoice_id));
     f.read(reinterpret_cast<char *>(&p.customer_id), sizeof(p.customer_id));
@@ -137,32 +450,55 @@ private:
   }
 
   void load_all() {
-    std::ifstream f(data_file_, std::ios::binary);
-    if (!f.is_open())
-      return;
-    std::size_t count = 0;
-    f.read(reinterpret_cast<char *>(&count), sizeof(count));
-    for (std::size_t i = 0; i < count; ++i) {
-      models::Payment p;
-      read_payment(f, p);
-      store_[p.id] = p;
+    if (!store_.open(data_file_)) {
+      std::ifstream f(data_file_, std::ios::binary);
+      if (!f.is_open())
+        return;
+      // Legacy stream format: read once, rewrite as a mapped snapshot
+      std::size_t count = 0;
+      f.read(reinterpret_cast<char *>(&count), sizeof(count));
+      for (std::size_t i = 0; i < count && f; ++i) {
+        models::Payment p;
+        read_payment(f, p);
+        store_.put(p);
+      }
+      f.close();
+      flush();
     }
+    // Postings are filled directly; the trees are sorted once and built
+    // bottom-up
+    std::vector<std::pair<int64_t, int64_t>> ids;
+    std::vector<std::pair<TimeKey, double>> completed;
+    ids.reserve(store_.size());
+    auto build = [&](const auto &p) {
+      IndexKeys k = keys_of(p);
+      ids.emplace_back(p.id, p.id);
+      by_invoice_[k.invoice_id].push_back(p.id);
+      by_customer_[k.customer_id].push_back(p.id);
+      if (k.status == models::PaymentStatus::COMPLETED)
+        completed.push_back({{k.completed_at, p.id}, k.amount});
+    };
+    store_.for_each_overlay(build);
+    store_.for_each_snapshot_record(build);
+    std::sort(ids.begin(), ids.end());
+    std::sort(completed.begin(), completed.end());
+    index_.bulk_load(ids.begin(), ids.end());
+    completed_.bulk_load(completed.begin(), completed.end());
   }
 
-  void flush() {
-    std::ofstream f(data_file_, std::ios::binary | std::ios::trunc);
-    if (!f.is_open())
-      throw std::runtime_error("Cannot open payment data file for writing");
-    std::size_t count = store_.size();
-    f.write(reinterpret_cast<const char *>(&count), sizeof(count));
-    for (auto &[id, p] : store_)
-      write_payment(f, p);
-  }
+  // Merge the overlay into a new snapshot (temp file + rename) and remap it
+  void flush() { store_.checkpoint(data_file_); }
 
   std::string data_file_;
-  std::unordered_map<int64_t, models::Payment> store_;
-  mutable core::LRUCache<int64_t, models::Payment> cache_;
+  RecordStore<PaymentCodec> store_;
+  core::BPlusTree<int64_t, int64_t> index_;
+  Postings by_invoice_;
+  Postings by_customer_;
+  core::BPlusTree<TimeKey, double> completed_; // COMPLETED only -> amount
+  mutable Cache cache_;
   mutable std::mutex mutex_;
 };
 
+using PaymentRepository = BasicPaymentRepository<>;
+
 } // namespace billing::repository
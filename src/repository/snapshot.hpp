@@ -0,0 +1,540 @@
+#pragma once
+// =============================================================================
+// snapshot.hpp — Memory-Mapped Snapshot Format + Overlay Record Store
+// Layout (version 1, native endianness, 8-byte aligned sections):
+//   [Header 64B][offsets table: {id, offset} x N, sorted by id]
+//   [fixed-width record headers x N][string/array heap]
+// Snapshots are mmap'ed and read in place: a record is only materialized
+// into a model object when it is looked up. Writes land in an in-memory
+// overlay that a checkpoint folds into the next snapshot.
+// Complexity: Open O(1), Lookup O(log n), Checkpoint O(n) streaming
+// =============================================================================
+#include "../core/mapped_file.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+
+namespace billing::repository {
+
+namespace snapshot {
+
+constexpr char MAGIC[8] = {'B', 'I', 'L', 'L', 'S', 'N', 'A', 'P'};
+constexpr uint32_t VERSION = 1;
+
+struct Header {
+  char magic[8];
+  uint32_t version;
+  uint32_t kind;        // Codec::KIND — which model the file holds
+  uint64_t record_count;
+  uint32_t record_size; // sizeof(Codec::Record), guards layout drift
+  uint32_t reserved;
+  uint64_t index_offset;
+  uint64_t records_offset;
+  uint64_t heap_offset;
+  uint64_t heap_size;
+};
+static_assert(sizeof(Header) == 64, "snapshot header must stay 64 bytes");
+
+struct IndexEntry {
+  int64_t id;
+  uint64_t offset; // byte offset of the record header from records_offset
+};
+
+// Reference into the heap: bytes for strings, element count for arrays
+struct HeapRef {
+  uint64_t offset;
+  uint64_t size;
+};
+
+inline std::string_view view(const char *heap, HeapRef r) {
+  return {heap + r.offset, static_cast<std::size_t>(r.size)};
+}
+
+inline std::string str(const char *heap, HeapRef r) {
+  return std::string(heap + r.offset, static_cast<std::size_t>(r.size));
+}
+
+template <typename Pod> const Pod *array(const char *heap, HeapRef r) {
+  return reinterpret_cast<const Pod *>(heap + r.offset);
+}
+
+// Buffered sequential writer for one section of the output file (pwrite)
+class SectionWriter {
+public:
+  SectionWriter(int fd, uint64_t base) : fd_(fd), base_(base) {
+    buf_.reserve(BUF_SIZE);
+  }
+
+  // Append bytes; returns their offset relative to the section start
+  uint64_t write(const void *data, std::size_t len) {
+    uint64_t at = pos_;
+    const char *p = static_cast<const char *>(data);
+    buf_.insert(buf_.end(), p, p + len);
+    pos_ += len;
+    if (buf_.size() >= BUF_SIZE)
+      flush();
+    return at;
+  }
+
+  void align(std::size_t a) {
+    static const char zeros[16] = {};
+    std::size_t pad = (a - pos_ % a) % a;
+    if (pad)
+      write(zeros, pad);
+  }
+
+  void flush() {
+    std::size_t done = 0;
+    while (done < buf_.size()) {
+      ssize_t n = ::pwrite(fd_, buf_.data() + done, buf_.size() - done,
+                           static_cast<off_t>(base_ + flushed_ + done));
+      if (n < 0)
+        throw std::runtime_error("Snapshot write failed");
+      done += static_cast<std::size_t>(n);
+    }
+    flushed_ += buf_.size();
+    buf_.clear();
+  }
+
+  uint64_t pos() const { return pos_; }
+
+private:
+  static constexpr std::size_t BUF_SIZE = 1u << 20;
+  int fd_;
+  uint64_t base_;
+  uint64_t pos_ = 0;
+  uint64_t flushed_ = 0;
+  std::vector<char> buf_;
+};
+
+// Codecs append strings/arrays to the heap through this
+class HeapWriter {
+public:
+  explicit HeapWriter(SectionWriter &w) : w_(w) {}
+
+  HeapRef add(std::string_view s) {
+    return {w_.write(s.data(), s.size()), s.size()};
+  }
+
+  template <typename Pod> HeapRef add_array(const Pod *items, std::size_t n) {
+    static_assert(std::is_trivially_copyable_v<Pod>, "heap arrays are PODs");
+    w_.align(alignof(Pod));
+    return {w_.write(items, n * sizeof(Pod)), n};
+  }
+
+private:
+  SectionWriter &w_;
+};
+
+} // namespace snapshot
+
+// -----------------------------------------------------------------------------
+// SnapshotFile<Codec> — read-only view over one mapped snapshot
+// Codec provides: Model, Record (trivially copyable, has int64_t id), KIND,
+//   static Record encode(const Model&, snapshot::HeapWriter&)
+//   static Model decode(const Record&, const char *heap)
+//   static Record rebase(const Record&, const char *heap, HeapWriter&)
+// -----------------------------------------------------------------------------
+template <typename Codec> class SnapshotFile {
+public:
+  using Model = typename Codec::Model;
+  using Record = typename Codec::Record;
+  static_assert(std::is_trivially_copyable_v<Record>,
+                "snapshot records must be fixed-width PODs");
+
+  // True if `path` exists and starts with the snapshot magic
+  static bool is_snapshot(const std::string &path) {
+    std::ifstream f(path, std::ios::binary);
+    char magic[sizeof(snapshot::MAGIC)] = {};
+    return f.read(magic, sizeof(magic)) &&
+           std::memcmp(magic, snapshot::MAGIC, sizeof(magic)) == 0;
+  }
+
+  static std::shared_ptr<const SnapshotFile> open(const std::string &path) {
+    auto snap = std::shared_ptr<SnapshotFile>(new SnapshotFile());
+    snap->file_ = core::MappedFile(path);
+    snap->validate(path);
+    return snap;
+  }
+
+  std::size_t size() const { return hdr_ ? hdr_->record_count : 0; }
+
+  int64_t id_at(std::size_t i) const { return index_[i].id; }
+
+  const Record &record_at(std::size_t i) const {
+    return *reinterpret_cast<const Record *>(records_ + index_[i].offset);
+  }
+
+  // Binary search over the offsets table — O(log n), no allocation
+  const Record *find(int64_t id) const {
+    std::size_t i = lower_bound(id);
+    if (i < size() && index_[i].id == id)
+      return &record_at(i);
+    return nullptr;
+  }
+
+  bool contains(int64_t id) const { return find(id) != nullptr; }
+
+  std::size_t lower_bound(int64_t id) const {
+    const snapshot::IndexEntry *first = index_, *last = index_ + size();
+    auto it = std::lower_bound(
+        first, last, id,
+        [](const snapshot::IndexEntry &e, int64_t k) { return e.id < k; });
+    return static_cast<std::size_t>(it - first);
+  }
+
+  Model materialize(const Record &r) const { return Codec::decode(r, heap_); }
+
+  const char *heap() const { return heap_; }
+
+  // Stream records in ascending id order into a new snapshot at `path`.
+  // `produce(emit_model, emit_raw)` must call one of the emitters per record;
+  // emit_raw copies a record of another snapshot without decoding it.
+  template <typename Produce>
+  static void write(const std::string &path, std::size_t count,
+                    Produce produce) {
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+      throw std::runtime_error("Cannot open snapshot for writing: " + path);
+    try {
+      snapshot::Header h{};
+      std::memcpy(h.magic, snapshot::MAGIC, sizeof(h.magic));
+      h.version = snapshot::VERSION;
+      h.kind = Codec::KIND;
+      h.record_count = count;
+      h.record_size = sizeof(Record);
+      h.index_offset = sizeof(snapshot::Header);
+      h.records_offset =
+          align8(h.index_offset + count * sizeof(snapshot::IndexEntry));
+      h.heap_offset = align8(h.records_offset + count * sizeof(Record));
+
+      snapshot::SectionWriter index_w(fd, h.index_offset);
+      snapshot::SectionWriter record_w(fd, h.records_offset);
+      snapshot::SectionWriter heap_w(fd, h.heap_offset);
+      snapshot::HeapWriter heap(heap_w);
+      std::size_t written = 0;
+
+      auto emit = [&](const Record &r) {
+        snapshot::IndexEntry e{r.id, record_w.pos()};
+        index_w.write(&e, sizeof(e));
+        record_w.write(&r, sizeof(r));
+        written++;
+      };
+      auto emit_model = [&](const Model &m) { emit(Codec::encode(m, heap)); };
+      auto emit_raw = [&](const Record &r, const char *src_heap) {
+        emit(Codec::rebase(r, src_heap, heap));
+      };
+      produce(emit_model, emit_raw);
+      if (written != count)
+        throw std::logic_error("Snapshot record count mismatch");
+
+      index_w.flush();
+      record_w.flush();
+      heap_w.flush();
+      h.heap_size = heap_w.pos();
+      if (::pwrite(fd, &h, sizeof(h), 0) != static_cast<ssize_t>(sizeof(h)))
+        throw std::runtime_error("Snapshot header write failed");
+      ::fsync(fd);
+    } catch (...) {
+      ::close(fd);
+      throw;
+    }
+    ::close(fd);
+  }
+
+private:
+  SnapshotFile() = default;
+
+  static uint64_t align8(uint64_t v) { return (v + 7) & ~uint64_t(7); }
+
+  void validate(const std::string &path) {
+    if (file_.size() < sizeof(snapshot::Header))
+      throw std::runtime_error("Snapshot truncated: " + path);
+    hdr_ = reinterpret_cast<const snapshot::Header *>(file_.data());
+    if (std::memcmp(hdr_->magic, snapshot::MAGIC, sizeof(hdr_->magic)) != 0)
+      throw std::runtime_error("Not a snapshot file: " + path);
+    if (hdr_->version != snapshot::VERSION || hdr_->kind != Codec::KIND ||
+        hdr_->record_size != sizeof(Record))
+      throw std::runtime_error("Unsupported snapshot version/layout: " + path);
+    uint64_t n = hdr_->record_count;
+    if (hdr_->index_offset + n * sizeof(snapshot::IndexEntry) > file_.size() ||
+        hdr_->records_offset + n * sizeof(Record) > file_.size() ||
+        hdr_->heap_offset + hdr_->heap_size > file_.size())
+      throw std::runtime_error("Snapshot sections out of bounds: " + path);
+    index_ = reinterpret_cast<const snapshot::IndexEntry *>(file_.data() +
+                                                            hdr_->index_offset);
+    records_ = file_.data() + hdr_->records_offset;
+    heap_ = file_.data() + hdr_->heap_offset;
+  }
+
+  core::MappedFile file_;
+  const snapshot::Header *hdr_ = nullptr;
+  const snapshot::IndexEntry *index_ = nullptr;
+  const char *records_ = nullptr;
+  const char *heap_ = nullptr;
+};
+
+// -----------------------------------------------------------------------------
+// RecordStore<Codec> — mapped snapshot + in-memory overlay of newer writes.
+// Not thread-safe: repositories call it under their own mutex. Checkpoints
+// are split (freeze under the lock, write without it, install under it) so
+// writers are only blocked for O(overlay) work.
+// -----------------------------------------------------------------------------
+template <typename Codec> class RecordStore {
+public:
+  using Model = typename Codec::Model;
+  using Record = typename Codec::Record;
+  using Snapshot = SnapshotFile<Codec>;
+
+  // State captured for an offline checkpoint
+  struct Frozen {
+    std::shared_ptr<const Snapshot> base;
+    std::vector<Model> overlay;    // sorted by id
+    std::vector<int64_t> removed;  // sorted tombstone ids
+    uint64_t seq = 0;
+    std::size_t count = 0;
+  };
+
+  // Map `path` if it is a snapshot. Returns false when the file is missing
+  // or in another format (the caller then loads it the legacy way).
+  bool open(const std::string &path) {
+    if (!Snapshot::is_snapshot(path))
+      return false;
+    snapshot_ = Snapshot::open(path);
+    overlay_.clear();
+    tombstones_.clear();
+    shadowed_ = 0;
+    return true;
+  }
+
+  // Materialize one record — O(1) overlay, O(log n) snapshot
+  std::optional<Model> get(int64_t id) const {
+    auto it = overlay_.find(id);
+    if (it != overlay_.end())
+      return it->second.model;
+    if (tombstones_.count(id) || !snapshot_)
+      return std::nullopt;
+    if (const Record *r = snapshot_->find(id))
+      return snapshot_->materialize(*r);
+    return std::nullopt;
+  }
+
+  // Call fn with the live Model (overlay) or fixed-width Record (snapshot)
+  // without decoding — for reading header fields such as index keys
+  template <typename Fn> bool peek(int64_t id, Fn fn) const {
+    auto it = overlay_.find(id);
+    if (it != overlay_.end()) {
+      fn(it->second.model);
+      return true;
+    }
+    if (tombstones_.count(id) || !snapshot_)
+      return false;
+    if (const Record *r = snapshot_->find(id)) {
+      fn(*r);
+      return true;
+    }
+    return false;
+  }
+
+  bool contains(int64_t id) const {
+    if (overlay_.count(id))
+      return true;
+    if (tombstones_.count(id))
+      return false;
+    return in_snapshot(id);
+  }
+
+  void put(const Model &m) {
+    uint64_t seq = ++seq_;
+    auto it = overlay_.find(m.id);
+    if (it != overlay_.end()) {
+      it->second = {m, seq};
+      return;
+    }
+    if (tombstones_.erase(m.id) == 0 && in_snapshot(m.id))
+      shadowed_++;
+    overlay_.emplace(m.id, Entry{m, seq});
+  }
+
+  bool erase(int64_t id) {
+    if (overlay_.erase(id)) {
+      tombstones_[id] = ++seq_; // shadow count unchanged
+      return true;
+    }
+    if (tombstones_.count(id) || !in_snapshot(id))
+      return false;
+    tombstones_[id] = ++seq_;
+    shadowed_++;
+    return true;
+  }
+
+  std::size_t size() const {
+    return (snapshot_ ? snapshot_->size() : 0) - shadowed_ + overlay_.size();
+  }
+
+  // Visit every live record as a model (snapshot records decoded one at a
+  // time, never retained)
+  template <typename Fn> void for_each(Fn fn) const {
+    for (auto &[id, e] : overlay_)
+      fn(e.model);
+    for_each_snapshot_record(
+        [&](const Record &r) { fn(snapshot_->materialize(r)); });
+  }
+
+  // Visit live snapshot record headers in place — no decoding
+  template <typename Fn> void for_each_snapshot_record(Fn fn) const {
+    if (!snapshot_)
+      return;
+    bool check = shadowed_ > 0;
+    for (std::size_t i = 0, n = snapshot_->size(); i < n; ++i) {
+      int64_t id = snapshot_->id_at(i);
+      if (check && (overlay_.count(id) || tombstones_.count(id)))
+        continue;
+      fn(snapshot_->record_at(i));
+    }
+  }
+
+  // Filtered scan: snapshot records are tested in place and only matches
+  // are materialized. `match_record` sees the fixed-width header.
+  template <typename ModelPred, typename RecordPred>
+  std::vector<Model> select(ModelPred match_model,
+                            RecordPred match_record) const {
+    std::vector<Model> out;
+    for (auto &[id, e] : overlay_)
+      if (match_model(e.model))
+        out.push_back(e.model);
+    for_each_snapshot_record([&](const Record &r) {
+      if (match_record(r))
+        out.push_back(snapshot_->materialize(r));
+    });
+    return out;
+  }
+
+  // Same predicate for both (fields named alike on Model and Record)
+  template <typename Pred> std::vector<Model> select(Pred match) const {
+    return select(match, match);
+  }
+
+  template <typename Fn> void for_each_overlay(Fn fn) const {
+    for (auto &[id, e] : overlay_)
+      fn(e.model);
+  }
+
+  // Visit every live id — no decoding
+  template <typename Fn> void for_each_id(Fn fn) const {
+    for (auto &[id, e] : overlay_)
+      fn(id);
+    for_each_snapshot_record([&](const Record &r) { fn(r.id); });
+  }
+
+  const char *heap() const { return snapshot_ ? snapshot_->heap() : nullptr; }
+
+  // --- Checkpointing -------------------------------------------------------
+  Frozen freeze() const {
+    Frozen f;
+    f.base = snapshot_;
+    f.seq = seq_;
+    f.count = size();
+    f.overlay.reserve(overlay_.size());
+    for (auto &[id, e] : overlay_)
+      f.overlay.push_back(e.model);
+    std::sort(f.overlay.begin(), f.overlay.end(),
+              [](const Model &a, const Model &b) { return a.id < b.id; });
+    f.removed.reserve(tombstones_.size());
+    for (auto &[id, seq] : tombstones_)
+      f.removed.push_back(id);
+    std::sort(f.removed.begin(), f.removed.end());
+    return f;
+  }
+
+  // Merge base snapshot + frozen overlay into a new file — no lock needed
+  static void write(const std::string &path, const Frozen &f) {
+    std::string tmp = path + ".tmp";
+    Snapshot::write(tmp, f.count, [&](auto &emit_model, auto &emit_raw) {
+      std::size_t i = 0, n = f.base ? f.base->size() : 0;
+      std::size_t j = 0, k = 0;
+      while (i < n || j < f.overlay.size()) {
+        int64_t sid = i < n ? f.base->id_at(i) : INT64_MAX;
+        if (j < f.overlay.size() && f.overlay[j].id <= sid) {
+          if (f.overlay[j].id == sid)
+            ++i; // overlay supersedes the snapshot copy
+          emit_model(f.overlay[j++]);
+          continue;
+        }
+        while (k < f.removed.size() && f.removed[k] < sid)
+          ++k;
+        if (!(k < f.removed.size() && f.removed[k] == sid))
+          emit_raw(f.base->record_at(i), f.base->heap());
+        ++i;
+      }
+    });
+    if (std::rename(tmp.c_str(), path.c_str()) != 0)
+      throw std::runtime_error("Cannot replace snapshot: " + path);
+  }
+
+  // Switch to the freshly written snapshot and drop overlay entries and
+  // tombstones it already contains (those written before the freeze)
+  void install(const std::string &path, const Frozen &f) {
+    snapshot_ = Snapshot::open(path);
+    shadowed_ = 0;
+    for (auto it = overlay_.begin(); it != overlay_.end();) {
+      if (it->second.seq <= f.seq) {
+        it = overlay_.erase(it);
+        continue;
+      }
+      if (in_snapshot(it->first))
+        shadowed_++;
+      ++it;
+    }
+    for (auto it = tombstones_.begin(); it != tombstones_.end();) {
+      if (it->second <= f.seq || !in_snapshot(it->first)) {
+        it = tombstones_.erase(it);
+        continue;
+      }
+      shadowed_++;
+      ++it;
+    }
+  }
+
+  // Synchronous checkpoint (caller holds its lock throughout)
+  void checkpoint(const std::string &path) {
+    Frozen f = freeze();
+    write(path, f);
+    install(path, f);
+  }
+
+  std::size_t overlay_size() const { return overlay_.size(); }
+  std::size_t snapshot_size() const {
+    return snapshot_ ? snapshot_->size() : 0;
+  }
+
+private:
+  struct Entry {
+    Model model;
+    uint64_t seq;
+  };
+
+  bool in_snapshot(int64_t id) const {
+    return snapshot_ && snapshot_->contains(id);
+  }
+
+  std::shared_ptr<const Snapshot> snapshot_;
+  std::unordered_map<int64_t, Entry> overlay_;
+  std::unordered_map<int64_t, uint64_t> tombstones_; // id -> erase seq
+  std::size_t shadowed_ = 0; // overlay/tombstone ids present in snapshot_
+  uint64_t seq_ = 0;
+};
+
+} // namespace billing::repository
@@ -0,0 +1,119 @@
+#pragma once
+// =============================================================================
+// write_batch.hpp — Multi-Repository Write Batch (group commit)
+// Stages saves/updates/removes for Customer, Invoice and Payment records and
+// commits each repository's share with one lock acquisition and one durable
+// write, instead of one lock + file write per record.
+// =============================================================================
+#include "../models/customer.hpp"
+#include "../models/invoice.hpp"
+#include "../models/payment.hpp"
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <vector>
+
+namespace billing::repository {
+
+enum class WriteKind { SAVE = 0, UPDATE = 1, REMOVE = 2, MODIFY = 3 };
+
+template <typename Record> struct WriteOp {
+  WriteKind kind;
+  int64_t id;
+  Record record; // unused for REMOVE and MODIFY
+  // MODIFY only: edits the record as it stands at commit, under the
+  // repository lock; returning false skips it
+  std::function<bool(Record &)> edit;
+};
+
+class WriteBatch {
+public:
+  // Stage operations — O(1) each, nothing touches a repository until commit
+  void save(const models::Customer &c) {
+    stage(customers_, WriteKind::SAVE, c);
+  }
+  void save(const models::Invoice &i) { stage(invoices_, WriteKind::SAVE, i); }
+  void save(const models::Payment &p) { stage(payments_, WriteKind::SAVE, p); }
+
+  void update(const models::Customer &c) {
+    stage(customers_, WriteKind::UPDATE, c);
+  }
+  void update(const models::Invoice &i) {
+    stage(invoices_, WriteKind::UPDATE, i);
+  }
+  void update(const models::Payment &p) {
+    stage(payments_, WriteKind::UPDATE, p);
+  }
+
+  void remove_customer(int64_t id) {
+    customers_.push_back({WriteKind::REMOVE, id, {}, {}});
+  }
+  void remove_invoice(int64_t id) {
+    invoices_.push_back({WriteKind::REMOVE, id, {}, {}});
+  }
+
+  // Field-level change: edit(models::Invoice &) runs on the current record
+  // when the batch commits, so fields it leaves alone keep whatever other
+  // writers set after staging. Returning false skips the op.
+  void modify_invoice(int64_t id,
+                      std::function<bool(models::Invoice &)> edit) {
+    invoices_.push_back({WriteKind::MODIFY, id, {}, std::move(edit)});
+  }
+
+  template <typename Record> const std::vector<WriteOp<Record>> &ops() const;
+
+  // Commit staged operations into the given repositories. Each repository
+  // applies its operations under a single lock and persists them with one
+  // durable write. Returns the number of operations applied (UPDATE/REMOVE/
+  // MODIFY of a missing record is skipped, as with the single-record calls).
+  template <typename... Repos> std::size_t commit(Repos &...repos) {
+    std::size_t covered = (0 + ... + ops<typename Repos::record_type>().size());
+    if (covered != size())
+      throw std::logic_error("WriteBatch: staged records for a repository "
+                             "that was not passed to commit()");
+    std::size_t applied =
+        (0 + ... + repos.apply(ops<typename Repos::record_type>()));
+    clear();
+    return applied;
+  }
+
+  std::size_t size() const {
+    return customers_.size() + invoices_.size() + payments_.size();
+  }
+  bool empty() const { return size() == 0; }
+
+  void clear() {
+    customers_.clear();
+    invoices_.clear();
+    payments_.clear();
+  }
+
+private:
+  template <typename Record>
+  static void stage(std::vector<WriteOp<Record>> &ops, WriteKind kind,
+                    const Record &r) {
+    ops.push_back({kind, r.id, r, {}});
+  }
+
+  std::vector<WriteOp<models::Customer>> customers_;
+  std::vector<WriteOp<models::Invoice>> invoices_;
+  std::vector<WriteOp<models::Payment>> payments_;
+};
+
+template <>
+inline const std::vector<WriteOp<models::Customer>> &
+WriteBatch::ops<models::Customer>() const {
+  return customers_;
+}
+template <>
+inline const std::vector<WriteOp<models::Invoice>> &
+WriteBatch::ops<models::Invoice>() const {
+  return invoices_;
+}
+template <>
+inline const std::vector<WriteOp<models::Payment>> &
+WriteBatch::ops<models::Payment>() const {
+  return payments_;
+}
+
+} // namespace billing::repository
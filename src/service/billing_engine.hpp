@@ -2,23 +2,35 @@
 // =============================================================================
 // billing_engine.hpp — Invoice & Billing Engine Service
 // Design Pattern: Factory (InvoiceFactory), Observer (billing events)
-// Multi-threading: std::thread for concurrent batch generation
+// Multi-threading: batch generation is a core::Pipeline on the shared
+// core::ThreadPool
 // =============================================================================
-#include "../core/min_heap.hpp"
+#include "../core/calendar.hpp"
+#include "../core/indexed_heap.hpp"
+#include "../core/monthly_sequence.hpp"
+#include "../core/pipeline.hpp"
 #include "../core/snowflake.hpp"
+#include "../core/timing_wheel.hpp"
 #include "../models/customer.hpp"
 #include "../models/invoice.hpp"
 #include "../repository/customer_repository.hpp"
 #include "../repository/invoice_repository.hpp"
+#include "../repository/write_batch.hpp"
 #include "discount_engine.hpp"
 #include "tax_engine.hpp"
+#include <algorithm>
 #include <atomic>
+#include <chrono>
 #include <ctime>
+#include <functional>
+#include <limits>
 #include <mutex>
 #include <optional>
 #include <stdexcept>
 #include <string>
-#include <thread>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 namespace billing {
@@ -30,6 +42,11 @@ struct BillingObserver {
   virtual void on_invoice_created(const models::Invoice &inv) = 0;
   virtual void on_invoice_paid(const models::Invoice &inv) = 0;
   virtual void on_invoice_overdue(const models::Invoice &inv) = 0;
+  // One overdue sweep's invoices at once; override to handle them in bulk
+  virtual void on_invoices_overdue(const std::vector<models::Invoice> &invs) {
+    for (const auto &inv : invs)
+      on_invoice_overdue(inv);
+  }
 };
 
 // Invoice creation request
@@ -47,20 +64,58 @@ struct InvoiceRequest {
   int due_days = 30; // days from issue to due
 };
 
-// Named comparator for invoice due_date ordering (C++17-compatible)
-struct InvoiceDueCompare {
-  bool operator()(const models::Invoice &a, const models::Invoice &b) const {
-    return a.due_date < b.due_date;
-  }
+// Tuning for batch_create's pipeline. Requests travel in chunks; each
+// stage runs at most its worker count of pool tasks at once.
+struct BatchOptions {
+  std::size_t chunk_size = 1024;
+  std::size_t max_in_flight = 16; // chunks between submission and events
+  int prefetch_workers = 1;
+  int price_workers = 0; // 0: one per pool thread
+  int number_workers = 1;
+  int commit_workers = 1;
+  int event_workers = 1;
+};
+
+// A request batch_create could not turn into an invoice
+struct BatchFailure {
+  std::size_t index; // into the request vector
+  std::string reason;
+};
+
+struct BatchResult {
+  std::vector<models::Invoice> invoices; // created, in request order
+  std::vector<BatchFailure> failures;    // by request index
+};
+
+// What the last batch_create did, stage by stage
+struct BatchStats {
+  std::size_t requests = 0;
+  std::size_t created = 0;
+  double wall_ms = 0.0;
+  std::vector<core::StageStats> stages;
+};
+
+// What one sweep_overdue did
+struct OverdueSweep {
+  std::size_t expired = 0; // ids whose due date passed since the last sweep
+  std::size_t flagged = 0; // of those, PENDING invoices now OVERDUE
+  double ms = 0.0;
 };
 
 class BillingEngine {
 public:
   BillingEngine(repository::InvoiceRepository &inv_repo,
                 repository::CustomerRepository &cust_repo, DiscountEngine &disc,
-                TaxEngine &tax)
+                TaxEngine &tax,
+                core::ThreadPool &pool = core::ThreadPool::instance())
       : inv_repo_(inv_repo), cust_repo_(cust_repo), discount_(disc), tax_(tax),
-        invoice_counter_(1) {}
+        pool_(pool), scheduler_(std::time(nullptr) - 1),
+        invoice_numbers_(inv_repo_.data_dir() + "/invoice_numbers.seq") {
+    // Resume the schedule for unpaid invoices already on disk
+    for (auto &b : inv_repo_.balances())
+      if (awaits_payment(b.status))
+        scheduler_.schedule(b.id, b.due_date);
+  }
 
   void add_observer(BillingObserver *obs) {
     std::lock_guard<std::mutex> lock(obs_mutex_);
@@ -71,13 +126,426 @@ public:
   // Factory method — create any invoice type
   // ==========================================================================
   models::Invoice create_invoice(const InvoiceRequest &req) {
-    auto cust_opt = cust_repo_.find_by_id(req.customer_id);
-    if (!cust_opt)
+    models::Invoice inv = build_invoice(req, core::generate_id());
+
+    inv_repo_.save(inv);
+    schedule(inv);
+    notify_created(inv);
+    return inv;
+  }
+
+  // ==========================================================================
+  // Batch generation as a staged pipeline over chunks of requests, run on
+  // the shared thread pool:
+  //   prefetch (customer lookups) -> price (discount + tax) -> number (one
+  //   ID block and one invoice-number block per chunk) -> commit (one
+  //   WriteBatch per chunk) -> events (scheduler + observers per chunk)
+  // Shared locks are taken once per chunk rather than once per invoice.
+  // A request that cannot be priced (unknown customer, bad input) is
+  // reported in `failures` with the reason; the rest go ahead. A failure
+  // to persist or publish stops the batch and is rethrown. IDs increase
+  // within a chunk; chunks priced in parallel may be numbered out of order.
+  // ==========================================================================
+  BatchResult batch_create(const std::vector<InvoiceRequest> &requests,
+                           const BatchOptions &opts = {}) {
+    return run_batch(requests, opts, {});
+  }
+
+  // Per-stage counters from the most recent batch_create
+  BatchStats last_batch_stats() const {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    return last_batch_;
+  }
+
+  // ==========================================================================
+  // Recurring: bill one cycle for each of `parent_ids` whose
+  // next_billing_date is at or before `billing_date`, through the
+  // batch_create pipeline. A child covers [next_billing_date, the following
+  // cycle) and carries no schedule of its own; its parent's
+  // next_billing_date moves to the end of that cycle in the same WriteBatch
+  // as the child, so a crash either bills and advances a parent or does
+  // neither. Parents that are not due (already billed, cancelled, not
+  // recurring, gone) are skipped, as are repeats of an id in
+  // `parent_ids`. Failures index into its first occurrence.
+  // on_commit(n) runs after each chunk of n children is durable.
+  // ==========================================================================
+  BatchResult bill_recurring(const std::vector<int64_t> &parent_ids,
+                             std::time_t billing_date,
+                             const BatchOptions &opts = {},
+                             std::function<void(std::size_t)> on_commit = {}) {
+    std::lock_guard<std::mutex> lock(recurring_mutex_);
+    std::unordered_map<int64_t, std::size_t> position;
+    for (std::size_t i = 0; i < parent_ids.size(); ++i)
+      position.emplace(parent_ids[i], i);
+    std::vector<InvoiceRequest> requests;
+    std::vector<std::size_t> source; // request -> index into parent_ids
+    std::unordered_set<int64_t> seen; // one cycle per parent per call
+    for (auto &p : inv_repo_.find_many(parent_ids)) {
+      if (!seen.insert(p.id).second ||
+          p.type != models::InvoiceType::RECURRING ||
+          p.status == models::InvoiceStatus::CANCELLED ||
+          p.next_billing_date == 0 || p.next_billing_date > billing_date)
+        continue;
+      InvoiceRequest req;
+      req.customer_id = p.customer_id;
+      req.type = models::InvoiceType::RECURRING;
+      req.period = p.period;
+      req.line_items = p.line_items;
+      req.currency = p.currency;
+      req.notes = "Auto-recurring from INV " + p.invoice_number;
+      req.parent_invoice_id = p.id;
+      req.period_start = p.next_billing_date;
+      req.period_end =
+          compute_next_billing(p.issue_date, p.next_billing_date, p.period);
+      requests.push_back(std::move(req));
+      source.push_back(position[p.id]);
+    }
+
+    CommitHooks hooks;
+    hooks.stage = [](const models::Invoice &child,
+                     repository::WriteBatch &batch) {
+      // Only next_billing_date is set, at commit, so a payment or overdue
+      // flag recorded meanwhile stays; a parent cancelled or advanced since
+      // it was read is left alone
+      batch.modify_invoice(
+          child.parent_invoice_id,
+          [from = child.period_start, to = child.period_end](
+              models::Invoice &parent) {
+            if (parent.status == models::InvoiceStatus::CANCELLED ||
+                parent.next_billing_date != from)
+              return false;
+            parent.next_billing_date = to;
+            return true;
+          });
+    };
+    hooks.committed = std::move(on_commit);
+    BatchResult out = run_batch(requests, opts, hooks);
+    for (auto &f : out.failures)
+      f.index = source[f.index];
+    std::sort(out.failures.begin(), out.failures.end(),
+              [](const BatchFailure &a, const BatchFailure &b) {
+                return a.index < b.index;
+              });
+    return out;
+  }
+
+  // Bill the parent's next cycle now, whatever its date, and advance it
+  std::optional<models::Invoice>
+  generate_next_recurring(const models::Invoice &parent) {
+    if (parent.type != models::InvoiceType::RECURRING)
+      return std::nullopt;
+    if (parent.next_billing_date == 0)
+      return std::nullopt;
+    BatchResult out = bill_recurring(
+        {parent.id}, std::numeric_limits<std::time_t>::max());
+    if (!out.failures.empty())
+      throw std::runtime_error(out.failures.front().reason);
+    if (out.invoices.empty())
+      return std::nullopt;
+    return std::move(out.invoices.front());
+  }
+
+  // Mark invoice as paid (or partially paid)
+  bool mark_paid(int64_t invoice_id, double amount_paid) {
+    auto opt = inv_repo_.find_by_id(invoice_id);
+    if (!opt)
+      return false;
+    auto inv = *opt;
+
+    inv.amount_paid += amount_paid;
+    if (inv.amount_paid >= inv.total_amount) {
+      inv.amount_paid = inv.total_amount;
+      inv.status = models::InvoiceStatus::PAID;
+      inv.paid_date = std::time(nullptr);
+      notify_paid(inv);
+    } else {
+      inv.status = models::InvoiceStatus::PARTIALLY_PAID;
+    }
+    inv_repo_.update(inv);
+    if (inv.status == models::InvoiceStatus::PAID)
+      unschedule(invoice_id);
+    return true;
+  }
+
+  // Flag invoices that fell due since the last sweep, as of `now` —
+  // O(expired), independent of how many invoices exist. The timing wheel
+  // hands over only ids whose due date passed since the previous sweep;
+  // their headers are checked without decoding, and the PENDING ones flip
+  // to OVERDUE under one repository lock in one log frame. Those still
+  // unpaid move to the backlog for next_due(); settled ones are dropped.
+  // Observers get the flagged ones in a single on_invoices_overdue call.
+  OverdueSweep sweep_overdue(std::time_t now = std::time(nullptr)) {
+    auto started = std::chrono::steady_clock::now();
+    std::vector<int64_t> expired;
+    std::vector<std::time_t> dues;
+    {
+      std::lock_guard<std::mutex> lock(sched_mutex_);
+      // Overdue means strictly past due, hence `now - 1`
+      scheduler_.advance(now - 1, [&](int64_t id, std::time_t due) {
+        expired.push_back(id);
+        dues.push_back(due);
+      });
+    }
+    // Invoices paid or cancelled since they were scheduled fail the check
+    std::vector<models::Invoice> flagged;
+    std::unordered_set<int64_t> unpaid; // as the repository saw them
+    try {
+      flagged = inv_repo_.modify_many(
+          expired,
+          [now, &unpaid](const repository::InvoiceRepository::Balance &b) {
+            if (!awaits_payment(b.status))
+              return false;
+            unpaid.insert(b.id);
+            return b.status == models::InvoiceStatus::PENDING &&
+                   b.is_overdue(now);
+          },
+          [](models::Invoice &inv) {
+            inv.status = models::InvoiceStatus::OVERDUE;
+          });
+    } catch (...) {
+      // A failed log append changes nothing, but a failure after it (the
+      // commit or a checkpoint) leaves the invoices flagged. So ask the
+      // repository: what it shows OVERDUE is announced and backlogged,
+      // other unpaid ids go back on the wheel, due at once, for the next
+      // sweep to retry, and settled ones are dropped.
+      std::unordered_set<int64_t> done;
+      unpaid.clear();
+      for (auto &inv : inv_repo_.find_many(expired)) {
+        if (inv.status == models::InvoiceStatus::OVERDUE) {
+          done.insert(inv.id);
+          flagged.push_back(std::move(inv));
+        } else if (awaits_payment(inv.status)) {
+          unpaid.insert(inv.id);
+        }
+      }
+      {
+        std::lock_guard<std::mutex> lock(sched_mutex_);
+        for (std::size_t i = 0; i < expired.size(); ++i) {
+          if (done.count(expired[i]))
+            backlog_handles_[expired[i]] =
+                due_backlog_.push(dues[i], expired[i]);
+          else if (unpaid.count(expired[i]))
+            scheduler_.schedule(expired[i], dues[i]);
+        }
+      }
+      if (!flagged.empty())
+        notify_overdue(flagged);
+      throw;
+    }
+    {
+      std::lock_guard<std::mutex> lock(sched_mutex_);
+      for (std::size_t i = 0; i < expired.size(); ++i)
+        if (unpaid.count(expired[i]))
+          backlog_handles_[expired[i]] =
+              due_backlog_.push(dues[i], expired[i]);
+    }
+    if (!flagged.empty())
+      notify_overdue(flagged);
+
+    OverdueSweep sweep;
+    sweep.expired = expired.size();
+    sweep.flagged = flagged.size();
+    sweep.ms = std::chrono::duration<double, std::milli>(
+                   std::chrono::steady_clock::now() - started)
+                   .count();
+    return sweep;
+  }
+
+  int flag_overdue() { return static_cast<int>(sweep_overdue().flagged); }
+
+  // Earliest-due unpaid invoice, left scheduled: the wheel is what flags
+  // it overdue, so a look must not take it off. Invoices flag_overdue
+  // already drained come first, in due order. Ids found settled are
+  // dropped on the way.
+  std::optional<models::Invoice> next_due() {
+    while (true) {
+      int64_t id;
+      {
+        std::lock_guard<std::mutex> lock(sched_mutex_);
+        if (!due_backlog_.empty())
+          id = due_backlog_.top().value;
+        else if (auto e = scheduler_.earliest())
+          id = e->id;
+        else
+          return std::nullopt;
+      }
+      auto inv = inv_repo_.find_by_id(id);
+      if (inv && awaits_payment(inv->status))
+        return inv;
+      unschedule(id);
+    }
+  }
+
+  std::size_t pending_in_scheduler() const {
+    std::lock_guard<std::mutex> lock(sched_mutex_);
+    return scheduler_.size() + due_backlog_.size();
+  }
+
+private:
+  // Extra work in batch_create's commit stage: stage() may add records to
+  // the chunk's WriteBatch for each created invoice, so they commit with
+  // it; committed(n) runs once the chunk's n invoices are durable
+  struct CommitHooks {
+    std::function<void(const models::Invoice &, repository::WriteBatch &)>
+        stage;
+    std::function<void(std::size_t)> committed;
+  };
+
+  BatchResult run_batch(const std::vector<InvoiceRequest> &requests,
+                        const BatchOptions &opts, const CommitHooks &hooks) {
+    if (opts.chunk_size == 0)
+      throw std::invalid_argument("BatchOptions chunk_size must be positive");
+    auto started = std::chrono::steady_clock::now();
+    std::vector<models::Invoice> results(requests.size());
+    std::vector<char> built(requests.size(), 0);
+    std::vector<BatchFailure> failures;
+    std::mutex failures_mutex;
+    std::atomic<std::size_t> created{0};
+    int price_workers = opts.price_workers > 0
+                            ? opts.price_workers
+                            : static_cast<int>(pool_.size());
+
+    core::Pipeline<BatchChunk> pipeline(pool_, opts.max_in_flight);
+    pipeline
+        .stage("prefetch", opts.prefetch_workers,
+               [&](BatchChunk &c) {
+                 c.customers.reserve(c.end - c.begin);
+                 for (std::size_t i = c.begin; i < c.end; ++i) {
+                   // Requests for one customer usually arrive together
+                   int64_t cid = requests[i].customer_id;
+                   if (i > c.begin && requests[i - 1].customer_id == cid)
+                     c.customers.push_back(c.customers.back());
+                   else
+                     c.customers.push_back(cust_repo_.find_shared(cid));
+                 }
+                 return c.end - c.begin;
+               })
+        .stage("price", price_workers,
+               [&](BatchChunk &c) {
+                 for (std::size_t i = c.begin; i < c.end; ++i) {
+                   const auto &cust = c.customers[i - c.begin];
+                   if (!cust) {
+                     c.failures.push_back({i, "Customer not found"});
+                     continue;
+                   }
+                   try {
+                     results[i] = price_invoice(requests[i], *cust);
+                     built[i] = 1;
+                     c.built++;
+                   } catch (const std::exception &e) {
+                     c.failures.push_back({i, e.what()});
+                   }
+                 }
+                 c.customers.clear();
+                 if (!c.failures.empty()) {
+                   std::lock_guard<std::mutex> lock(failures_mutex);
+                   failures.insert(failures.end(), c.failures.begin(),
+                                   c.failures.end());
+                 }
+                 return c.built;
+               })
+        .stage("number", opts.number_workers,
+               [&](BatchChunk &c) {
+                 if (c.built == 0)
+                   return std::size_t{0};
+                 auto &gen = core::SnowflakeGenerator::instance();
+                 core::IdBlock ids = gen.reserve(c.built);
+                 auto numbers = invoice_numbers_.reserve(c.built);
+                 std::size_t k = 0;
+                 for (std::size_t i = c.begin; i < c.end; ++i) {
+                   if (!built[i])
+                     continue;
+                   results[i].id = ids.at(k);
+                   results[i].invoice_number = numbers.str(k, INVOICE_PREFIX);
+                   k++;
+                 }
+                 return c.built;
+               })
+        .stage("commit", opts.commit_workers,
+               [&](BatchChunk &c) {
+                 repository::WriteBatch batch;
+                 for (std::size_t i = c.begin; i < c.end; ++i) {
+                   if (!built[i])
+                     continue;
+                   batch.save(results[i]);
+                   if (hooks.stage)
+                     hooks.stage(results[i], batch);
+                 }
+                 batch.commit(inv_repo_);
+                 created.fetch_add(c.built);
+                 if (hooks.committed)
+                   hooks.committed(c.built);
+                 return c.built;
+               })
+        .stage("events", opts.event_workers, [&](BatchChunk &c) {
+          {
+            std::lock_guard<std::mutex> lock(sched_mutex_);
+            for (std::size_t i = c.begin; i < c.end; ++i)
+              if (built[i])
+                scheduler_.schedule(results[i].id, results[i].due_date);
+          }
+          std::lock_guard<std::mutex> lock(obs_mutex_);
+          for (std::size_t i = c.begin; i < c.end; ++i)
+            if (built[i])
+              for (auto *obs : observers_)
+                obs->on_invoice_created(results[i]);
+          return c.built;
+        });
+
+    auto record = [&] {
+      BatchStats stats;
+      stats.requests = requests.size();
+      stats.created = created.load();
+      stats.wall_ms = std::chrono::duration<double, std::milli>(
+                          std::chrono::steady_clock::now() - started)
+                          .count();
+      stats.stages = pipeline.stats();
+      std::lock_guard<std::mutex> lock(stats_mutex_);
+      last_batch_ = std::move(stats);
+    };
+    try {
+      pipeline.run([&](auto push) {
+        for (std::size_t b = 0; b < requests.size(); b += opts.chunk_size) {
+          std::size_t e = std::min(requests.size(), b + opts.chunk_size);
+          if (!push(BatchChunk{b, e, {}, 0, {}}))
+            break;
+        }
+      });
+    } catch (...) {
+      record();
+      throw;
+    }
+    record();
+
+    BatchResult out;
+    out.invoices.reserve(created.load());
+    for (std::size_t i = 0; i < results.size(); ++i)
+      if (built[i])
+        out.invoices.push_back(std::move(results[i]));
+    std::sort(failures.begin(), failures.end(),
+              [](const BatchFailure &a, const BatchFailure &b) {
+                return a.index < b.index;
+              });
+    out.failures = std::move(failures);
+    return out;
+  }
+
+  // Price and number an invoice without persisting or publishing it
+  models::Invoice build_invoice(const InvoiceRequest &req, int64_t id) {
+    auto cust_ptr = cust_repo_.find_shared(req.customer_id);
+    if (!cust_ptr)
       throw std::runtime_error("Customer not found");
-    const models::Customer &cust = *cust_opt;
+    models::Invoice inv = price_invoice(req, *cust_ptr);
+    inv.id = id;
+    inv.invoice_number = generate_invoice_number();
+    return inv;
+  }
 
+  // Everything but the id and invoice number; touches no shared state
+  // beyond the (read-only) discount and tax engines
+  models::Invoice price_invoice(const InvoiceRequest &req,
+                                const models::Customer &cust) {
     models::Invoice inv;
-    inv.id = core::generate_id();
     inv.customer_id = req.customer_id;
     inv.parent_invoice_id = req.parent_invoice_id;
     inv.type = req.type;
@@ -91,9 +559,6 @@ public:
     inv.amount_paid = 0.0;
     inv.paid_date = 0;
 
-    // Generate human-readable invoice number
-    inv.invoice_number = generate_invoice_number();
-
     // Compute subtotal from line items
     inv.subtotal = 0.0;
     for (const auto &li : inv.line_items)
@@ -128,144 +593,67 @@ public:
     inv.due_date =
         inv.issue_date + static_cast<std::time_t>(req.due_days) * 86400;
 
-    // Next billing date for recurring
-    if (req.type == models::InvoiceType::RECURRING)
-      inv.next_billing_date = compute_next_billing(inv.issue_date, req.period);
+    // Only the root of a recurring chain carries the schedule; children
+    // record the cycle they bill in period_start/period_end
+    if (req.type == models::InvoiceType::RECURRING && !req.parent_invoice_id)
+      inv.next_billing_date =
+          compute_next_billing(inv.issue_date, inv.issue_date, req.period);
     else
       inv.next_billing_date = 0;
 
-    // Push to payment scheduler
-    scheduler_.push(inv);
-
-    inv_repo_.save(inv);
-    notify_created(inv);
     return inv;
   }
 
-  // ==========================================================================
-  // Batch generation with multi-threading
-  // ==========================================================================
-  std::vector<models::Invoice>
-  batch_create(const std::vector<InvoiceRequest> &requests,
-               int num_threads = 4) {
-    std::vector<models::Invoice> results(requests.size());
-    std::mutex result_mutex;
-    std::vector<std::thread> threads;
-    std::atomic<std::size_t> idx{0};
-
-    auto worker = [&]() {
-      while (true) {
-        std::size_t i = idx.fetch_add(1);
-        if (i >= requests.size())
-          break;
-        try {
-          auto inv = create_invoice(requests[i]);
-          std::lock_guard<std::mutex> lk(result_mutex);
-          results[i] = inv;
-        } catch (...) {
-        }
-      }
-    };
-
-    for (int t = 0; t < num_threads; ++t)
-      threads.emplace_back(worker);
-    for (auto &th : threads)
-      th.join();
-
-    return results;
+  // Unit of work in batch_create: requests [begin, end)
+  struct BatchChunk {
+    std::size_t begin;
+    std::size_t end;
+    std::vector<repository::CustomerPtr> customers; // filled by prefetch
+    std::size_t built;                               // priced successfully
+    std::vector<BatchFailure> failures;
+  };
+
+  static bool awaits_payment(models::InvoiceStatus s) {
+    return s == models::InvoiceStatus::PENDING ||
+           s == models::InvoiceStatus::PARTIALLY_PAID ||
+           s == models::InvoiceStatus::OVERDUE;
   }
 
-  // ==========================================================================
-  // Recurring: generate next invoice in chain
-  // ==========================================================================
-  std::optional<models::Invoice>
-  generate_next_recurring(const models::Invoice &parent) {
-    if (parent.type != models::InvoiceType::RECURRING)
-      return std::nullopt;
-    if (parent.next_billing_date == 0)
-      return std::nullopt;
-
-    InvoiceRequest req;
-    req.customer_id = parent.customer_id;
-    req.type = models::InvoiceType::RECURRING;
-    req.period = parent.period;
-    req.line_items = parent.line_items;
-    req.currency = parent.currency;
-    req.notes = "Auto-recurring from INV " + parent.invoice_number;
-    req.parent_invoice_id = parent.id;
-    req.due_days = 30;
-
-    return create_invoice(req);
-  }
-
-  // Mark invoice as paid (or partially paid)
-  bool mark_paid(int64_t invoice_id, double amount_paid) {
-    auto opt = inv_repo_.find_by_id(invoice_id);
-    if (!opt)
-      return false;
-    auto inv = *opt;
-
-    inv.amount_paid += amount_paid;
-    if (inv.amount_paid >= inv.total_amount) {
-      inv.amount_paid = inv.total_amount;
-      inv.status = models::InvoiceStatus::PAID;
-      inv.paid_date = std::time(nullptr);
-      notify_paid(inv);
-    } else {
-      inv.status = models::InvoiceStatus::PARTIALLY_PAID;
-    }
-    inv_repo_.update(inv);
-    return true;
+  void schedule(const models::Invoice &inv) {
+    std::lock_guard<std::mutex> lock(sched_mutex_);
+    scheduler_.schedule(inv.id, inv.due_date);
   }
 
-  // Scan and flag overdue invoices — O(n)
-  int flag_overdue() {
-    auto all = inv_repo_.find_all();
-    int count = 0;
-    for (auto &inv : all) {
-      if (inv.status == models::InvoiceStatus::PENDING && inv.is_overdue()) {
-        inv.status = models::InvoiceStatus::OVERDUE;
-        inv_repo_.update(inv);
-        notify_overdue(inv);
-        count++;
-      }
-    }
-    return count;
+  // Drop an invoice from the wheel or, once expired, from the backlog
+  void unschedule(int64_t invoice_id) {
+    std::lock_guard<std::mutex> lock(sched_mutex_);
+    if (scheduler_.cancel(invoice_id))
+      return;
+    auto it = backlog_handles_.find(invoice_id);
+    if (it == backlog_handles_.end())
+      return;
+    due_backlog_.erase(it->second);
+    backlog_handles_.erase(it);
   }
 
-  // Next payment due (from min-heap scheduler)
-  std::optional<models::Invoice> next_due() {
-    if (scheduler_.empty())
-      return std::nullopt;
-    return scheduler_.pop();
-  }
-
-  std::size_t pending_in_scheduler() const { return scheduler_.size(); }
-
-private:
   std::string generate_invoice_number() {
-    std::lock_guard<std::mutex> lock(counter_mutex_);
-    std::time_t now = std::time(nullptr);
-    std::tm *t = std::localtime(&now);
-    char buf[32];
-    std::strftime(buf, sizeof(buf), "INV-%Y%m", t);
-    std::string num = std::to_string(invoice_counter_++);
-    while (num.size() < 4)
-      num = "0" + num;
-    return std::string(buf) + num;
+    return invoice_numbers_.reserve(1).str(0, INVOICE_PREFIX);
   }
 
-  static std::time_t compute_next_billing(std::time_t from,
+  // Start of the cycle after the one starting at `from`, in local calendar
+  // terms. Monthly and yearly cycles stay on the day of the month `anchor`
+  // (the chain's first issue date) fell on, clamped to short months.
+  static std::time_t compute_next_billing(std::time_t anchor, std::time_t from,
                                           models::RecurringPeriod period) {
     switch (period) {
     case models::RecurringPeriod::DAILY:
-      return from + 86400;
+      return core::add_days(from, 1);
     case models::RecurringPeriod::WEEKLY:
-      return from + 7 * 86400;
+      return core::add_days(from, 7);
     case models::RecurringPeriod::MONTHLY:
-      return from + 30 * 86400;
+      return core::add_months(from, 1, core::day_of_month(anchor));
     case models::RecurringPeriod::YEARLY:
-      return from + 365 * 86400;
+      return core::add_months(from, 12, core::day_of_month(anchor));
     default:
       return 0;
     }
@@ -281,26 +669,40 @@ private:
     for (auto *obs : observers_)
       obs->on_invoice_paid(inv);
   }
-  void notify_overdue(const models::Invoice &inv) {
+  void notify_overdue(const std::vector<models::Invoice> &invs) {
     std::lock_guard<std::mutex> lock(obs_mutex_);
     for (auto *obs : observers_)
-      obs->on_invoice_overdue(inv);
+      obs->on_invoices_overdue(invs);
   }
 
   repository::InvoiceRepository &inv_repo_;
   repository::CustomerRepository &cust_repo_;
   DiscountEngine &discount_;
   TaxEngine &tax_;
-
-  // Min-heap: schedules invoices by due_date (C++17-compatible named
-  // comparator)
-  core::MinHeap<models::Invoice, InvoiceDueCompare> scheduler_;
+  core::ThreadPool &pool_;
+
+  // Timing wheel of unpaid invoice ids by due_date; ids it has expired wait
+  // in due_backlog_, a (due_date, id) heap, for next_due(). The wheel's
+  // clock trails wall time by a second so past-due invoices, which land on
+  // the current tick, are strictly overdue by the first flag_overdue().
+  core::TimingWheel<int64_t> scheduler_;
+  core::IndexedHeap<std::time_t, int64_t> due_backlog_;
+  std::unordered_map<int64_t, core::IndexedHeap<std::time_t, int64_t>::Handle>
+      backlog_handles_;
+  mutable std::mutex sched_mutex_;
 
   std::vector<BillingObserver *> observers_;
   std::mutex obs_mutex_;
 
-  std::atomic<int> invoice_counter_;
-  std::mutex counter_mutex_;
+  // One recurring billing pass at a time, so a cycle is billed once
+  std::mutex recurring_mutex_;
+
+  // INV-YYYYMMnnnn: restarts each month, persisted next to the invoices
+  static constexpr std::string_view INVOICE_PREFIX = "INV-";
+  core::MonthlySequence invoice_numbers_;
+
+  BatchStats last_batch_;
+  mutable std::mutex stats_mutex_;
 };
 
 } // namespace service
@@ -6,10 +6,12 @@
 #include "../core/snowflake.hpp"
 #include "../models/customer.hpp"
 #include "../repository/customer_repository.hpp"
+#include "../repository/write_batch.hpp"
 #include <ctime>
 #include <optional>
 #include <stdexcept>
 #include <string>
+#include <unordered_set>
 #include <vector>
 
 namespace billing::service {
@@ -32,30 +34,34 @@ public:
   models::Customer create(const CustomerCreateRequest &req) {
     if (req.name.empty() || req.email.empty())
       throw std::invalid_argument("Name and email are required");
-    if (repo_.find_by_email(req.email))
+    if (repo_.email_taken(req.email))
       throw std::runtime_error("Email already registered: " + req.email);
 
-    models::Customer c;
-    c.id = core::generate_id();
-    c.name = req.name;
-    c.email = req.email;
-    c.phone = req.phone;
-    c.address = req.address;
-    c.country = req.country;
-    c.state = req.state;
-    c.tier = models::CustomerTier::BRONZE;
-    c.status = models::CustomerStatus::ACTIVE;
-    c.credit_score = 650; // default neutral score
-    c.credit_limit = compute_credit_limit(c.credit_score, c.tier);
-    c.current_balance = 0.0;
-    c.total_spent = 0.0;
-    c.created_at = std::time(nullptr);
-    c.updated_at = c.created_at;
-
+    models::Customer c = build_customer(req);
     repo_.save(c);
     return c;
   }
 
+  // Bulk onboarding — invalid or duplicate requests are skipped, the rest
+  // are committed with a single WriteBatch
+  std::vector<models::Customer>
+  create_many(const std::vector<CustomerCreateRequest> &reqs) {
+    std::vector<models::Customer> created;
+    std::unordered_set<std::string> seen;
+    repository::WriteBatch batch;
+    for (const auto &req : reqs) {
+      if (req.name.empty() || req.email.empty())
+        continue;
+      auto key = repository::CustomerRepository::normalize_email(req.email);
+      if (!seen.insert(key).second || repo_.email_taken(key))
+        continue;
+      created.push_back(build_customer(req));
+      batch.save(created.back());
+    }
+    batch.commit(repo_);
+    return created;
+  }
+
   std::optional<models::Customer> get(int64_t id) {
     return repo_.find_by_id(id);
   }
@@ -73,56 +79,43 @@ public:
   // Update basic profile fields
   bool update_profile(int64_t id, const std::string &name,
                       const std::string &phone, const std::string &address) {
-    auto opt = repo_.find_by_id(id);
-    if (!opt)
-      return false;
-    auto c = *opt;
-    c.name = name;
-    c.phone = phone;
-    c.address = address;
-    c.updated_at = std::time(nullptr);
-    return repo_.update(c);
+    return repo_.modify(id, [&](models::Customer &c) {
+      c.name = name;
+      c.phone = phone;
+      c.address = address;
+      c.updated_at = std::time(nullptr);
+    });
   }
 
   // Recalculate credit score and auto-adjust tier + limit
   bool recalculate_credit(int64_t id, double payment_amount, bool on_time) {
-    auto opt = repo_.find_by_id(id);
-    if (!opt)
-      return false;
-    auto c = *opt;
-
-    // Weighted credit score adjustment
-    int delta = on_time ? +5 : -15;
-    if (payment_amount > 1000)
-      delta += on_time ? +3 : -5;
-    c.credit_score = std::max(300, std::min(850, c.credit_score + delta));
-    c.total_spent += payment_amount;
-
-    // Auto-tier upgrade/downgrade
-    c.tier = models::Customer::compute_tier(c.total_spent);
-    c.credit_limit = compute_credit_limit(c.credit_score, c.tier);
-    c.updated_at = std::time(nullptr);
-    return repo_.update(c);
+    return repo_.modify(id, [&](models::Customer &c) {
+      // Weighted credit score adjustment
+      int delta = on_time ? +5 : -15;
+      if (payment_amount > 1000)
+        delta += on_time ? +3 : -5;
+      c.credit_score = std::max(300, std::min(850, c.credit_score + delta));
+      c.total_spent += payment_amount;
+
+      // Auto-tier upgrade/downgrade
+      c.tier = models::Customer::compute_tier(c.total_spent);
+      c.credit_limit = compute_credit_limit(c.credit_score, c.tier);
+      c.updated_at = std::time(nullptr);
+    });
   }
 
   bool suspend(int64_t id) {
-    auto opt = repo_.find_by_id(id);
-    if (!opt)
-      return false;
-    auto c = *opt;
-    c.status = models::CustomerStatus::SUSPENDED;
-    c.updated_at = std::time(nullptr);
-    return repo_.update(c);
+    return repo_.modify(id, [](models::Customer &c) {
+      c.status = models::CustomerStatus::SUSPENDED;
+      c.updated_at = std::time(nullptr);
+    });
   }
 
   bool activate(int64_t id) {
-    auto opt = repo_.find_by_id(id);
-    if (!opt)
-      return false;
-    auto c = *opt;
-    c.status = models::CustomerStatus::ACTIVE;
-    c.updated_at = std::time(nullptr);
-    return repo_.update(c);
+    return repo_.modify(id, [](models::Customer &c) {
+      c.status = models::CustomerStatus::ACTIVE;
+      c.updated_at = std::time(nullptr);
+    });
   }
 
   bool remove(int64_t id) { return repo_.remove(id); }
@@ -152,6 +145,27 @@ public:
   }
 
 private:
+  static models::Customer build_customer(const CustomerCreateRequest &req) {
+    models::Customer c;
+    c.id = core::generate_id();
+    c.name = req.name;
+    c.email = req.email;
+    c.phone = req.phone;
+    c.address = req.address;
+    c.country = req.country;
+    c.state = req.state;
+    c.tier = models::CustomerTier::BRONZE;
+    c.status = models::CustomerStatus::ACTIVE;
+    c.credit_score = 650; // default neutral score
+    c.credit_limit = compute_credit_limit(c.credit_score, c.tier);
+    c.current_balance = 0.0;
+    c.total_spent = 0.0;
+    c.created_at = std::time(nullptr);
+    c.updated_at = c.created_at;
+
+    return c;
+  }
+
   repository::CustomerRepository &repo_;
 };
 
@@ -9,6 +9,8 @@
 #include <algorithm>
 #include <ctime>
 #include <functional>
+#include <memory>
+#include <memory_resource>
 #include <string>
 #include <vector>
 
@@ -117,6 +119,22 @@ public:
     return result;
   }
 
+  // Same, with the list and its strings allocated from `mr` (e.g. a
+  // per-request arena)
+  std::pmr::vector<std::pmr::string>
+  applicable_rules(const models::Customer &c, const models::Invoice &inv,
+                   std::pmr::memory_resource *mr) const {
+    std::pmr::vector<std::pmr::string> result(mr);
+    for (const auto &rule : rules_) {
+      if (!rule.condition(c, inv))
+        continue;
+      auto &desc = result.emplace_back(rule.condition_desc);
+      desc += " → ";
+      desc += rule.strategy->name();
+    }
+    return result;
+  }
+
 private:
   void sort_rules() {
     std::sort(rules_.begin(), rules_.end(),
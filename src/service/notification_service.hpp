@@ -3,13 +3,17 @@
 // notification_service.hpp — Priority Queue + State Machine Escalation Engine
 // Design Pattern: Observer (BillingObserver), State Machine
 // Complexity: Enqueue O(log n), Dequeue O(log n)
+// Multi-threading: dispatch_all sends on the shared core::ThreadPool
 // =============================================================================
 #include "../core/snowflake.hpp"
+#include "../core/thread_pool.hpp"
 #include "../models/invoice.hpp"
 #include "../models/notification.hpp"
 #include "../service/billing_engine.hpp"
+#include <algorithm>
 #include <ctime>
 #include <functional>
+#include <future>
 #include <iostream>
 #include <mutex>
 #include <queue>
@@ -30,7 +34,9 @@ struct NotificationCompare {
 
 class NotificationService : public BillingObserver {
 public:
-  NotificationService() {}
+  explicit NotificationService(
+      core::ThreadPool &pool = core::ThreadPool::instance())
+      : pool_(pool) {}
 
   // Enqueue a notification — O(log n)
   void enqueue(const models::Notification &n) {
@@ -53,14 +59,48 @@ public:
     return n;
   }
 
-  // Dispatch all queued notifications
+  // Dispatch all queued notifications. The queue is drained in priority
+  // order, then channel sends run as pool tasks in batches of DISPATCH_BATCH.
+  // A send that throws marks its notification FAILED rather than losing the
+  // rest; failed ones land in the sent log too. Returns the number sent.
   int dispatch_all() {
-    int count = 0;
-    while (!queue_.empty()) {
-      dispatch_next();
-      count++;
+    static constexpr std::size_t DISPATCH_BATCH = 64;
+    std::vector<models::Notification> batch;
+    {
+      std::lock_guard<std::mutex> lock(queue_mutex_);
+      batch.reserve(queue_.size());
+      while (!queue_.empty()) {
+        batch.push_back(queue_.top());
+        queue_.pop();
+      }
     }
-    return count;
+
+    std::vector<std::future<void>> sends;
+    for (std::size_t b = 0; b < batch.size(); b += DISPATCH_BATCH) {
+      std::size_t e = std::min(batch.size(), b + DISPATCH_BATCH);
+      sends.push_back(pool_.submit([this, &batch, b, e] {
+        for (std::size_t i = b; i < e; ++i) {
+          try {
+            dispatch_channel(batch[i]);
+            batch[i].status = models::NotificationStatus::SENT;
+          } catch (const std::exception &) {
+            batch[i].status = models::NotificationStatus::FAILED;
+          }
+          batch[i].sent_at = std::time(nullptr);
+        }
+      }));
+    }
+    pool_.wait_all(sends);
+    for (auto &s : sends)
+      s.get();
+
+    int sent = 0;
+    std::lock_guard<std::mutex> lock(queue_mutex_);
+    for (auto &n : batch) {
+      sent += n.status == models::NotificationStatus::SENT;
+      sent_log_.push_back(std::move(n));
+    }
+    return sent;
   }
 
   // =========================================================================
@@ -146,6 +186,28 @@ public:
   }
 
   void on_invoice_overdue(const models::Invoice &inv) override {
+    enqueue(overdue_notice(inv, std::time(nullptr)));
+    // Trigger escalation
+    auto state = get_escalation_state(inv.customer_id);
+    escalate(inv.customer_id, state);
+  }
+
+  // A sweep's notices go on the queue under one lock; escalation still
+  // advances once per overdue invoice, as for single events
+  void on_invoices_overdue(const std::vector<models::Invoice> &invs) override {
+    std::time_t now = std::time(nullptr);
+    {
+      std::lock_guard<std::mutex> lock(queue_mutex_);
+      for (const auto &inv : invs)
+        queue_.push(overdue_notice(inv, now));
+    }
+    for (const auto &inv : invs)
+      escalate(inv.customer_id, get_escalation_state(inv.customer_id));
+  }
+
+private:
+  static models::Notification overdue_notice(const models::Invoice &inv,
+                                             std::time_t now) {
     models::Notification n;
     n.id = core::generate_id();
     n.customer_id = inv.customer_id;
@@ -156,14 +218,10 @@ public:
     n.subject = "OVERDUE: " + inv.invoice_number;
     n.body = "Invoice " + inv.invoice_number + " is overdue! Amount due: $" +
              std::to_string(inv.amount_due());
-    n.created_at = std::time(nullptr);
-    enqueue(n);
-    // Trigger escalation
-    auto state = get_escalation_state(inv.customer_id);
-    escalate(inv.customer_id, state);
+    n.created_at = now;
+    return n;
   }
 
-private:
   void dispatch_channel(const models::Notification &n) {
     // Simulation — in production: call SMS/email API
     std::string channel;
@@ -244,6 +302,7 @@ private:
   mutable std::mutex queue_mutex_;
   std::unordered_map<int64_t, models::EscalationState> escalation_states_;
   std::vector<models::Notification> sent_log_;
+  core::ThreadPool &pool_;
 };
 
 } // namespace billing::service
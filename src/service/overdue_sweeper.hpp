@@ -0,0 +1,104 @@
+#pragma once
+// =============================================================================
+// overdue_sweeper.hpp — Periodic Overdue Sweep
+// Used for: Running BillingEngine::sweep_overdue on a fixed interval (every
+// minute by default) so invoices turn OVERDUE soon after their due date
+// Complexity: O(expired) per sweep — see BillingEngine::sweep_overdue
+// Multi-threading: one background timer thread; observers are called from
+// it, so they must tolerate being called off the main thread
+// =============================================================================
+#include "billing_engine.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+
+namespace billing::service {
+
+class OverdueSweeper {
+public:
+  explicit OverdueSweeper(
+      BillingEngine &engine,
+      std::chrono::milliseconds interval = std::chrono::minutes(1))
+      : engine_(engine), interval_(interval) {}
+
+  ~OverdueSweeper() { stop(); }
+
+  OverdueSweeper(const OverdueSweeper &) = delete;
+  OverdueSweeper &operator=(const OverdueSweeper &) = delete;
+
+  // Sweep now, then every interval until stop()
+  void start() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (thread_.joinable())
+      return;
+    stop_ = false;
+    thread_ = std::thread([this] { loop(); });
+  }
+
+  void stop() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    wake_.notify_all();
+    if (thread_.joinable())
+      thread_.join();
+  }
+
+  // One sweep on the calling thread, counted with the periodic ones
+  OverdueSweep sweep_now() {
+    OverdueSweep s = engine_.sweep_overdue();
+    std::lock_guard<std::mutex> lock(mutex_);
+    sweeps_++;
+    flagged_ += s.flagged;
+    last_ = s;
+    return s;
+  }
+
+  std::size_t sweeps() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return sweeps_;
+  }
+  std::size_t flagged() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return flagged_;
+  }
+  OverdueSweep last() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return last_;
+  }
+  std::size_t errors() const { return errors_.load(); }
+
+private:
+  void loop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stop_) {
+      lock.unlock();
+      try {
+        sweep_now();
+      } catch (const std::exception &) {
+        // The failed sweep's ids went back on the wheel; the next retries
+        errors_++;
+      }
+      lock.lock();
+      wake_.wait_for(lock, interval_, [&] { return stop_; });
+    }
+  }
+
+  BillingEngine &engine_;
+  std::chrono::milliseconds interval_;
+
+  mutable std::mutex mutex_; // guards everything below but errors_
+  std::condition_variable wake_;
+  std::thread thread_;
+  bool stop_ = false;
+  std::size_t sweeps_ = 0;
+  std::size_t flagged_ = 0;
+  OverdueSweep last_;
+  std::atomic<std::size_t> errors_{0};
+};
+
+} // namespace billing::service
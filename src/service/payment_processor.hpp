@@ -234,9 +234,7 @@ public:
     pay_repo_.update(pay);
 
     // Update invoice status back
-    auto inv_opt = inv_repo_.find_by_id(pay.invoice_id);
-    if (inv_opt) {
-      auto inv = *inv_opt;
+    inv_repo_.modify(pay.invoice_id, [&](models::Invoice &inv) {
       inv.amount_paid -= amount;
       if (inv.amount_paid <= 0) {
         inv.amount_paid = 0;
@@ -244,8 +242,7 @@ public:
       } else {
         inv.status = models::InvoiceStatus::PARTIALLY_PAID;
       }
-      inv_repo_.update(inv);
-    }
+    });
 
     return {true, "Refund of $" + std::to_string(amount) + " processed", ref};
   }
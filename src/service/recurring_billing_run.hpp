@@ -0,0 +1,173 @@
+#pragma once
+// =============================================================================
+// recurring_billing_run.hpp — Recurring Billing Cycle Run
+// Used for: Billing every recurring invoice due on a billing date in one
+// pass, resumable after an interruption without billing a cycle twice
+// Complexity: O(log n + due) per pass via the next_billing_date index;
+// one pass per cycle the furthest-behind parent is missing
+// Multi-threading: children are generated by BillingEngine's batch
+// pipeline on the shared core::ThreadPool
+// =============================================================================
+#include "../repository/invoice_repository.hpp"
+#include "billing_engine.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace billing::service {
+
+struct RecurringFailure {
+  int64_t parent_id;
+  std::string reason;
+};
+
+struct RecurringRunStats {
+  std::time_t billing_date = 0;
+  std::size_t passes = 0;  // each bills at most one cycle per parent
+  std::size_t created = 0; // children, including those before a resume
+  std::vector<RecurringFailure> failures; // parents left unbilled
+  bool resumed = false;
+  double wall_ms = 0.0;
+};
+
+// A run bills, for every recurring parent with next_billing_date <= the
+// billing date, each cycle it is due for: a pass bills one cycle for every
+// due parent, and passes repeat until none is due, so a parent several
+// cycles behind catches up.
+//
+// Every chunk of children commits in one WriteBatch together with the
+// advanced parents (see BillingEngine::bill_recurring), so the repository
+// itself never holds a billed cycle that a later pass would bill again.
+// The checkpoint file beside the invoices records the billing date and
+// progress of the run in flight. It is removed when the run completes, so
+// one left behind marks an interrupted run: resume() finishes it, and
+// run() refuses a different date until then.
+class RecurringBillingRun {
+public:
+  RecurringBillingRun(BillingEngine &engine,
+                      repository::InvoiceRepository &inv_repo,
+                      BatchOptions opts = {})
+      : engine_(engine), inv_repo_(inv_repo), opts_(opts),
+        checkpoint_file_(inv_repo.data_dir() + "/recurring_run.ckpt") {}
+
+  // Called with the run's child count after each chunk is durable
+  void on_progress(std::function<void(std::size_t)> fn) {
+    progress_ = std::move(fn);
+  }
+
+  RecurringRunStats run(std::time_t billing_date) {
+    auto prior = load_checkpoint();
+    if (prior && prior->billing_date != billing_date)
+      throw std::runtime_error("Unfinished recurring run for another billing "
+                               "date; resume() it first");
+    return execute(billing_date, prior);
+  }
+
+  // Finish an interrupted run, if there is one
+  std::optional<RecurringRunStats> resume() {
+    auto prior = load_checkpoint();
+    if (!prior)
+      return std::nullopt;
+    return execute(prior->billing_date, prior);
+  }
+
+  // Billing date of an interrupted run, if any
+  std::optional<std::time_t> pending() const {
+    auto prior = load_checkpoint();
+    if (!prior)
+      return std::nullopt;
+    return prior->billing_date;
+  }
+
+private:
+  RecurringRunStats execute(std::time_t billing_date,
+                            const std::optional<RecurringRunStats> &prior) {
+    auto started = std::chrono::steady_clock::now();
+    RecurringRunStats stats;
+    if (prior) {
+      stats = *prior;
+      stats.resumed = true;
+    }
+    stats.billing_date = billing_date;
+    save_checkpoint(stats);
+
+    std::mutex stats_mutex; // commit workers report concurrently
+    std::unordered_set<int64_t> failed;
+    while (true) {
+      std::vector<int64_t> due = inv_repo_.billing_due_ids(billing_date);
+      if (!failed.empty())
+        due.erase(std::remove_if(due.begin(), due.end(),
+                                 [&](int64_t id) { return failed.count(id); }),
+                  due.end());
+      if (due.empty())
+        break;
+      BatchResult out = engine_.bill_recurring(
+          due, billing_date, opts_, [&](std::size_t n) {
+            std::size_t created;
+            {
+              std::lock_guard<std::mutex> lock(stats_mutex);
+              stats.created += n;
+              created = stats.created;
+              save_checkpoint(stats);
+            }
+            if (progress_)
+              progress_(created);
+          });
+      stats.passes++;
+      for (auto &f : out.failures) {
+        failed.insert(due[f.index]);
+        stats.failures.push_back({due[f.index], f.reason});
+      }
+      save_checkpoint(stats);
+      if (out.invoices.empty())
+        break;
+    }
+
+    std::remove(checkpoint_file_.c_str());
+    stats.wall_ms = std::chrono::duration<double, std::milli>(
+                        std::chrono::steady_clock::now() - started)
+                        .count();
+    return stats;
+  }
+
+  // One line: billing_date passes created (temp file + rename)
+  void save_checkpoint(const RecurringRunStats &stats) const {
+    std::string tmp = checkpoint_file_ + ".tmp";
+    {
+      std::ofstream f(tmp, std::ios::trunc);
+      f << static_cast<long long>(stats.billing_date) << ' ' << stats.passes
+        << ' ' << stats.created << '\n';
+      if (!f)
+        throw std::runtime_error("Cannot write checkpoint: " + tmp);
+    }
+    if (std::rename(tmp.c_str(), checkpoint_file_.c_str()) != 0)
+      throw std::runtime_error("Cannot write checkpoint: " + checkpoint_file_);
+  }
+
+  std::optional<RecurringRunStats> load_checkpoint() const {
+    std::ifstream f(checkpoint_file_);
+    long long date;
+    RecurringRunStats stats;
+    if (!(f >> date >> stats.passes >> stats.created))
+      return std::nullopt;
+    stats.billing_date = static_cast<std::time_t>(date);
+    return stats;
+  }
+
+  BillingEngine &engine_;
+  repository::InvoiceRepository &inv_repo_;
+  BatchOptions opts_;
+  std::string checkpoint_file_;
+  std::function<void(std::size_t)> progress_;
+};
+
+} // namespace billing::service
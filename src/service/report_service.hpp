@@ -3,7 +3,10 @@
 // report_service.hpp — Reporting & Analytics Service
 // Features: Aging (bucket sort), Revenue forecasting (SMA), CLV, CSV/JSON
 // export
+// Multi-threading: CLV and export_all run on the shared core::ThreadPool
 // =============================================================================
+#include "../core/memory_resource.hpp"
+#include "../core/thread_pool.hpp"
 #include "../models/customer.hpp"
 #include "../models/invoice.hpp"
 #include "../models/payment.hpp"
@@ -14,8 +17,9 @@
 #include <cmath>
 #include <ctime>
 #include <fstream>
+#include <future>
 #include <iomanip>
-#include <map>
+#include <memory_resource>
 #include <numeric>
 #include <sstream>
 #include <stdexcept>
@@ -55,78 +59,95 @@ public:
   ReportService(repository::InvoiceRepository &inv_repo,
                 repository::CustomerRepository &cust_repo,
                 repository::PaymentRepository &pay_repo,
-                const std::string &export_dir)
+                const std::string &export_dir,
+                core::ThreadPool &pool = core::ThreadPool::instance())
       : inv_repo_(inv_repo), cust_repo_(cust_repo), pay_repo_(pay_repo),
-        export_dir_(export_dir) {}
+        export_dir_(export_dir), pool_(pool) {}
+
+  // Report builders take a `scratch` resource for their temporaries; pass a
+  // core::MonotonicArena and reset it between reports to keep them off the
+  // global heap. Only the returned report is allocated normally.
 
   // =========================================================================
   // Aging Report — Bucket Sort O(n)
+  // Buckets are chosen from balance projections; only open invoices are
+  // decoded, once, straight into their bucket
   // =========================================================================
-  AgingReport aging_report() const {
+  AgingReport aging_report(
+      std::pmr::memory_resource *scratch = std::pmr::get_default_resource())
+      const {
     AgingReport report;
     report.current = {"0-30 days", 0, 30};
     report.bucket_30 = {"31-60 days", 31, 60};
     report.bucket_60 = {"61-90 days", 61, 90};
     report.bucket_90 = {"90+ days", 91, -1};
-
-    auto all = inv_repo_.find_all();
-    for (auto &inv : all) {
-      if (inv.status == models::InvoiceStatus::PAID ||
-          inv.status == models::InvoiceStatus::CANCELLED)
+    AgingBucket *buckets[] = {&report.current, &report.bucket_30,
+                              &report.bucket_60, &report.bucket_90};
+    std::pmr::vector<int64_t> ids[] = {
+        std::pmr::vector<int64_t>(scratch), std::pmr::vector<int64_t>(scratch),
+        std::pmr::vector<int64_t>(scratch), std::pmr::vector<int64_t>(scratch)};
+
+    std::time_t now = std::time(nullptr);
+    for (auto &b : inv_repo_.balances(scratch)) {
+      if (b.status == models::InvoiceStatus::PAID ||
+          b.status == models::InvoiceStatus::CANCELLED)
         continue;
 
-      double due = inv.amount_due();
-      int days = inv.days_overdue();
+      double due = b.amount_due();
+      int days = b.days_overdue(now);
 
-      auto &bucket = (days <= 30)   ? report.current
-                     : (days <= 60) ? report.bucket_30
-                     : (days <= 90) ? report.bucket_60
-                                    : report.bucket_90;
-      bucket.invoices.push_back(inv);
-      bucket.total_amount += due;
+      int k = (days <= 30) ? 0 : (days <= 60) ? 1 : (days <= 90) ? 2 : 3;
+      ids[k].push_back(b.id);
+      buckets[k]->total_amount += due;
       report.grand_total_overdue += due;
     }
+    for (int k = 0; k < 4; ++k)
+      buckets[k]->invoices = inv_repo_.find_many(ids[k]);
     return report;
   }
 
   // =========================================================================
   // Revenue Forecasting — Simple Moving Average (SMA-N) O(n)
+  // History walks the completed_at index in time order, so months come out
+  // sorted and the calendar is only consulted once per month
   // =========================================================================
   struct MonthlyRevenue {
     std::string month;
     double revenue;
   };
 
-  std::vector<MonthlyRevenue> monthly_revenue_history() const {
-    auto payments = pay_repo_.find_all();
-    std::map<std::string, double> by_month;
-
-    for (auto &p : payments) {
-      if (p.status != models::PaymentStatus::COMPLETED)
-        continue;
-      std::tm *t = std::localtime(&p.completed_at);
-      char buf[8];
-      std::strftime(buf, sizeof(buf), "%Y-%m", t);
-      by_month[buf] += p.amount;
-    }
-
+  std::vector<MonthlyRevenue> monthly_revenue_history(
+      std::pmr::memory_resource *scratch = std::pmr::get_default_resource())
+      const {
     std::vector<MonthlyRevenue> result;
-    for (auto &[month, rev] : by_month)
-      result.push_back({month, rev});
-    std::sort(result.begin(), result.end(),
-              [](const MonthlyRevenue &a, const MonthlyRevenue &b) {
-                return a.month < b.month;
-              });
+    std::time_t month_end = 0; // first second of the following month
+    for (auto &[at, amount] : pay_repo_.completed_amounts(scratch)) {
+      if (result.empty() || at >= month_end) {
+        std::tm t = *std::localtime(&at);
+        char buf[8];
+        std::strftime(buf, sizeof(buf), "%Y-%m", &t);
+        result.push_back({buf, 0.0});
+        t.tm_mon += 1;
+        t.tm_mday = 1;
+        t.tm_hour = t.tm_min = t.tm_sec = 0;
+        t.tm_isdst = -1;
+        month_end = std::mktime(&t);
+      }
+      result.back().revenue += amount;
+    }
     return result;
   }
 
-  std::vector<double> sma_forecast(int window = 3,
-                                   int forecast_months = 3) const {
-    auto history = monthly_revenue_history();
+  std::vector<double> sma_forecast(
+      int window = 3, int forecast_months = 3,
+      std::pmr::memory_resource *scratch = std::pmr::get_default_resource())
+      const {
+    auto history = monthly_revenue_history(scratch);
     if (history.empty())
       return {};
 
-    std::vector<double> revenues;
+    std::pmr::vector<double> revenues(scratch);
+    revenues.reserve(history.size() + forecast_months);
     for (auto &m : history)
       revenues.push_back(m.revenue);
 
@@ -147,27 +168,35 @@ public:
   }
 
   // =========================================================================
-  // Customer Lifetime Value (CLV) — O(n payments per customer)
+  // Customer Lifetime Value (CLV) — O(customers + payments)
   // CLV = avg_monthly_revenue * lifespan_months
+  // Customers are split into chunks computed as pool tasks
   // =========================================================================
   std::vector<CLVReport> customer_clv_report() const {
+    constexpr std::size_t CHUNK = 512;
     auto customers = cust_repo_.find_all();
-    std::vector<CLVReport> result;
-
-    for (auto &cust : customers) {
-      auto payments = pay_repo_.find_by_customer(cust.id);
-      double total_paid = 0.0;
-      for (auto &p : payments)
-        if (p.status == models::PaymentStatus::COMPLETED)
-          total_paid += p.amount;
-
-      double months = std::max(1.0, cust.lifetime_months());
-      double avg_monthly = total_paid / months;
-      double clv = avg_monthly * 24.0; // assume 24-month lifespan
-
-      result.push_back(
-          {cust.id, cust.name, avg_monthly, months, clv, total_paid});
+    std::vector<CLVReport> result(customers.size());
+
+    std::vector<std::future<void>> jobs;
+    for (std::size_t b = 0; b < customers.size(); b += CHUNK) {
+      std::size_t e = std::min(customers.size(), b + CHUNK);
+      jobs.push_back(pool_.submit([&, b, e] {
+        for (std::size_t i = b; i < e; ++i) {
+          const auto &cust = customers[i];
+          double total_paid = pay_repo_.completed_total_for_customer(cust.id);
+
+          double months = std::max(1.0, cust.lifetime_months());
+          double avg_monthly = total_paid / months;
+          double clv = avg_monthly * 24.0; // assume 24-month lifespan
+
+          result[i] = {cust.id, cust.name, avg_monthly, months, clv,
+                       total_paid};
+        }
+      }));
     }
+    pool_.wait_all(jobs);
+    for (auto &j : jobs)
+      j.get();
 
     // Sort by CLV descending
     std::sort(
@@ -246,6 +275,32 @@ public:
     return path;
   }
 
+  // =========================================================================
+  // Export all three reports concurrently on the pool, each with its own
+  // scratch arena. Waits for every export; the first failure is rethrown.
+  // Returns the written paths (aging CSV, CLV CSV, revenue JSON).
+  // =========================================================================
+  std::vector<std::string> export_all(int sma_window = 3) const {
+    std::vector<std::future<std::string>> jobs;
+    jobs.push_back(pool_.submit([this] {
+      core::MonotonicArena scratch(64 * 1024);
+      return export_aging_csv(aging_report(&scratch));
+    }));
+    jobs.push_back(
+        pool_.submit([this] { return export_clv_csv(customer_clv_report()); }));
+    jobs.push_back(pool_.submit([this, sma_window] {
+      core::MonotonicArena scratch(64 * 1024);
+      auto history = monthly_revenue_history(&scratch);
+      auto forecast = sma_forecast(sma_window, 3, &scratch);
+      return export_revenue_json(history, forecast);
+    }));
+    pool_.wait_all(jobs);
+    std::vector<std::string> paths;
+    for (auto &j : jobs)
+      paths.push_back(j.get());
+    return paths;
+  }
+
   // Summary stats
   struct Summary {
     std::size_t total_customers;
@@ -256,18 +311,21 @@ public:
     std::size_t overdue_count;
   };
 
-  Summary generate_summary() const {
+  // Projections only: no payment or invoice is decoded — O(n)
+  Summary generate_summary(
+      std::pmr::memory_resource *scratch = std::pmr::get_default_resource())
+      const {
     Summary s{};
     s.total_customers = cust_repo_.count();
     s.total_invoices = inv_repo_.count();
     s.total_payments = pay_repo_.count();
 
-    for (auto &p : pay_repo_.find_all())
-      if (p.status == models::PaymentStatus::COMPLETED)
-        s.total_revenue += p.amount;
-    for (auto &inv : inv_repo_.find_all()) {
-      s.total_outstanding += inv.amount_due();
-      if (inv.is_overdue())
+    for (auto &[at, amount] : pay_repo_.completed_amounts(scratch))
+      s.total_revenue += amount;
+    std::time_t now = std::time(nullptr);
+    for (auto &b : inv_repo_.balances(scratch)) {
+      s.total_outstanding += b.amount_due();
+      if (b.is_overdue(now))
         s.overdue_count++;
     }
     return s;
@@ -278,6 +336,7 @@ private:
   repository::CustomerRepository &cust_repo_;
   repository::PaymentRepository &pay_repo_;
   std::string export_dir_;
+  core::ThreadPool &pool_;
 };
 
 } // namespace billing::service
@@ -1,9 +1,32 @@
 // test_billing_engine.cpp — Billing engine tests using in-memory mock
 #include "../src/core/snowflake.hpp"
 #include "../src/models/invoice.hpp"
+#include "../src/service/billing_engine.hpp"
 #include "../src/service/discount_engine.hpp"
+#include "../src/service/overdue_sweeper.hpp"
 #include "../src/service/tax_engine.hpp"
 #include "test_harness.hpp"
+#include <chrono>
+#include <filesystem>
+#include <set>
+#include <string>
+#include <thread>
+
+namespace {
+
+// Records the size of each bulk overdue notification
+struct OverdueRecorder : billing::service::BillingObserver {
+  std::vector<std::size_t> batches;
+  void on_invoice_created(const billing::models::Invoice &) override {}
+  void on_invoice_paid(const billing::models::Invoice &) override {}
+  void on_invoice_overdue(const billing::models::Invoice &) override {}
+  void on_invoices_overdue(
+      const std::vector<billing::models::Invoice> &invs) override {
+    batches.push_back(invs.size());
+  }
+};
+
+} // namespace
 
 void run_billing_engine_tests(billing::test::TestSuite &suite) {
   using namespace billing;
@@ -80,4 +103,255 @@ void run_billing_engine_tests(billing::test::TestSuite &suite) {
     inv.due_date = std::time(nullptr) - 2 * 86400;
     ASSERT_FALSE(inv.is_overdue());
   });
+
+  suite.run("BillingEngine: Scheduler drains overdue, skips paid", [] {
+    auto dir = test::scratch_dir("engine", "scheduler");
+    repository::CustomerRepository customers(dir);
+    repository::InvoiceRepository invoices(dir);
+    service::DiscountEngine disc;
+    service::TaxEngine tax;
+    models::Customer c{};
+    c.id = 1;
+    c.name = "Acme";
+    c.email = "billing@acme.test";
+    c.country = "HK";
+    c.created_at = std::time(nullptr);
+    customers.save(c);
+
+    service::BillingEngine engine(invoices, customers, disc, tax);
+    auto make = [&](int due_days) {
+      service::InvoiceRequest req;
+      req.customer_id = 1;
+      req.type = models::InvoiceType::ONE_TIME;
+      req.line_items = {{"Support", 1, 100.0}};
+      req.due_days = due_days;
+      return engine.create_invoice(req);
+    };
+    auto late = make(-3);
+    auto paid = make(-1);
+    auto settled = make(-2);
+    auto later = make(10);
+    ASSERT_TRUE(engine.mark_paid(paid.id, paid.total_amount));
+    ASSERT_EQ(engine.pending_in_scheduler(), 3u);
+
+    ASSERT_EQ(engine.flag_overdue(), 2);
+    ASSERT_EQ(engine.flag_overdue(), 0); // nothing new fell due
+    // Paying an already-drained invoice takes it out of the backlog
+    ASSERT_TRUE(engine.mark_paid(settled.id, settled.total_amount));
+    ASSERT_EQ(engine.pending_in_scheduler(), 2u);
+    ASSERT_TRUE(invoices.find_by_id(late.id)->status ==
+                models::InvoiceStatus::OVERDUE);
+    ASSERT_EQ(engine.next_due()->id, late.id);
+    ASSERT_EQ(engine.next_due()->id, late.id); // a look, not a pop
+    invoices.modify(late.id, [](models::Invoice &inv) {
+      inv.status = models::InvoiceStatus::PAID; // settled elsewhere
+    });
+    ASSERT_EQ(engine.next_due()->id, later.id);
+    ASSERT_EQ(engine.pending_in_scheduler(), 1u); // `late` was dropped
+
+    // Looking at the next due invoice leaves it for the sweep to flag
+    std::time_t now = std::time(nullptr);
+    auto soon = make(1);
+    ASSERT_EQ(engine.next_due()->id, soon.id);
+    auto elsewhere = make(2);
+    invoices.modify(elsewhere.id, [](models::Invoice &inv) {
+      inv.status = models::InvoiceStatus::PAID; // never seen by the engine
+    });
+    ASSERT_EQ(engine.pending_in_scheduler(), 3u);
+    auto sweep = engine.sweep_overdue(now + 3 * 86400);
+    ASSERT_EQ(sweep.expired, 2u);
+    ASSERT_EQ(sweep.flagged, 1u);
+    ASSERT_TRUE(invoices.find_by_id(soon.id)->status ==
+                models::InvoiceStatus::OVERDUE);
+    // Only the unpaid one is backlogged; the settled one is dropped
+    ASSERT_EQ(engine.pending_in_scheduler(), 2u); // later, soon
+
+    // A new engine picks the schedule back up from the repository
+    make(5);
+    service::BillingEngine reopened(invoices, customers, disc, tax);
+    ASSERT_EQ(reopened.pending_in_scheduler(), 3u); // later, soon, new
+  });
+
+  suite.run("BillingEngine: Pipelined batch_create", [] {
+    auto dir = test::scratch_dir("engine", "batch");
+    repository::CustomerRepository customers(dir);
+    repository::InvoiceRepository invoices(dir);
+    service::DiscountEngine disc;
+    service::TaxEngine tax;
+    for (int64_t id = 1; id <= 3; ++id) {
+      models::Customer c{};
+      c.id = id;
+      c.name = "Customer " + std::to_string(id);
+      c.email = "c" + std::to_string(id) + "@test";
+      c.country = "US";
+      c.state = "CA";
+      c.created_at = std::time(nullptr);
+      customers.save(c);
+    }
+
+    service::BillingEngine engine(invoices, customers, disc, tax);
+    std::vector<service::InvoiceRequest> reqs;
+    for (int i = 0; i < 250; ++i) {
+      service::InvoiceRequest req;
+      // Every 50th request names a customer that does not exist
+      req.customer_id = i % 50 == 49 ? 99 : 1 + i / 100;
+      req.type = models::InvoiceType::ONE_TIME;
+      req.line_items = {{"Seat", 1 + i % 3, 40.0}};
+      reqs.push_back(req);
+    }
+    service::BatchOptions opts;
+    opts.chunk_size = 16;
+    opts.max_in_flight = 3;
+    opts.price_workers = 3;
+    auto out = engine.batch_create(reqs, opts);
+
+    // Unknown customers are reported, not returned as blank invoices
+    ASSERT_EQ(out.failures.size(), 5u);
+    for (std::size_t k = 0; k < out.failures.size(); ++k) {
+      ASSERT_EQ(out.failures[k].index, 49 + 50 * k);
+      ASSERT_EQ(out.failures[k].reason, std::string("Customer not found"));
+    }
+    ASSERT_EQ(out.invoices.size(), 245u);
+    std::set<int64_t> ids;
+    std::set<std::string> numbers;
+    for (auto &inv : out.invoices) {
+      ASSERT_NE(inv.id, 0);
+      ASSERT_TRUE(inv.customer_id >= 1 && inv.customer_id <= 3);
+      ASSERT_GT(inv.total_amount, inv.subtotal); // CA sales tax
+      ids.insert(inv.id);
+      numbers.insert(inv.invoice_number);
+      ASSERT_TRUE(invoices.find_by_id(inv.id).has_value());
+    }
+    ASSERT_EQ(ids.size(), 245u);
+    ASSERT_EQ(numbers.size(), 245u);
+    ASSERT_EQ(engine.pending_in_scheduler(), 245u);
+
+    auto stats = engine.last_batch_stats();
+    ASSERT_EQ(stats.requests, 250u);
+    ASSERT_EQ(stats.created, 245u);
+    ASSERT_EQ(stats.stages.size(), 5u);
+    ASSERT_EQ(stats.stages[0].items, 250u); // prefetch sees every request
+    ASSERT_EQ(stats.stages[1].workers, 3);
+    for (std::size_t k = 1; k < stats.stages.size(); ++k)
+      ASSERT_EQ(stats.stages[k].items, 245u);
+    for (auto &s : stats.stages) {
+      ASSERT_EQ(s.batches, 16u); // ceil(250 / 16) chunks
+      ASSERT_TRUE(s.max_queue_depth <= 3);
+    }
+    ASSERT_TRUE(engine.batch_create({}).invoices.empty());
+  });
+
+  suite.run("BillingEngine: Overdue sweeps are incremental and bulk", [] {
+    auto dir = test::scratch_dir("engine", "sweep");
+    repository::CustomerRepository customers(dir);
+    repository::InvoiceRepository invoices(dir);
+    service::DiscountEngine disc;
+    service::TaxEngine tax;
+    models::Customer c{};
+    c.id = 1;
+    c.name = "Acme";
+    c.email = "billing@acme.test";
+    c.country = "HK";
+    c.created_at = std::time(nullptr);
+    customers.save(c);
+
+    service::BillingEngine engine(invoices, customers, disc, tax);
+    OverdueRecorder recorder;
+    engine.add_observer(&recorder);
+    auto make = [&](int due_days) {
+      service::InvoiceRequest req;
+      req.customer_id = 1;
+      req.type = models::InvoiceType::ONE_TIME;
+      req.line_items = {{"Support", 1, 100.0}};
+      req.due_days = due_days;
+      return engine.create_invoice(req);
+    };
+    std::time_t now = std::time(nullptr);
+    auto first = make(1);
+    auto settled = make(2);
+    auto second = make(2);
+    make(10);
+    // Settled without going through the engine, so still on its wheel
+    ASSERT_TRUE(invoices.modify(settled.id, [](models::Invoice &inv) {
+      inv.status = models::InvoiceStatus::PAID;
+    }));
+
+    ASSERT_EQ(engine.sweep_overdue(now).expired, 0u);
+    auto s1 = engine.sweep_overdue(now + 86400 + 43200);
+    ASSERT_EQ(s1.expired, 1u);
+    ASSERT_EQ(s1.flagged, 1u);
+    auto s2 = engine.sweep_overdue(now + 2 * 86400 + 43200);
+    ASSERT_EQ(s2.expired, 2u); // only what fell due since the last sweep
+    ASSERT_EQ(s2.flagged, 1u); // the settled one is skipped
+    ASSERT_EQ(engine.sweep_overdue(now + 3 * 86400).expired, 0u);
+    ASSERT_EQ(recorder.batches.size(), 2u);
+    ASSERT_EQ(recorder.batches[0], 1u);
+    ASSERT_EQ(recorder.batches[1], 1u);
+    ASSERT_TRUE(invoices.find_by_id(first.id)->status ==
+                models::InvoiceStatus::OVERDUE);
+    ASSERT_TRUE(invoices.find_by_id(second.id)->status ==
+                models::InvoiceStatus::OVERDUE);
+    ASSERT_TRUE(invoices.find_by_id(settled.id)->status ==
+                models::InvoiceStatus::PAID);
+    ASSERT_TRUE(invoices.verify_indexes());
+
+    // The periodic sweeper runs the same sweep on its own thread. A fresh
+    // engine, since the sweeps above moved this one's clock days ahead.
+    auto late = make(-1);
+    service::BillingEngine live(invoices, customers, disc, tax);
+    service::OverdueSweeper sweeper(live, std::chrono::milliseconds(5));
+    sweeper.start();
+    for (int i = 0; i < 400 && sweeper.flagged() == 0; ++i)
+      std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    sweeper.stop();
+    ASSERT_EQ(sweeper.flagged(), 1u);
+    ASSERT_GE(sweeper.sweeps(), 1u);
+    ASSERT_TRUE(invoices.find_by_id(late.id)->status ==
+                models::InvoiceStatus::OVERDUE);
+  });
+
+  suite.run("BillingEngine: Sweep with a failing log flags nothing", [] {
+    auto dir = test::scratch_dir("engine", "sweep_fail");
+    repository::CustomerRepository customers(dir);
+    repository::InvoiceRepository invoices(dir);
+    service::DiscountEngine disc;
+    service::TaxEngine tax;
+    models::Customer c{};
+    c.id = 1;
+    c.name = "Acme";
+    c.email = "billing@acme.test";
+    c.created_at = std::time(nullptr);
+    customers.save(c);
+    service::BillingEngine engine(invoices, customers, disc, tax);
+    OverdueRecorder recorder;
+    engine.add_observer(&recorder);
+    service::InvoiceRequest req;
+    req.customer_id = 1;
+    req.type = models::InvoiceType::ONE_TIME;
+    req.line_items = {{"Support", 1, 100.0}};
+    req.due_days = 1;
+    auto a = engine.create_invoice(req);
+    auto b = engine.create_invoice(req);
+    std::time_t later = std::time(nullptr) + 2 * 86400;
+
+    {
+      auto wal = dir + "/invoices.wal";
+      test::FileSizeLimit cap(std::filesystem::file_size(wal));
+      ASSERT_THROWS(engine.sweep_overdue(later));
+    }
+    // The failed append changed nothing, and nothing was announced
+    ASSERT_TRUE(invoices.find_by_id(a.id)->status ==
+                models::InvoiceStatus::PENDING);
+    ASSERT_TRUE(invoices.verify_indexes());
+    ASSERT_TRUE(recorder.batches.empty());
+    ASSERT_EQ(engine.pending_in_scheduler(), 2u);
+
+    // Both went back on the wheel; the next sweep flags and announces them
+    auto retry = engine.sweep_overdue(later);
+    ASSERT_EQ(retry.flagged, 2u);
+    ASSERT_EQ(recorder.batches.size(), 1u);
+    ASSERT_EQ(recorder.batches[0], 2u);
+    ASSERT_TRUE(invoices.find_by_id(b.id)->status ==
+                models::InvoiceStatus::OVERDUE);
+  });
 }
@@ -1,6 +1,9 @@
 // test_bplus_tree.cpp
 #include "../src/core/bplus_tree.hpp"
 #include "test_harness.hpp"
+#include <algorithm>
+#include <random>
+#include <set>
 
 void run_bplus_tree_tests(billing::test::TestSuite &suite) {
   using namespace billing::core;
@@ -83,4 +86,168 @@ void run_bplus_tree_tests(billing::test::TestSuite &suite) {
       ASSERT_EQ(*r, i);
     }
   });
+  suite.run("BPlusTree: Random keys match std::set (order 4 and 64)", [] {
+    auto check = [](auto &tree) {
+      std::mt19937_64 rng(11);
+      std::set<int64_t> expected;
+      for (int i = 0; i < 20000; ++i) {
+        int64_t k = static_cast<int64_t>(rng() % 100000) - 50000;
+        if (expected.insert(k).second)
+          tree.insert(k, k * 3);
+      }
+      ASSERT_EQ(tree.size(), expected.size());
+      for (int64_t k = -50010; k < 50010; k += 7)
+        ASSERT_EQ(tree.search(k).has_value(), expected.count(k) == 1);
+      for (int64_t lo : {-50000LL, -123LL, 0LL, 49000LL}) {
+        auto got = tree.range(lo, lo + 900);
+        auto it = expected.lower_bound(lo);
+        for (auto &[k, v] : got) {
+          ASSERT_EQ(k, *it++);
+          ASSERT_EQ(v, k * 3);
+        }
+        ASSERT_TRUE(it == expected.upper_bound(lo + 900));
+      }
+    };
+    BPlusTree<int64_t, int64_t, 4> small;
+    BPlusTree<int64_t, int64_t> wide;
+    check(small);
+    check(wide);
+  });
+
+  suite.run("BPlusTree: Range bounds on separator keys", [] {
+    BPlusTree<int, int, 4> tree;
+    for (int i = 0; i < 100; ++i)
+      tree.insert(i, i);
+    for (int lo = 0; lo < 100; ++lo) {
+      auto r = tree.range(lo, lo);
+      ASSERT_EQ(r.size(), 1u);
+      ASSERT_EQ(r[0].first, lo);
+    }
+    ASSERT_EQ(tree.range(-5, 200).size(), 100u);
+    ASSERT_TRUE(tree.range(40, 39).empty());
+  });
+
+  suite.run("BPlusTree: Composite pair keys", [] {
+    using Key = std::pair<int64_t, int64_t>;
+    BPlusTree<Key, int64_t> tree;
+    for (int64_t c = 0; c < 50; ++c)
+      for (int64_t id = 0; id < 40; ++id)
+        tree.insert({c, id}, c * 100 + id);
+    auto r = tree.range({7, INT64_MIN}, {7, INT64_MAX});
+    ASSERT_EQ(r.size(), 40u);
+    ASSERT_EQ(r.front().second, 700);
+    ASSERT_EQ(*tree.search({49, 39}), 4939);
+  });
+  suite.run("BPlusTree: Bulk load matches one-by-one inserts", [] {
+    for (std::size_t n : {0u, 1u, 3u, 64u, 65u, 5000u, 100003u}) {
+      std::vector<std::pair<int64_t, int64_t>> entries;
+      for (std::size_t i = 0; i < n; ++i)
+        entries.emplace_back(static_cast<int64_t>(i) * 3, i);
+      for (double fill : {1.0, 0.5, 0.01}) {
+        BPlusTree<int64_t, int64_t> tree;
+        tree.insert(-1, -1); // replaced by the load
+        tree.bulk_load(entries.begin(), entries.end(), fill);
+        ASSERT_EQ(tree.size(), n);
+        ASSERT_FALSE(tree.search(-1).has_value());
+        for (std::size_t i = 0; i < n; i += 1 + n / 500) {
+          ASSERT_EQ(*tree.search(entries[i].first), entries[i].second);
+          ASSERT_FALSE(tree.search(entries[i].first + 1).has_value());
+        }
+        std::size_t seen = 0;
+        tree.for_each([&](const int64_t &k, const int64_t &) {
+          ASSERT_EQ(k, entries[seen++].first);
+        });
+        ASSERT_EQ(seen, n);
+        if (n > 10)
+          ASSERT_EQ(tree.range(3, 30).size(), 10u);
+      }
+    }
+  });
+
+  suite.run("BPlusTree: Inserts after bulk load split correctly", [] {
+    std::vector<std::pair<int, int>> entries;
+    for (int i = 0; i < 1000; ++i)
+      entries.emplace_back(i * 2, i);
+    BPlusTree<int, int, 4> tree;
+    tree.bulk_load(entries.begin(), entries.end());
+    for (int i = 0; i < 1000; ++i)
+      tree.insert(i * 2 + 1, -i);
+    ASSERT_EQ(tree.size(), 2000u);
+    auto all = tree.range(0, 1999);
+    ASSERT_EQ(all.size(), 2000u);
+    for (int i = 0; i < 2000; ++i)
+      ASSERT_EQ(all[i].first, i);
+  });
+
+  suite.run("BPlusTree: Bulk load rejects unsorted input", [] {
+    std::vector<std::pair<int, int>> entries = {{1, 1}, {3, 3}, {3, 4}};
+    BPlusTree<int, int> tree;
+    tree.insert(9, 9);
+    ASSERT_THROWS(tree.bulk_load(entries.begin(), entries.end()));
+    ASSERT_THROWS(tree.bulk_load(entries.begin(), entries.begin(), 0.0));
+    ASSERT_EQ(*tree.search(9), 9); // contents untouched on error
+  });
+  suite.run("BPlusTree: Removals keep nodes at least half full", [] {
+    auto churn = [](auto &tree, int min_keys) {
+      std::mt19937_64 rng(5);
+      std::vector<int64_t> keys(20000);
+      for (std::size_t i = 0; i < keys.size(); ++i)
+        keys[i] = static_cast<int64_t>(i);
+      std::shuffle(keys.begin(), keys.end(), rng);
+      for (int64_t k : keys)
+        tree.insert(k, k);
+      std::shuffle(keys.begin(), keys.end(), rng);
+      for (std::size_t i = 0; i < keys.size(); ++i) {
+        ASSERT_TRUE(tree.remove(keys[i]));
+        if (i % 997 == 0 || i + 50 > keys.size()) {
+          auto st = tree.stats();
+          if (st.height > 1)
+            ASSERT_TRUE(st.min_leaf_keys >= min_keys);
+          if (st.internal_nodes > 1)
+            ASSERT_TRUE(st.min_internal_keys >= min_keys);
+        }
+        if (i % 4000 == 0) {
+          std::vector<int64_t> rest(keys.begin() + i + 1, keys.end());
+          std::sort(rest.begin(), rest.end());
+          std::size_t j = 0;
+          tree.for_each([&](const int64_t &k, const int64_t &v) {
+            ASSERT_EQ(k, rest[j++]);
+            ASSERT_EQ(v, k);
+          });
+          ASSERT_EQ(j, rest.size());
+        }
+      }
+      ASSERT_TRUE(tree.empty());
+      ASSERT_FALSE(tree.remove(keys[0]));
+      auto st = tree.stats();
+      ASSERT_EQ(st.height, 1u);
+      ASSERT_EQ(st.leaf_nodes, 1u);
+    };
+    BPlusTree<int64_t, int64_t, 4> small;
+    churn(small, decltype(small)::MIN_KEYS);
+    BPlusTree<int64_t, int64_t> wide;
+    churn(wide, decltype(wide)::MIN_KEYS);
+  });
+
+  suite.run("BPlusTree: Stats report height and occupancy", [] {
+    std::vector<std::pair<int64_t, int64_t>> entries;
+    for (int64_t i = 0; i < 63 * 64; ++i)
+      entries.emplace_back(i, i);
+    BPlusTree<int64_t, int64_t> tree;
+    tree.bulk_load(entries.begin(), entries.end());
+    auto st = tree.stats();
+    ASSERT_EQ(st.height, 2u);
+    ASSERT_EQ(st.leaf_nodes, 64u);
+    ASSERT_EQ(st.internal_nodes, 1u);
+    ASSERT_NEAR(st.leaf_occupancy, 1.0, 1e-9);
+    // Delete 3/4 of the keys: merges keep leaves >= half full
+    for (int64_t i = 0; i < 63 * 64; ++i)
+      if (i % 4 != 0)
+        tree.remove(i);
+    st = tree.stats();
+    ASSERT_EQ(tree.size(), 1008u);
+    ASSERT_TRUE(st.leaf_occupancy >= 0.5);
+    ASSERT_TRUE(st.leaf_nodes < 64u);
+    ASSERT_EQ(tree.range(0, 100).size(), 26u);
+  });
 }
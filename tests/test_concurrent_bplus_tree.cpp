@@ -0,0 +1,130 @@
+// test_concurrent_bplus_tree.cpp
+#include "../src/core/concurrent_bplus_tree.hpp"
+#include "test_harness.hpp"
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <random>
+#include <thread>
+
+void run_concurrent_bplus_tree_tests(billing::test::TestSuite &suite) {
+  using namespace billing::core;
+
+  suite.run("ConcurrentBPlusTree: Single-thread ops match std::map", [] {
+    ConcurrentBPlusTree<int64_t, int64_t, 8> tree;
+    std::map<int64_t, int64_t> expected;
+    std::mt19937_64 rng(3);
+    for (int i = 0; i < 20000; ++i) {
+      int64_t k = static_cast<int64_t>(rng() % 5000);
+      switch (rng() % 4) {
+      case 0:
+      case 1:
+        ASSERT_EQ(tree.insert(k, i), expected.emplace(k, i).second);
+        break;
+      case 2:
+        ASSERT_EQ(tree.update(k, -i), expected.count(k) == 1);
+        if (expected.count(k))
+          expected[k] = -i;
+        break;
+      default:
+        ASSERT_EQ(tree.remove(k), expected.erase(k) == 1);
+      }
+    }
+    ASSERT_EQ(tree.size(), expected.size());
+    for (int64_t k = 0; k < 5000; ++k) {
+      auto it = expected.find(k);
+      auto got = tree.search(k);
+      ASSERT_EQ(got.has_value(), it != expected.end());
+      if (got)
+        ASSERT_EQ(*got, it->second);
+    }
+    auto all = tree.range(100, 4000);
+    auto lo = expected.lower_bound(100), hi = expected.upper_bound(4000);
+    ASSERT_EQ(all.size(), static_cast<std::size_t>(std::distance(lo, hi)));
+    for (auto &[k, v] : all) {
+      ASSERT_EQ(k, lo->first);
+      ASSERT_EQ(v, lo->second);
+      ++lo;
+    }
+  });
+
+  suite.run("ConcurrentBPlusTree: Readers see every published key", [] {
+    // Writers insert disjoint key sets and publish their progress; readers
+    // must find every key a writer has published, and range scans must
+    // come back sorted and duplicate-free while splits are happening
+    constexpr int WRITERS = 4, READERS = 4;
+    constexpr int64_t PER_WRITER = 20000;
+    ConcurrentBPlusTree<int64_t, int64_t, 8> tree;
+    std::atomic<int64_t> progress[WRITERS] = {};
+    std::atomic<bool> writers_done{false};
+    std::atomic<int> failures{0};
+
+    std::vector<std::thread> threads;
+    for (int w = 0; w < WRITERS; ++w)
+      threads.emplace_back([&, w] {
+        for (int64_t i = 0; i < PER_WRITER; ++i) {
+          int64_t key = i * WRITERS + w;
+          if (!tree.insert(key, key * 10))
+            failures++;
+          progress[w].store(i + 1, std::memory_order_release);
+        }
+      });
+    for (int r = 0; r < READERS; ++r)
+      threads.emplace_back([&, r] {
+        std::mt19937_64 rng(r);
+        while (!writers_done.load(std::memory_order_acquire)) {
+          int w = static_cast<int>(rng() % WRITERS);
+          int64_t done = progress[w].load(std::memory_order_acquire);
+          if (done > 0) {
+            int64_t key = static_cast<int64_t>(rng() % done) * WRITERS + w;
+            auto v = tree.search(key);
+            if (!v || *v != key * 10)
+              failures++;
+          }
+          int64_t lo = static_cast<int64_t>(rng() % (PER_WRITER * WRITERS));
+          auto hits = tree.range(lo, lo + 200);
+          for (std::size_t i = 0; i < hits.size(); ++i)
+            if (hits[i].first < lo || hits[i].first > lo + 200 ||
+                (i > 0 && !(hits[i - 1].first < hits[i].first)))
+              failures++;
+        }
+      });
+    for (int w = 0; w < WRITERS; ++w)
+      threads[w].join();
+    writers_done = true;
+    for (std::size_t t = WRITERS; t < threads.size(); ++t)
+      threads[t].join();
+
+    ASSERT_EQ(failures.load(), 0);
+    ASSERT_EQ(tree.size(), static_cast<std::size_t>(WRITERS * PER_WRITER));
+    auto all = tree.range(0, WRITERS * PER_WRITER);
+    ASSERT_EQ(all.size(), static_cast<std::size_t>(WRITERS * PER_WRITER));
+    for (std::size_t i = 0; i < all.size(); ++i)
+      ASSERT_EQ(all[i].first, static_cast<int64_t>(i));
+  });
+
+  suite.run("ConcurrentBPlusTree: Concurrent insert/remove churn", [] {
+    constexpr int THREADS = 4;
+    constexpr int64_t KEYS = 5000;
+    ConcurrentBPlusTree<int64_t, int64_t, 8> tree;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < THREADS; ++t)
+      threads.emplace_back([&, t] {
+        // Each thread owns keys == t (mod THREADS); ends with the even ones
+        for (int round = 0; round < 3; ++round) {
+          for (int64_t k = t; k < KEYS * THREADS; k += THREADS)
+            tree.insert(k, k);
+          for (int64_t k = t; k < KEYS * THREADS; k += THREADS)
+            if (round == 2 ? k % 2 == 1 : true)
+              tree.remove(k);
+        }
+      });
+    for (auto &th : threads)
+      th.join();
+    ASSERT_EQ(tree.size(), static_cast<std::size_t>(KEYS * THREADS / 2));
+    auto all = tree.range(0, KEYS * THREADS);
+    ASSERT_EQ(all.size(), static_cast<std::size_t>(KEYS * THREADS / 2));
+    for (std::size_t i = 0; i < all.size(); ++i)
+      ASSERT_EQ(all[i].first, static_cast<int64_t>(2 * i));
+  });
+}
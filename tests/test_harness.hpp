@@ -2,12 +2,18 @@
 // =============================================================================
 // test_harness.hpp — Lightweight Unit Test Framework
 // =============================================================================
+#include "../src/models/invoice.hpp"
 #include <cmath>
+#include <csignal>
+#include <cstdint>
+#include <ctime>
+#include <filesystem>
 #include <functional>
 #include <iostream>
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <sys/resource.h>
 #include <vector>
 
 namespace billing::test {
@@ -57,6 +63,69 @@ private:
   int passed_ = 0;
 };
 
+// Fixtures shared by the persistence tests
+
+// Fresh, empty <tmp>/billing_<prefix>_<name> for one test
+inline std::string scratch_dir(const std::string &prefix,
+                               const std::string &name) {
+  auto dir = std::filesystem::temp_directory_path() /
+             ("billing_" + prefix + "_" + name);
+  std::filesystem::remove_all(dir);
+  std::filesystem::create_directories(dir);
+  return dir.string();
+}
+
+// A PENDING invoice with one line item; tests set anything else they need
+inline models::Invoice make_invoice(int64_t id, int64_t customer_id = 7,
+                                    double total = 100.0,
+                                    std::time_t due = 0) {
+  models::Invoice inv{};
+  inv.id = id;
+  inv.customer_id = customer_id;
+  inv.invoice_number = "INV-" + std::to_string(id);
+  inv.status = models::InvoiceStatus::PENDING;
+  inv.line_items.push_back({"Consulting Hours", 1, total});
+  inv.total_amount = total;
+  inv.currency = "USD";
+  inv.due_date = due;
+  return inv;
+}
+
+// While alive, caps every file this process writes at `bytes`: writes past
+// the cap fail with EFBIG (a short write first, if they straddle it), as
+// on a full disk
+class FileSizeLimit {
+public:
+  explicit FileSizeLimit(std::size_t bytes) {
+    ::getrlimit(RLIMIT_FSIZE, &saved_);
+    handler_ = std::signal(SIGXFSZ, SIG_IGN);
+    rlimit cap = saved_;
+    cap.rlim_cur = static_cast<rlim_t>(bytes);
+    ::setrlimit(RLIMIT_FSIZE, &cap);
+  }
+  ~FileSizeLimit() {
+    ::setrlimit(RLIMIT_FSIZE, &saved_);
+    std::signal(SIGXFSZ, handler_);
+  }
+  FileSizeLimit(const FileSizeLimit &) = delete;
+  FileSizeLimit &operator=(const FileSizeLimit &) = delete;
+
+private:
+  rlimit saved_{};
+  void (*handler_)(int) = nullptr;
+};
+
+// Noon on the given local date
+inline std::time_t local_date(int year, int month, int day) {
+  std::tm tm{};
+  tm.tm_year = year - 1900;
+  tm.tm_mon = month - 1;
+  tm.tm_mday = day;
+  tm.tm_hour = 12;
+  tm.tm_isdst = -1;
+  return std::mktime(&tm);
+}
+
 // Assertion macros
 #define ASSERT_TRUE(expr)                                                      \
   if (!(expr))                                                                 \
@@ -0,0 +1,91 @@
+// test_indexed_heap.cpp
+#include "../src/core/indexed_heap.hpp"
+#include "test_harness.hpp"
+#include <map>
+#include <random>
+#include <vector>
+
+void run_indexed_heap_tests(billing::test::TestSuite &suite) {
+  using Heap = billing::core::IndexedHeap<int64_t, int64_t>;
+
+  suite.run("IndexedHeap: Pops in key order", [] {
+    Heap heap;
+    for (int64_t k : {50, 10, 40, 20, 30, 10})
+      heap.push(k, k * 100);
+    ASSERT_EQ(heap.top().key, 10);
+    std::vector<int64_t> keys;
+    while (!heap.empty())
+      keys.push_back(heap.pop().key);
+    ASSERT_EQ(keys.size(), 6u);
+    for (std::size_t i = 1; i < keys.size(); ++i)
+      ASSERT_TRUE(keys[i - 1] <= keys[i]);
+    ASSERT_THROWS(heap.pop());
+  });
+
+  suite.run("IndexedHeap: Update and erase by handle", [] {
+    Heap heap;
+    auto a = heap.push(100, 1);
+    auto b = heap.push(200, 2);
+    auto c = heap.push(300, 3);
+    heap.update_key(c, 50); // decrease-key
+    ASSERT_EQ(heap.top().value, 3);
+    heap.update_key(c, 400); // and back up
+    ASSERT_EQ(heap.top().value, 1);
+    ASSERT_EQ(heap.erase(a).value, 1);
+    ASSERT_FALSE(heap.contains(a));
+    ASSERT_THROWS(heap.erase(a));
+    ASSERT_EQ(heap.get(b).key, 200);
+    ASSERT_EQ(heap.pop().value, 2);
+    ASSERT_EQ(heap.pop().value, 3);
+  });
+
+  suite.run("IndexedHeap: Random operations match a reference", [] {
+    Heap heap;
+    std::multimap<int64_t, int64_t> ref; // key -> value
+    std::map<int64_t, Heap::Handle> handles; // value -> handle
+    std::mt19937_64 rng(3);
+    int64_t next_value = 0;
+    for (int step = 0; step < 20000; ++step) {
+      auto op = rng() % 4;
+      if (op <= 1 || handles.empty()) {
+        int64_t key = static_cast<int64_t>(rng() % 1000);
+        handles[next_value] = heap.push(key, next_value);
+        ref.emplace(key, next_value++);
+      } else {
+        auto it = handles.lower_bound(static_cast<int64_t>(rng() % next_value));
+        if (it == handles.end())
+          it = handles.begin();
+        int64_t old_key = heap.get(it->second).key;
+        auto r = ref.equal_range(old_key);
+        while (r.first->second != it->first)
+          ++r.first;
+        ref.erase(r.first);
+        if (op == 2) {
+          int64_t key = static_cast<int64_t>(rng() % 1000);
+          heap.update_key(it->second, key);
+          ref.emplace(key, it->first);
+        } else {
+          ASSERT_EQ(heap.erase(it->second).value, it->first);
+          handles.erase(it);
+        }
+      }
+      ASSERT_EQ(heap.size(), ref.size());
+      if (!heap.empty())
+        ASSERT_EQ(heap.top().key, ref.begin()->first);
+    }
+    int64_t last = -1;
+    heap.drain([&](Heap::Entry &&e) {
+      ASSERT_TRUE(e.key >= last);
+      last = e.key;
+    });
+    ASSERT_TRUE(heap.empty());
+  });
+
+  suite.run("IndexedHeap: Binary arity still orders", [] {
+    billing::core::IndexedHeap<int64_t, int64_t, 2> heap;
+    for (int64_t i = 0; i < 1000; ++i)
+      heap.push((i * 7919) % 1000, i);
+    for (int64_t k = 0; k < 1000; ++k)
+      ASSERT_EQ(heap.pop().key, k);
+  });
+}
@@ -1,6 +1,12 @@
 // test_lru_cache.cpp
 #include "../src/core/lru_cache.hpp"
+#include "../src/core/sharded_lru_cache.hpp"
+#include "../src/core/tinylfu_cache.hpp"
+#include "../src/repository/customer_repository.hpp"
+#include "../src/repository/invoice_repository.hpp"
 #include "test_harness.hpp"
+#include <filesystem>
+#include <thread>
 
 void run_lru_cache_tests(billing::test::TestSuite &suite) {
   using billing::core::LRUCache;
@@ -73,4 +79,245 @@ void run_lru_cache_tests(billing::test::TestSuite &suite) {
     using IntCache = LRUCache<int, int>;
     ASSERT_THROWS(IntCache c(0));
   });
+  suite.run("ShardedLRUCache: Spreads sequential ids over shards", [] {
+    billing::core::ShardedLRUCache<int64_t, int64_t, 8> cache(8000);
+    std::vector<int> per_shard(8, 0);
+    for (int64_t id = 1; id <= 8000; ++id)
+      per_shard[cache.shard_of(id)]++;
+    for (int n : per_shard)
+      ASSERT_TRUE(n > 800 && n < 1200);
+    ASSERT_EQ(cache.capacity(), 8000u);
+  });
+
+  suite.run("ShardedLRUCache: Evicts per shard and aggregates stats", [] {
+    billing::core::ShardedLRUCache<int, int, 4> cache(8); // 2 per shard
+    int evicted = 0;
+    cache.set_evict_callback([&](const int &, const int &) { evicted++; });
+    for (int i = 0; i < 100; ++i)
+      cache.put(i, i * 2);
+    ASSERT_EQ(cache.size(), 8u);
+    ASSERT_EQ(evicted, 92);
+    int hits = 0;
+    for (int i = 0; i < 100; ++i)
+      if (auto v = cache.get(i)) {
+        ASSERT_EQ(*v, i * 2);
+        hits++;
+      }
+    ASSERT_EQ(hits, 8);
+    ASSERT_EQ(cache.hits(), 8u);
+    ASSERT_EQ(cache.misses(), 92u);
+    ASSERT_NEAR(cache.hit_rate(), 0.08, 1e-9);
+    ASSERT_TRUE(cache.evict(99));
+    ASSERT_FALSE(cache.contains(99));
+    cache.clear();
+    ASSERT_EQ(cache.size(), 0u);
+  });
+
+  suite.run("ShardedLRUCache: Concurrent readers and writers", [] {
+    billing::core::ShardedLRUCache<int, int> cache(1024);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; ++t)
+      threads.emplace_back([&cache, t] {
+        for (int i = 0; i < 5000; ++i) {
+          int key = (i * 31 + t) % 2048;
+          if (i % 4 == 0)
+            cache.put(key, key);
+          else if (auto v = cache.get(key); v && *v != key)
+            throw std::runtime_error("wrong value for key");
+        }
+      });
+    for (auto &th : threads)
+      th.join();
+    ASSERT_EQ(cache.hits() + cache.misses(), 8u * 3750u);
+    ASSERT_TRUE(cache.size() <= cache.capacity());
+  });
+
+  suite.run("CustomerRepository: Sharded cache swaps in", [] {
+    using namespace billing;
+    auto dir = std::filesystem::temp_directory_path() / "billing_sharded";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    repository::BasicCustomerRepository<
+        core::ShardedLRUCache<int64_t, repository::CustomerPtr>>
+        repo(dir.string());
+    models::Customer c{};
+    c.id = 7;
+    c.name = "Acme";
+    c.email = "ops@acme.test";
+    repo.save(c);
+    ASSERT_EQ(repo.find_by_id(7)->name, "Acme");
+    ASSERT_FALSE(repo.find_by_id(8).has_value());
+    ASSERT_NEAR(repo.cache_hit_rate(), 0.5, 1e-9);
+  });
+  suite.run("TinyLFUCache: Basic get, put, update and evict", [] {
+    billing::core::TinyLFUCache<int, std::string> cache(100);
+    cache.put(1, "one");
+    cache.put(1, "uno");
+    ASSERT_EQ(*cache.get(1), "uno");
+    ASSERT_FALSE(cache.get(2).has_value());
+    ASSERT_TRUE(cache.evict(1));
+    ASSERT_FALSE(cache.contains(1));
+    ASSERT_NEAR(cache.hit_rate(), 0.5, 1e-9);
+    using IntCache = billing::core::TinyLFUCache<int, int>;
+    ASSERT_THROWS(IntCache c(0));
+  });
+
+  suite.run("TinyLFUCache: Never exceeds capacity", [] {
+    for (std::size_t cap : {1u, 2u, 7u, 256u}) {
+      billing::core::TinyLFUCache<int, int> cache(cap);
+      std::size_t dropped = 0;
+      cache.set_evict_callback([&](const int &, const int &) { dropped++; });
+      for (int i = 0; i < 5000; ++i) {
+        cache.put(i % 911, i);
+        cache.get(i % 37);
+        ASSERT_TRUE(cache.size() <= cap);
+      }
+      ASSERT_TRUE(dropped > 0);
+    }
+  });
+
+  suite.run("TinyLFUCache: Hot set survives a full scan", [] {
+    // 100 hot keys hit repeatedly, then a one-off scan of 10k keys: LRU
+    // loses the hot set, W-TinyLFU refuses the scan keys admission
+    auto replay = [](auto &cache) {
+      auto access = [&](int k) {
+        if (!cache.get(k))
+          cache.put(k, k);
+      };
+      for (int round = 0; round < 20; ++round)
+        for (int k = 0; k < 100; ++k)
+          access(k);
+      for (int k = 1000; k < 11000; ++k)
+        access(k);
+      int hot = 0;
+      for (int k = 0; k < 100; ++k)
+        hot += cache.contains(k);
+      return hot;
+    };
+    LRUCache<int, int> lru(256);
+    billing::core::TinyLFUCache<int, int> tiny(256);
+    ASSERT_EQ(replay(lru), 0);
+    ASSERT_TRUE(replay(tiny) >= 95);
+  });
+  suite.run("LRUCache: Byte budget evicts by footprint", [] {
+    using Cache = LRUCache<int, std::string>;
+    constexpr std::size_t OVER = Cache::ENTRY_OVERHEAD;
+    Cache cache(1000, 3000 + 3 * OVER,
+                [](const int &, const std::string &v) { return v.size(); });
+    cache.put(1, std::string(1000, 'a'));
+    cache.put(2, std::string(1000, 'b'));
+    cache.put(3, std::string(1000, 'c'));
+    ASSERT_EQ(cache.size(), 3u);
+    ASSERT_EQ(cache.bytes(), 3000 + 3 * OVER);
+    cache.get(1); // 2 is now LRU
+    cache.put(4, std::string(1500, 'd')); // needs 2 and 3 gone
+    ASSERT_FALSE(cache.contains(2));
+    ASSERT_FALSE(cache.contains(3));
+    ASSERT_TRUE(cache.contains(1));
+    ASSERT_EQ(cache.bytes(), 2500 + 2 * OVER);
+    cache.put(1, "small"); // re-charged on update
+    ASSERT_EQ(cache.bytes(), 1505 + 2 * OVER);
+    cache.put(9, std::string(10000, 'x')); // larger than the whole budget
+    ASSERT_FALSE(cache.contains(9));
+    ASSERT_TRUE(cache.evict(4));
+    ASSERT_EQ(cache.bytes(), 5 + OVER);
+  });
+
+  suite.run("LRUCache: Setting a budget trims existing entries", [] {
+    LRUCache<int, int> cache(100);
+    for (int i = 0; i < 100; ++i)
+      cache.put(i, i);
+    ASSERT_EQ(cache.bytes(), 0u);
+    auto unit = [](const int &, const int &) { return std::size_t{16}; };
+    std::size_t per_entry = 16 + LRUCache<int, int>::ENTRY_OVERHEAD;
+    cache.set_byte_budget(10 * per_entry, unit);
+    ASSERT_EQ(cache.size(), 10u);
+    ASSERT_TRUE(cache.contains(99)); // most recent survive
+    ASSERT_FALSE(cache.contains(89));
+    ASSERT_EQ(cache.byte_budget(), 10 * per_entry);
+    ASSERT_THROWS(cache.set_byte_budget(0, unit));
+  });
+
+  suite.run("InvoiceRepository: Cache honours a byte budget", [] {
+    using namespace billing;
+    auto dir = std::filesystem::temp_directory_path() / "billing_budget";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    repository::InvoiceRepository repo(dir.string());
+    constexpr std::size_t BUDGET = 256 * 1024;
+    repo.set_cache_byte_budget(BUDGET);
+    for (int64_t id = 1; id <= 200; ++id) {
+      models::Invoice inv{};
+      inv.id = id;
+      inv.customer_id = 1;
+      inv.notes = std::string(id % 10 == 0 ? 20000 : 100, 'n');
+      for (int i = 0; i < 20; ++i)
+        inv.line_items.push_back({"Item " + std::string(40, 'x'), 1, 1.0});
+      repo.save(inv);
+    }
+    ASSERT_TRUE(repo.cache_bytes() > 0);
+    ASSERT_TRUE(repo.cache_bytes() <= BUDGET);
+    ASSERT_EQ(repo.find_by_id(10)->notes.size(), 20000u);
+    ASSERT_TRUE(repo.cache_bytes() <= BUDGET);
+  });
+
+  suite.run("InvoiceRepository: Cache hits share one record", [] {
+    using namespace billing;
+    auto dir = std::filesystem::temp_directory_path() / "billing_shared";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    repository::InvoiceRepository repo(dir.string());
+    models::Invoice inv{};
+    inv.id = 1;
+    inv.line_items.push_back({"Hosting", 2, 50.0});
+    repo.save(inv);
+    auto a = repo.find_shared(1);
+    auto b = repo.find_shared(1);
+    ASSERT_TRUE(a != nullptr);
+    ASSERT_TRUE(a.get() == b.get());
+    ASSERT_TRUE(repo.find_shared(2) == nullptr);
+    // Updates replace the cached record; old readers keep their version
+    inv.line_items.push_back({"Support", 1, 10.0});
+    repo.update(inv);
+    auto c = repo.find_shared(1);
+    ASSERT_TRUE(c.get() != a.get());
+    ASSERT_EQ(a->line_items.size(), 1u);
+    ASSERT_EQ(c->line_items.size(), 2u);
+  });
+
+  suite.run("CustomerRepository: modify is copy-on-write", [] {
+    using namespace billing;
+    auto dir = std::filesystem::temp_directory_path() / "billing_cow";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    repository::CustomerRepository repo(dir.string());
+    models::Customer c{};
+    c.id = 3;
+    c.name = "Old";
+    c.email = "a@b.test";
+    repo.save(c);
+    auto before = repo.find_shared(3);
+    ASSERT_TRUE(repo.modify(3, [](models::Customer &m) {
+      m.name = "New";
+      m.id = 99; // ignored: the record keeps its id
+    }));
+    ASSERT_EQ(before->name, "Old");
+    ASSERT_EQ(repo.find_shared(3)->name, "New");
+    ASSERT_FALSE(repo.find_by_id(99).has_value());
+    ASSERT_FALSE(repo.modify(4, [](models::Customer &) {}));
+    // A throwing edit or an email clash leaves the record untouched
+    models::Customer other = c;
+    other.id = 4;
+    other.email = "taken@b.test";
+    repo.save(other);
+    ASSERT_THROWS(repo.modify(3, [](models::Customer &m) {
+      m.email = "TAKEN@b.test";
+    }));
+    ASSERT_THROWS(repo.modify(3, [](models::Customer &m) {
+      m.name = "Lost";
+      throw std::runtime_error("abort");
+    }));
+    ASSERT_EQ(repo.find_by_id(3)->email, "a@b.test");
+    ASSERT_EQ(repo.find_by_id(3)->name, "New");
+  });
 }
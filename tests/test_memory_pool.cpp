@@ -0,0 +1,178 @@
+// test_memory_pool.cpp
+#include "../src/core/memory_pool.hpp"
+#include "../src/core/memory_resource.hpp"
+#include "test_harness.hpp"
+#include <cstdint>
+#include <map>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct alignas(64) Wide {
+  double lanes[3];
+};
+
+} // namespace
+
+void run_memory_pool_tests(billing::test::TestSuite &suite) {
+  using billing::core::MemoryPool;
+
+  suite.run("MemoryPool: Slots are distinct and reused", [] {
+    MemoryPool<int64_t> pool;
+    std::set<int64_t *> seen;
+    std::vector<int64_t *> slots;
+    for (int i = 0; i < 1000; ++i) {
+      slots.push_back(pool.construct(i));
+      ASSERT_TRUE(seen.insert(slots.back()).second);
+    }
+    for (int i = 0; i < 1000; ++i)
+      ASSERT_EQ(*slots[i], static_cast<int64_t>(i));
+    ASSERT_EQ(pool.total_objects(), 1000u);
+    std::size_t blocks = pool.blocks_allocated();
+    for (auto *p : slots)
+      pool.destroy(p);
+    ASSERT_EQ(pool.total_objects(), 0u);
+    // Freed slots satisfy the next round without new blocks
+    std::set<int64_t *> again;
+    for (int i = 0; i < 1000; ++i)
+      ASSERT_TRUE(again.insert(pool.allocate()).second);
+    ASSERT_EQ(pool.blocks_allocated(), blocks);
+  });
+
+  suite.run("MemoryPool: Honours over-aligned types", [] {
+    MemoryPool<Wide> pool;
+    ASSERT_EQ(MemoryPool<Wide>::OBJECT_SIZE % alignof(Wide), 0u);
+    for (int i = 0; i < 200; ++i) {
+      Wide *w = pool.allocate();
+      ASSERT_EQ(reinterpret_cast<uintptr_t>(w) % alignof(Wide), 0u);
+    }
+  });
+
+  suite.run("MemoryPool: Magazine serves most operations", [] {
+    MemoryPool<int64_t> pool;
+    for (int round = 0; round < 100; ++round) {
+      std::vector<int64_t *> slots;
+      for (int i = 0; i < 16; ++i)
+        slots.push_back(pool.allocate());
+      for (auto *p : slots)
+        pool.deallocate(p);
+    }
+    auto s = pool.stats();
+    ASSERT_EQ(s.hits + s.misses, 3200u);
+    ASSERT_EQ(s.threads.size(), 1u);
+    ASSERT_EQ(s.threads[0].hits, s.hits);
+    ASSERT_TRUE(s.hit_ratio() > 0.99);
+    ASSERT_EQ(s.live_objects, 0u);
+    ASSERT_EQ(s.central_free + s.cached_free,
+              s.blocks * (4096 / MemoryPool<int64_t>::OBJECT_SIZE));
+  });
+
+  suite.run("MemoryPool: Cross-thread frees and thread exit", [] {
+    // Producers allocate, the main thread frees; exited threads' magazines
+    // are reclaimed and their counters kept
+    MemoryPool<int64_t> pool;
+    constexpr int THREADS = 4, PER_THREAD = 5000;
+    std::vector<std::vector<int64_t *>> made(THREADS);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < THREADS; ++t)
+      threads.emplace_back([&, t] {
+        for (int i = 0; i < PER_THREAD; ++i) {
+          made[t].push_back(pool.construct(t * PER_THREAD + i));
+          if (i % 3 == 0) {
+            pool.destroy(made[t].back());
+            made[t].pop_back();
+          }
+        }
+      });
+    for (auto &th : threads)
+      th.join();
+    std::set<int64_t *> distinct;
+    std::size_t live = 0;
+    for (auto &v : made)
+      for (auto *p : v) {
+        ASSERT_TRUE(distinct.insert(p).second);
+        live++;
+      }
+    ASSERT_EQ(pool.total_objects(), live);
+    for (auto &v : made)
+      for (auto *p : v)
+        pool.destroy(p);
+    ASSERT_EQ(pool.total_objects(), 0u);
+    // Drain the central list so the next refill reclaims exited magazines
+    std::vector<int64_t *> again;
+    std::size_t capacity = pool.blocks_allocated() *
+                           (4096 / MemoryPool<int64_t>::OBJECT_SIZE);
+    for (std::size_t i = 0; i <= capacity; ++i)
+      again.push_back(pool.allocate());
+    auto s = pool.stats();
+    ASSERT_EQ(s.threads.size(), 1u);
+    ASSERT_EQ(s.live_objects, capacity + 1);
+    ASSERT_TRUE(s.hits + s.misses >= 2u * THREADS * PER_THREAD / 3);
+  });
+
+  suite.run("PoolAllocator: Arrays bypass the pool", [] {
+    MemoryPool<int64_t> pool;
+    billing::core::PoolAllocator<int64_t> alloc(pool);
+    std::vector<int64_t, billing::core::PoolAllocator<int64_t>> v(alloc);
+    for (int i = 0; i < 1000; ++i)
+      v.push_back(i);
+    ASSERT_EQ(v[999], 999);
+    ASSERT_EQ(pool.total_objects(), 0u); // only the 1-slot buffer was pooled
+    int64_t *one = alloc.allocate(1);
+    ASSERT_EQ(pool.total_objects(), 1u);
+    alloc.deallocate(one, 1);
+    ASSERT_EQ(pool.total_objects(), 0u);
+  });
+
+  suite.run("PoolResource: Small requests stay off upstream", [] {
+    billing::core::CountingResource counter;
+    billing::core::PoolResource pool(&counter);
+    {
+      std::pmr::map<int64_t, std::pmr::string> m(&pool);
+      for (int64_t i = 0; i < 5000; ++i)
+        m.emplace(i, "short");
+      ASSERT_EQ(m.size(), 5000u);
+      ASSERT_TRUE(pool.blocks_for(sizeof(*m.begin()) + 32) > 0);
+      ASSERT_EQ(pool.upstream_allocations(), 0u);
+      ASSERT_EQ(counter.allocations(), 0u);
+      std::pmr::vector<char> big(4096, 'x', &pool);
+      ASSERT_EQ(pool.upstream_allocations(), 1u);
+      ASSERT_EQ(counter.allocations(), 1u);
+    }
+    ASSERT_EQ(counter.deallocations(), 1u);
+  });
+
+  suite.run("MonotonicArena: Reset reuses chunks", [] {
+    billing::core::CountingResource counter;
+    billing::core::MonotonicArena arena(256, &counter);
+    std::size_t after_first = 0;
+    for (int round = 0; round < 5; ++round) {
+      arena.reset();
+      ASSERT_EQ(arena.bytes_used(), 0u);
+      std::pmr::vector<int64_t> v(&arena);
+      for (int64_t i = 0; i < 2000; ++i)
+        v.push_back(i);
+      ASSERT_EQ(v[1999], 1999);
+      if (round == 0)
+        after_first = counter.allocations();
+    }
+    // Growth happens once; later rounds bump through the kept chunks
+    ASSERT_EQ(counter.allocations(), after_first);
+    ASSERT_EQ(arena.chunk_count(), after_first);
+    ASSERT_TRUE(arena.bytes_reserved() >= 2000 * sizeof(int64_t));
+    ASSERT_EQ(counter.deallocations(), 0u);
+  });
+
+  suite.run("MonotonicArena: Honours alignment", [] {
+    billing::core::MonotonicArena arena(128);
+    ASSERT_TRUE(arena.allocate(1, 1) != nullptr); // misalign the bump pointer
+    void *p = arena.allocate(sizeof(Wide), alignof(Wide));
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(p) % alignof(Wide), 0u);
+    void *big = arena.allocate(1000, 16);
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(big) % 16, 0u);
+    ASSERT_EQ(arena.chunk_count(), 2u);
+  });
+}
@@ -0,0 +1,113 @@
+// test_monthly_sequence.cpp
+#include "../src/core/monthly_sequence.hpp"
+#include "test_harness.hpp"
+#include <atomic>
+#include <ctime>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+std::atomic<std::time_t> fake_now{0};
+std::time_t fake_clock() { return fake_now.load(); }
+
+} // namespace
+
+void run_monthly_sequence_tests(billing::test::TestSuite &suite) {
+  using billing::core::MonthlySequence;
+  using billing::core::SequenceBlock;
+  using billing::test::local_date;
+  using billing::test::scratch_dir;
+
+  suite.run("MonthlySequence: Blocks are consecutive and formatted", [] {
+    fake_now = local_date(2026, 3, 15);
+    std::string path = scratch_dir("seq", "format") + "/numbers.seq";
+    MonthlySequence seq(path, 16, &fake_clock);
+    SequenceBlock a = seq.reserve(3);
+    SequenceBlock b = seq.reserve(100); // larger than the lease
+    ASSERT_EQ(a.month(), 202603);
+    ASSERT_EQ(a.at(0), 1ULL);
+    ASSERT_EQ(b.at(0), 4ULL);
+    ASSERT_EQ(a.str(2, "INV-"), std::string("INV-2026030003"));
+    ASSERT_EQ(b.str(99, "INV-"), std::string("INV-2026030103"));
+    ASSERT_EQ(seq.next(), 104ULL);
+    ASSERT_THROWS(a.at(3));
+    ASSERT_THROWS(seq.reserve(0));
+  });
+
+  suite.run("MonthlySequence: Restart resumes above the lease", [] {
+    std::string path = scratch_dir("seq", "restart") + "/numbers.seq";
+    fake_now = local_date(2026, 3, 15);
+    uint64_t last = 0;
+    {
+      MonthlySequence seq(path, 8, &fake_clock);
+      for (int i = 0; i < 20; ++i)
+        last = seq.next();
+      ASSERT_EQ(last, 20ULL);
+      ASSERT_EQ(seq.lease_writes(), 3UL); // one file write per 8 numbers
+    }
+    MonthlySequence seq(path, 8, &fake_clock);
+    ASSERT_GT(seq.next(), last);
+    ASSERT_GE(seq.high_water(202603), last);
+  });
+
+  suite.run("MonthlySequence: Numbering restarts each month", [] {
+    fake_now = local_date(2026, 1, 31);
+    std::string path = scratch_dir("seq", "months") + "/numbers.seq";
+    MonthlySequence seq(path, 4, &fake_clock);
+    seq.reserve(10);
+    fake_now = local_date(2026, 2, 1);
+    SequenceBlock feb = seq.reserve(1);
+    ASSERT_EQ(feb.month(), 202602);
+    ASSERT_EQ(feb.at(0), 1ULL);
+    // A late call stamped with January never reuses a January number
+    fake_now = local_date(2026, 1, 31);
+    SequenceBlock jan = seq.reserve(1);
+    ASSERT_EQ(jan.month(), 202601);
+    ASSERT_GT(jan.at(0), 10ULL);
+    fake_now = local_date(2026, 12, 31);
+    ASSERT_EQ(seq.reserve(1).str(0, "X"), std::string("X2026120001"));
+  });
+
+  suite.run("MonthlySequence: Instances sharing a file never collide", [] {
+    std::string path = scratch_dir("seq", "shared") + "/numbers.seq";
+    fake_now = local_date(2026, 3, 15);
+    MonthlySequence a(path, 4, &fake_clock);
+    MonthlySequence b(path, 4, &fake_clock);
+    std::set<uint64_t> all;
+    for (int i = 0; i < 50; ++i)
+      for (MonthlySequence *seq : {&a, &b}) {
+        SequenceBlock block = seq->reserve(3);
+        for (std::size_t k = 0; k < block.size(); ++k)
+          ASSERT_TRUE(all.insert(block.at(k)).second);
+      }
+    MonthlySequence later(path, 4, &fake_clock);
+    ASSERT_GT(later.next(), *all.rbegin());
+  });
+
+  suite.run("MonthlySequence: Concurrent blocks never overlap", [] {
+    fake_now = local_date(2026, 3, 15);
+    std::string path = scratch_dir("seq", "threads") + "/numbers.seq";
+    MonthlySequence seq(path, 64, &fake_clock);
+    const int threads = 4, per_thread = 2000;
+    std::vector<std::vector<uint64_t>> got(threads);
+    std::vector<std::thread> pool;
+    for (int t = 0; t < threads; ++t)
+      pool.emplace_back([&, t] {
+        for (int i = 0; i < per_thread; i += 5) {
+          SequenceBlock b = seq.reserve(5);
+          for (std::size_t k = 0; k < b.size(); ++k)
+            got[t].push_back(b.at(k));
+        }
+      });
+    for (auto &th : pool)
+      th.join();
+    std::set<uint64_t> all;
+    for (auto &g : got)
+      all.insert(g.begin(), g.end());
+    ASSERT_EQ(all.size(), static_cast<std::size_t>(threads * per_thread));
+    ASSERT_EQ(*all.rbegin(), static_cast<uint64_t>(threads * per_thread));
+  });
+}
@@ -0,0 +1,104 @@
+// test_pipeline.cpp
+#include "../src/core/pipeline.hpp"
+#include "../src/core/thread_pool.hpp"
+#include "test_harness.hpp"
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+void run_pipeline_tests(billing::test::TestSuite &suite) {
+  using billing::core::Pipeline;
+  using billing::core::ThreadPool;
+
+  suite.run("Pipeline: Every item passes every stage once", [] {
+    struct Item {
+      int value;
+      int stages;
+    };
+    std::atomic<long> sum{0};
+    ThreadPool pool(3);
+    Pipeline<Item> p(pool, 2);
+    p.stage("double", 3,
+            [](Item &it) {
+              it.value *= 2;
+              it.stages++;
+              return std::size_t{1};
+            })
+        .stage("inc", 2,
+               [](Item &it) {
+                 it.value += 1;
+                 it.stages++;
+                 return std::size_t{1};
+               })
+        .stage("sum", 1, [&](Item &it) {
+          ASSERT_EQ(it.stages, 2);
+          sum += it.value;
+          return std::size_t{2};
+        });
+    p.run([](auto push) {
+      for (int i = 0; i < 1000; ++i)
+        push(Item{i, 0});
+    });
+    ASSERT_EQ(sum.load(), 2L * 999 * 1000 / 2 + 1000);
+    ASSERT_EQ(p.stats().size(), 3u);
+    ASSERT_EQ(p.stats()[0].name, std::string("double"));
+    ASSERT_EQ(p.stats()[0].workers, 3);
+    ASSERT_EQ(p.stats()[1].batches, 1000u);
+    ASSERT_EQ(p.stats()[2].items, 2000u);
+    for (auto &s : p.stats())
+      ASSERT_TRUE(s.max_queue_depth <= 2);
+  });
+
+  suite.run("Pipeline: First stage error stops the run and rethrows", [] {
+    std::atomic<int> reached{0};
+    ThreadPool pool(2);
+    Pipeline<int> p(pool, 1);
+    p.stage("check", 2,
+            [](int &v) {
+              if (v == 50)
+                throw std::runtime_error("bad item");
+              return std::size_t{1};
+            })
+        .stage("count", 1, [&](int &) {
+          reached++;
+          return std::size_t{1};
+        });
+    bool fed_all = true;
+    auto source = [&](auto push) {
+      for (int i = 0; i < 100000; ++i)
+        if (!push(i)) {
+          fed_all = false;
+          return;
+        }
+    };
+    ASSERT_THROWS(p.run(source));
+    // The source sees the abort instead of feeding the whole input
+    ASSERT_FALSE(fed_all);
+    ASSERT_TRUE(reached.load() < 100000);
+    auto noop = [](int &) { return std::size_t{0}; };
+    ASSERT_THROWS(p.stage("none", 0, noop));
+  });
+
+  suite.run("Pipeline: Runs inside a pool task on a one-thread pool", [] {
+    ThreadPool pool(1);
+    auto job = pool.submit([&pool] {
+      long sum = 0;
+      Pipeline<int> p(pool, 2);
+      p.stage("square", 2,
+              [](int &v) {
+                v *= v;
+                return std::size_t{1};
+              })
+          .stage("sum", 1, [&](int &v) {
+            sum += v;
+            return std::size_t{1};
+          });
+      p.run([](auto push) {
+        for (int i = 1; i <= 100; ++i)
+          push(i);
+      });
+      return sum;
+    });
+    ASSERT_EQ(pool.get(job), 338350L);
+  });
+}
@@ -0,0 +1,213 @@
+// test_recurring_billing.cpp
+#include "../src/core/calendar.hpp"
+#include "../src/repository/customer_repository.hpp"
+#include "../src/repository/invoice_repository.hpp"
+#include "../src/service/billing_engine.hpp"
+#include "../src/service/recurring_billing_run.hpp"
+#include "test_harness.hpp"
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+using namespace billing;
+using test::local_date;
+
+void add_customer(repository::CustomerRepository &repo, int64_t id) {
+  models::Customer c{};
+  c.id = id;
+  c.name = "Customer " + std::to_string(id);
+  c.email = "c" + std::to_string(id) + "@test";
+  c.country = "HK";
+  c.created_at = std::time(nullptr);
+  repo.save(c);
+}
+
+models::Invoice make_recurring(service::BillingEngine &engine, int64_t cid,
+                               models::RecurringPeriod period) {
+  service::InvoiceRequest req;
+  req.customer_id = cid;
+  req.type = models::InvoiceType::RECURRING;
+  req.period = period;
+  req.line_items = {{"Subscription", 1, 49.0}};
+  return engine.create_invoice(req);
+}
+
+// Children billed per parent, from the repository
+std::map<int64_t, int> children_by_parent(repository::InvoiceRepository &repo) {
+  std::map<int64_t, int> counts;
+  for (auto &inv : repo.find_all())
+    if (inv.parent_invoice_id)
+      counts[inv.parent_invoice_id]++;
+  return counts;
+}
+
+} // namespace
+
+void run_recurring_billing_tests(billing::test::TestSuite &suite) {
+  suite.run("Calendar: Months clamp to short months without drift", [] {
+    std::time_t jan31 = local_date(2027, 1, 31);
+    std::time_t feb = core::add_months(jan31, 1);
+    ASSERT_EQ(feb, local_date(2027, 2, 28));
+    ASSERT_EQ(core::add_months(feb, 1, 31), local_date(2027, 3, 31));
+    ASSERT_EQ(core::add_months(local_date(2028, 1, 29), 1),
+              local_date(2028, 2, 29)); // leap year
+    ASSERT_EQ(core::add_months(local_date(2028, 2, 29), 12),
+              local_date(2029, 2, 28));
+    ASSERT_EQ(core::add_months(local_date(2026, 12, 15), 1),
+              local_date(2027, 1, 15));
+    ASSERT_EQ(core::add_months(local_date(2027, 1, 15), -1),
+              local_date(2026, 12, 15));
+    ASSERT_EQ(core::add_days(local_date(2027, 2, 27), 2),
+              local_date(2027, 3, 1));
+    ASSERT_EQ(core::days_in_month(2100, 2), 28);
+    ASSERT_EQ(core::days_in_month(2000, 2), 29);
+  });
+
+  suite.run("RecurringBillingRun: Bills due parents once, by index", [] {
+    auto dir = test::scratch_dir("recurring", "run");
+    repository::CustomerRepository customers(dir);
+    repository::InvoiceRepository invoices(dir);
+    service::DiscountEngine disc;
+    service::TaxEngine tax;
+    add_customer(customers, 1);
+    service::BillingEngine engine(invoices, customers, disc, tax);
+
+    auto monthly = make_recurring(engine, 1, models::RecurringPeriod::MONTHLY);
+    auto yearly = make_recurring(engine, 1, models::RecurringPeriod::YEARLY);
+    service::InvoiceRequest once;
+    once.customer_id = 1;
+    once.type = models::InvoiceType::ONE_TIME;
+    once.line_items = {{"Setup", 1, 10.0}};
+    engine.create_invoice(once);
+    ASSERT_EQ(monthly.next_billing_date,
+              core::add_months(monthly.issue_date, 1));
+    ASSERT_EQ(invoices.billing_due_ids(monthly.next_billing_date).size(), 1u);
+
+    service::RecurringBillingRun run(engine, invoices);
+    auto stats = run.run(monthly.next_billing_date);
+    ASSERT_EQ(stats.created, 1u);
+    ASSERT_EQ(stats.passes, 1u);
+    ASSERT_TRUE(stats.failures.empty());
+    ASSERT_FALSE(run.pending().has_value());
+
+    auto parent = invoices.find_by_id(monthly.id);
+    std::time_t next = core::add_months(monthly.issue_date, 2);
+    ASSERT_EQ(parent->next_billing_date, next);
+    bool found = false;
+    for (auto &inv : invoices.find_by_customer(1)) {
+      if (inv.parent_invoice_id != monthly.id)
+        continue;
+      found = true;
+      ASSERT_EQ(inv.period_start, monthly.next_billing_date);
+      ASSERT_EQ(inv.period_end, next);
+      ASSERT_EQ(inv.next_billing_date, 0);
+    }
+    ASSERT_TRUE(found);
+
+    // Same date again: nothing is due any more
+    ASSERT_EQ(run.run(monthly.next_billing_date).created, 0u);
+    ASSERT_EQ(invoices.find_by_id(yearly.id)->next_billing_date,
+              yearly.next_billing_date);
+    ASSERT_TRUE(invoices.verify_indexes());
+  });
+
+  suite.run("BillingEngine: Repeated parent ids bill one cycle", [] {
+    auto dir = test::scratch_dir("recurring", "dupes");
+    repository::CustomerRepository customers(dir);
+    repository::InvoiceRepository invoices(dir);
+    service::DiscountEngine disc;
+    service::TaxEngine tax;
+    add_customer(customers, 1);
+    service::BillingEngine engine(invoices, customers, disc, tax);
+    auto root = make_recurring(engine, 1, models::RecurringPeriod::MONTHLY);
+
+    auto out = engine.bill_recurring({root.id, root.id, root.id},
+                                     root.next_billing_date);
+    ASSERT_EQ(out.invoices.size(), 1u);
+    ASSERT_TRUE(out.failures.empty());
+    ASSERT_EQ(children_by_parent(invoices)[root.id], 1);
+    ASSERT_EQ(invoices.find_by_id(root.id)->next_billing_date,
+              core::add_months(root.issue_date, 2));
+  });
+
+  suite.run("RecurringBillingRun: Catches up missed cycles", [] {
+    auto dir = test::scratch_dir("recurring", "catchup");
+    repository::CustomerRepository customers(dir);
+    repository::InvoiceRepository invoices(dir);
+    service::DiscountEngine disc;
+    service::TaxEngine tax;
+    add_customer(customers, 1);
+    service::BillingEngine engine(invoices, customers, disc, tax);
+    auto root = make_recurring(engine, 1, models::RecurringPeriod::MONTHLY);
+
+    service::RecurringBillingRun run(engine, invoices);
+    auto stats = run.run(core::add_months(root.issue_date, 3));
+    ASSERT_EQ(stats.created, 3u);
+    ASSERT_EQ(stats.passes, 3u);
+    ASSERT_EQ(invoices.find_by_id(root.id)->next_billing_date,
+              core::add_months(root.issue_date, 4));
+
+    // generate_next_recurring bills the following cycle and advances too
+    auto next = engine.generate_next_recurring(root);
+    ASSERT_TRUE(next.has_value());
+    ASSERT_EQ(next->period_start, core::add_months(root.issue_date, 4));
+    ASSERT_EQ(invoices.find_by_id(root.id)->next_billing_date,
+              core::add_months(root.issue_date, 5));
+    ASSERT_EQ(children_by_parent(invoices)[root.id], 4);
+  });
+
+  suite.run("RecurringBillingRun: Interrupted run resumes, no doubles", [] {
+    auto dir = test::scratch_dir("recurring", "resume");
+    repository::CustomerRepository customers(dir);
+    repository::InvoiceRepository invoices(dir);
+    service::DiscountEngine disc;
+    service::TaxEngine tax;
+    add_customer(customers, 1);
+    service::BillingEngine engine(invoices, customers, disc, tax);
+    std::vector<models::Invoice> roots;
+    for (int i = 0; i < 12; ++i)
+      roots.push_back(
+          make_recurring(engine, 1, models::RecurringPeriod::WEEKLY));
+    std::time_t date = core::add_days(roots.back().issue_date, 7);
+
+    service::BatchOptions opts;
+    opts.chunk_size = 4;
+    opts.price_workers = 1;
+    {
+      service::RecurringBillingRun run(engine, invoices, opts);
+      run.on_progress([](std::size_t created) {
+        if (created >= 4)
+          throw std::runtime_error("interrupted");
+      });
+      bool threw = false;
+      try {
+        run.run(date);
+      } catch (const std::runtime_error &) {
+        threw = true;
+      }
+      ASSERT_TRUE(threw);
+    }
+    std::size_t billed = 0;
+    for (auto &[parent, n] : children_by_parent(invoices))
+      billed += n;
+    ASSERT_GT(billed, 0u);
+    ASSERT_LT(billed, 12u);
+
+    service::RecurringBillingRun run(engine, invoices, opts);
+    ASSERT_TRUE(run.pending().has_value());
+    ASSERT_EQ(*run.pending(), date);
+    ASSERT_THROWS(run.run(date + 86400));
+    auto stats = run.resume();
+    ASSERT_TRUE(stats.has_value());
+    ASSERT_TRUE(stats->resumed);
+    ASSERT_EQ(stats->created, 12u);
+    ASSERT_FALSE(run.pending().has_value());
+    auto counts = children_by_parent(invoices);
+    for (auto &root : roots)
+      ASSERT_EQ(counts[root.id], 1);
+    ASSERT_TRUE(invoices.verify_indexes());
+  });
+}
@@ -3,7 +3,10 @@
 #include "../src/models/customer.hpp"
 #include "../src/models/invoice.hpp"
 #include "../src/service/graph_billing.hpp"
+#include "../src/service/report_service.hpp"
 #include "test_harness.hpp"
+#include <filesystem>
+#include <set>
 
 void run_report_service_tests(billing::test::TestSuite &suite) {
   using namespace billing;
@@ -90,4 +93,36 @@ void run_report_service_tests(billing::test::TestSuite &suite) {
     auto reachable = g.bfs_reachable(1);
     ASSERT_EQ(reachable.size(), 4u);
   });
+
+  suite.run("ReportService: export_all writes every report via the pool", [] {
+    auto dir = std::filesystem::temp_directory_path() / "billing_export_all";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    repository::CustomerRepository customers(dir.string());
+    repository::InvoiceRepository invoices(dir.string());
+    repository::PaymentRepository payments(dir.string());
+    for (int64_t id = 1; id <= 1500; ++id) {
+      models::Customer c{};
+      c.id = id;
+      c.name = "Customer " + std::to_string(id);
+      c.email = "c" + std::to_string(id) + "@test";
+      c.created_at = std::time(nullptr) - 90 * 86400;
+      customers.save(c);
+    }
+    core::ThreadPool pool(2);
+    service::ReportService reports(invoices, customers, payments,
+                                   dir.string(), pool);
+    auto clv = reports.customer_clv_report();
+    ASSERT_EQ(clv.size(), 1500u); // three pool chunks, none lost
+    std::set<int64_t> seen;
+    for (auto &r : clv)
+      seen.insert(r.customer_id);
+    ASSERT_EQ(seen.size(), 1500u);
+
+    auto paths = reports.export_all(3);
+    ASSERT_EQ(paths.size(), 3u);
+    for (auto &path : paths)
+      ASSERT_TRUE(std::filesystem::exists(path));
+    std::filesystem::remove_all(dir);
+  });
 }
@@ -0,0 +1,239 @@
+// test_repository_indexes.cpp
+#include "../src/repository/customer_repository.hpp"
+#include "../src/repository/invoice_repository.hpp"
+#include "../src/repository/payment_repository.hpp"
+#include "../src/repository/write_batch.hpp"
+#include "../src/core/memory_resource.hpp"
+#include "test_harness.hpp"
+
+namespace {
+
+billing::models::Customer make_customer(int64_t id, const std::string &email) {
+  billing::models::Customer c{};
+  c.id = id;
+  c.name = "Customer " + std::to_string(id);
+  c.email = email;
+  return c;
+}
+
+billing::models::Payment make_payment(int64_t id, int64_t invoice_id,
+                                      int64_t customer_id, std::time_t at) {
+  billing::models::Payment p{};
+  p.id = id;
+  p.invoice_id = invoice_id;
+  p.customer_id = customer_id;
+  p.status = billing::models::PaymentStatus::COMPLETED;
+  p.amount = 10.0 * static_cast<double>(id);
+  p.completed_at = at;
+  return p;
+}
+
+} // namespace
+
+void run_repository_index_tests(billing::test::TestSuite &suite) {
+  using namespace billing;
+  using models::InvoiceStatus;
+  using test::make_invoice;
+  using test::scratch_dir;
+
+  suite.run("InvoiceRepository: Customer/status indexes follow updates", [] {
+    std::time_t now = std::time(nullptr);
+    repository::InvoiceRepository repo(scratch_dir("idx", "customer"));
+    for (int64_t id = 1; id <= 30; ++id)
+      repo.save(make_invoice(id, id % 3, 100.0, now + 3600));
+    ASSERT_EQ(repo.find_by_customer(1).size(), 10u);
+    auto inv = *repo.find_by_id(4); // customer 1
+    inv.customer_id = 7;
+    inv.status = InvoiceStatus::PAID;
+    repo.update(inv);
+    repo.remove(7); // customer 1
+    ASSERT_EQ(repo.find_by_customer(1).size(), 8u);
+    ASSERT_EQ(repo.find_by_customer(7).size(), 1u);
+    ASSERT_EQ(repo.find_by_status(InvoiceStatus::PAID).size(), 1u);
+    ASSERT_EQ(repo.find_by_status(InvoiceStatus::PENDING).size(), 28u);
+    ASSERT_TRUE(repo.verify_indexes());
+  });
+
+  suite.run("InvoiceRepository: Overdue is a range over open invoices", [] {
+    std::time_t now = std::time(nullptr);
+    repository::InvoiceRepository repo(scratch_dir("idx", "overdue"));
+    repo.save(make_invoice(1, 1, 100.0, now - 7200));
+    repo.save(make_invoice(2, 1, 100.0, now - 3600));
+    repo.save(make_invoice(3, 1, 100.0, now + 3600));
+    auto paid = make_invoice(4, 1, 100.0, now - 7200);
+    paid.status = InvoiceStatus::PAID;
+    repo.save(paid);
+    auto overdue = repo.find_overdue();
+    ASSERT_EQ(overdue.size(), 2u);
+    ASSERT_EQ(overdue[0].id, 1); // oldest due date first
+    auto inv = *repo.find_by_id(2);
+    inv.status = InvoiceStatus::CANCELLED;
+    repo.update(inv);
+    ASSERT_EQ(repo.find_overdue().size(), 1u);
+    ASSERT_EQ(repo.find_due_before(now + 7200).size(), 2u);
+    ASSERT_TRUE(repo.verify_indexes());
+  });
+
+  suite.run("InvoiceRepository: Indexes are rebuilt on reopen", [] {
+    std::time_t now = std::time(nullptr);
+    auto dir = scratch_dir("idx", "reopen");
+    {
+      repository::InvoiceRepository repo(dir);
+      for (int64_t id = 1; id <= 20; ++id)
+        repo.save(make_invoice(id, id % 4, 100.0, now + (id % 2 ? -60 : 60)));
+      repo.checkpoint();
+      repo.remove(1); // only in the log
+    }
+    repository::InvoiceRepository repo(dir);
+    ASSERT_TRUE(repo.verify_indexes());
+    ASSERT_EQ(repo.find_overdue().size(), 9u);
+    ASSERT_EQ(repo.find_by_customer(1).size(), 4u);
+  });
+
+  suite.run("CustomerRepository: Email lookup ignores case and spaces", [] {
+    repository::CustomerRepository repo(scratch_dir("idx", "email"));
+    repo.save(make_customer(1, "Alice@Example.com"));
+    auto c = repo.find_by_email("  alice@EXAMPLE.com ");
+    ASSERT_TRUE(c.has_value());
+    ASSERT_EQ(c->id, 1);
+    ASSERT_TRUE(repo.email_taken("ALICE@example.com"));
+    ASSERT_FALSE(repo.find_by_email("bob@example.com").has_value());
+  });
+
+  suite.run("CustomerRepository: Duplicate email is rejected", [] {
+    repository::CustomerRepository repo(scratch_dir("idx", "email_dup"));
+    repo.save(make_customer(1, "alice@example.com"));
+    repo.save(make_customer(2, "bob@example.com"));
+    ASSERT_THROWS(repo.save(make_customer(3, "ALICE@example.com")));
+    ASSERT_THROWS(repo.update(make_customer(2, "alice@example.com")));
+    ASSERT_EQ(repo.count(), 2u);
+    ASSERT_EQ(repo.find_by_email("bob@example.com")->id, 2);
+    // Changing or removing frees the old address
+    repo.update(make_customer(1, "alice@new.example.com"));
+    repo.save(make_customer(3, "alice@example.com"));
+    repo.remove(2);
+    repo.save(make_customer(4, "bob@example.com"));
+    ASSERT_EQ(repo.find_by_email("alice@example.com")->id, 3);
+    ASSERT_EQ(repo.find_by_email("bob@example.com")->id, 4);
+  });
+
+  suite.run("CustomerRepository: Conflicting batch applies nothing", [] {
+    repository::CustomerRepository repo(scratch_dir("idx", "email_batch"));
+    repo.save(make_customer(1, "alice@example.com"));
+    repository::WriteBatch bad;
+    bad.save(make_customer(2, "carol@example.com"));
+    bad.save(make_customer(3, "Carol@example.com"));
+    ASSERT_THROWS(bad.commit(repo));
+    ASSERT_EQ(repo.count(), 1u);
+    repository::WriteBatch swap; // release then reuse within one batch
+    swap.remove_customer(1);
+    swap.save(make_customer(5, "alice@example.com"));
+    ASSERT_EQ(swap.commit(repo), 2u);
+    ASSERT_EQ(repo.find_by_email("alice@example.com")->id, 5);
+  });
+
+  suite.run("CustomerRepository: Email index is rebuilt on reopen", [] {
+    auto dir = scratch_dir("idx", "email_reopen");
+    {
+      repository::CustomerRepository repo(dir);
+      for (int64_t id = 1; id <= 10; ++id)
+        repo.save(make_customer(id, "user" + std::to_string(id) + "@x.io"));
+    }
+    repository::CustomerRepository repo(dir);
+    ASSERT_EQ(repo.find_by_email("USER7@x.io")->id, 7);
+    ASSERT_THROWS(repo.save(make_customer(11, "user3@x.io")));
+  });
+
+  suite.run("CustomerRepository: Losing duplicates keep owner's email", [] {
+    auto dir = scratch_dir("idx", "email_legacy");
+    {
+      // Written before the index existed: three customers, one email
+      repository::RecordStore<repository::CustomerCodec> store;
+      for (int64_t id = 1; id <= 3; ++id)
+        store.put(make_customer(id, "dup@x.io"));
+      store.checkpoint(dir + "/customers.bin");
+    }
+    repository::CustomerRepository repo(dir);
+    ASSERT_EQ(repo.find_by_email("dup@x.io")->id, 1);
+    repository::WriteBatch batch; // a loser leaving frees nothing
+    batch.remove_customer(3);
+    batch.save(make_customer(5, "dup@x.io"));
+    ASSERT_THROWS(batch.commit(repo));
+    repo.update(make_customer(2, "two@x.io"));
+    repo.remove(3);
+    ASSERT_EQ(repo.find_by_email("DUP@x.io")->id, 1);
+    ASSERT_THROWS(repo.save(make_customer(4, "dup@x.io")));
+  });
+
+  suite.run("PaymentRepository: Posting lists follow updates", [] {
+    repository::PaymentRepository repo(scratch_dir("idx", "payments"));
+    for (int64_t id = 1; id <= 12; ++id)
+      repo.save(make_payment(id, 100 + id % 4, id % 3, 1000 + id));
+    ASSERT_EQ(repo.find_by_invoice(101).size(), 3u);
+    ASSERT_EQ(repo.find_by_customer(0).size(), 4u);
+    auto p = *repo.find_by_id(3); // invoice 103, customer 0
+    p.invoice_id = 101;
+    p.customer_id = 9;
+    repo.update(p);
+    ASSERT_EQ(repo.find_by_invoice(101).size(), 4u);
+    ASSERT_EQ(repo.find_by_invoice(103).size(), 2u);
+    ASSERT_EQ(repo.find_by_customer(9).size(), 1u);
+    ASSERT_NEAR(repo.completed_total_for_customer(9), 30.0, 0.001);
+    ASSERT_TRUE(repo.verify_indexes());
+  });
+
+  suite.run("PaymentRepository: Completed-time window query", [] {
+    auto dir = scratch_dir("idx", "payment_window");
+    {
+      repository::PaymentRepository repo(dir);
+      for (int64_t id = 1; id <= 10; ++id)
+        repo.save(make_payment(id, id, 1, 5000 - 100 * id));
+      auto refunded = *repo.find_by_id(5); // completed_at 4500
+      refunded.status = models::PaymentStatus::REFUNDED;
+      repo.update(refunded);
+    }
+    repository::PaymentRepository repo(dir);
+    ASSERT_TRUE(repo.verify_indexes());
+    auto window = repo.find_completed_between(4300, 4700);
+    ASSERT_EQ(window.size(), 4u); // ids 7, 6, 4, 3 — 5 was refunded
+    ASSERT_EQ(window.front().id, 7);
+    ASSERT_EQ(window.back().id, 3);
+    auto amounts = repo.completed_amounts();
+    ASSERT_EQ(amounts.size(), 9u);
+    ASSERT_TRUE(std::is_sorted(amounts.begin(), amounts.end()));
+  });
+
+  suite.run("InvoiceRepository: Balances follow find_all into an arena", [] {
+    auto dir = scratch_dir("idx", "invoice_balances");
+    std::time_t now = std::time(nullptr);
+    {
+      repository::InvoiceRepository repo(dir);
+      for (int64_t id = 1; id <= 6; ++id)
+        repo.save(make_invoice(id, 1, 100.0, now - 86400 * 20 * id));
+      repo.checkpoint();
+    }
+    repository::InvoiceRepository repo(dir);
+    auto paid = *repo.find_by_id(2); // overlay record over the snapshot
+    paid.amount_paid = paid.total_amount;
+    paid.status = models::InvoiceStatus::PAID;
+    repo.update(paid);
+    repo.save(make_invoice(7, 1, 100.0, now + 86400));
+
+    core::CountingResource counter;
+    core::MonotonicArena arena(1024, &counter);
+    auto balances = repo.balances(&arena);
+    auto all = repo.find_all();
+    ASSERT_EQ(balances.size(), all.size());
+    for (std::size_t i = 0; i < all.size(); ++i) {
+      ASSERT_EQ(balances[i].id, all[i].id);
+      ASSERT_NEAR(balances[i].amount_due(), all[i].amount_due(), 0.001);
+      ASSERT_EQ(balances[i].days_overdue(now), all[i].days_overdue());
+    }
+    ASSERT_EQ(counter.allocations(), arena.chunk_count());
+    std::vector<int64_t> ids = {7, 99, 3};
+    auto picked = repo.find_many(ids);
+    ASSERT_EQ(picked.size(), 2u);
+    ASSERT_EQ(picked[0].id, 7);
+    ASSERT_EQ(picked[1].id, 3);
+  });
+}
@@ -11,6 +11,17 @@ void run_payment_processor_tests(billing::test::TestSuite &);
 void run_fraud_detector_tests(billing::test::TestSuite &);
 void run_report_service_tests(billing::test::TestSuite &);
 void run_rbac_tests(billing::test::TestSuite &);
+void run_write_ahead_log_tests(billing::test::TestSuite &);
+void run_snapshot_tests(billing::test::TestSuite &);
+void run_repository_index_tests(billing::test::TestSuite &);
+void run_concurrent_bplus_tree_tests(billing::test::TestSuite &);
+void run_memory_pool_tests(billing::test::TestSuite &);
+void run_timing_wheel_tests(billing::test::TestSuite &);
+void run_indexed_heap_tests(billing::test::TestSuite &);
+void run_pipeline_tests(billing::test::TestSuite &);
+void run_thread_pool_tests(billing::test::TestSuite &);
+void run_monthly_sequence_tests(billing::test::TestSuite &);
+void run_recurring_billing_tests(billing::test::TestSuite &);
 
 int main() {
   std::cout << "\n========================================\n";
@@ -37,6 +48,17 @@ int main() {
   run_suite("Fraud Detector", run_fraud_detector_tests);
   run_suite("Report Service", run_report_service_tests);
   run_suite("RBAC", run_rbac_tests);
+  run_suite("Write-Ahead Log", run_write_ahead_log_tests);
+  run_suite("Snapshot", run_snapshot_tests);
+  run_suite("Repository Indexes", run_repository_index_tests);
+  run_suite("Concurrent B+ Tree", run_concurrent_bplus_tree_tests);
+  run_suite("Memory Pool", run_memory_pool_tests);
+  run_suite("Timing Wheel", run_timing_wheel_tests);
+  run_suite("Indexed Heap", run_indexed_heap_tests);
+  run_suite("Thread Pool", run_thread_pool_tests);
+  run_suite("Pipeline", run_pipeline_tests);
+  run_suite("Monthly Sequence", run_monthly_sequence_tests);
+  run_suite("Recurring Billing", run_recurring_billing_tests);
 
   std::cout << "\n========================================\n";
   std::cout << "  TOTAL: " << total_passed << " passed, " << total_failed
@@ -0,0 +1,177 @@
+// test_snapshot.cpp
+#include "../src/repository/customer_repository.hpp"
+#include "../src/repository/invoice_repository.hpp"
+#include "../src/repository/payment_repository.hpp"
+#include "../src/repository/snapshot.hpp"
+#include "test_harness.hpp"
+#include <fstream>
+
+namespace {
+
+// Two line items and non-default strings, to exercise the codecs
+billing::models::Invoice codec_invoice(int64_t id, int64_t customer_id) {
+  auto inv = billing::test::make_invoice(id, customer_id, 174.5,
+                                         1700000000 + id);
+  inv.line_items = {{"Cloud Storage (TB)", 3, 25.0}, {"Support Plan", 1, 99.5}};
+  inv.currency = "EUR";
+  inv.jurisdiction = "DE";
+  return inv;
+}
+
+void write_legacy_string(std::ofstream &f, const std::string &s) {
+  std::size_t len = s.size();
+  f.write(reinterpret_cast<const char *>(&len), sizeof(len));
+  f.write(s.data(), static_cast<std::streamsize>(len));
+}
+
+} // namespace
+
+void run_snapshot_tests(billing::test::TestSuite &suite) {
+  using namespace billing;
+  using Store = repository::RecordStore<repository::InvoiceCodec>;
+  using test::scratch_dir;
+
+  suite.run("Snapshot: Round-trip preserves strings and line items", [] {
+    auto path = scratch_dir("snap", "roundtrip") + "/invoices.bin";
+    {
+      Store store;
+      for (int64_t id : {30, 10, 20})
+        store.put(codec_invoice(id, id / 10));
+      store.checkpoint(path);
+    }
+    Store store;
+    ASSERT_TRUE(store.open(path));
+    ASSERT_EQ(store.size(), 3u);
+    ASSERT_EQ(store.overlay_size(), 0u);
+    auto inv = store.get(20);
+    ASSERT_TRUE(inv.has_value());
+    ASSERT_EQ(inv->invoice_number, "INV-20");
+    ASSERT_EQ(inv->jurisdiction, "DE");
+    ASSERT_EQ(inv->line_items.size(), 2u);
+    ASSERT_EQ(inv->line_items[1].description, "Support Plan");
+    ASSERT_NEAR(inv->line_items[0].unit_price, 25.0, 0.001);
+    ASSERT_FALSE(store.get(15).has_value());
+  });
+
+  suite.run("Snapshot: Overlay shadows and erases mapped records", [] {
+    auto path = scratch_dir("snap", "overlay") + "/invoices.bin";
+    Store store;
+    for (int64_t id = 1; id <= 5; ++id)
+      store.put(codec_invoice(id, 1));
+    store.checkpoint(path);
+    auto changed = codec_invoice(2, 9);
+    store.put(changed);
+    ASSERT_TRUE(store.erase(3));
+    ASSERT_FALSE(store.erase(3));
+    store.put(codec_invoice(6, 1));
+    ASSERT_EQ(store.size(), 5u);
+    ASSERT_FALSE(store.contains(3));
+    ASSERT_EQ(store.get(2)->customer_id, 9);
+    ASSERT_EQ(store.select([](const auto &r) { return r.customer_id == 1; })
+                  .size(),
+              4u);
+    store.checkpoint(path);
+    Store reopened;
+    ASSERT_TRUE(reopened.open(path));
+    ASSERT_EQ(reopened.size(), 5u);
+    ASSERT_FALSE(reopened.contains(3));
+    ASSERT_EQ(reopened.get(2)->customer_id, 9);
+  });
+
+  suite.run("Snapshot: Writes after a freeze outlive the install", [] {
+    auto path = scratch_dir("snap", "freeze") + "/invoices.bin";
+    Store store;
+    store.put(codec_invoice(1, 1));
+    store.put(codec_invoice(2, 1));
+    auto frozen = store.freeze();
+    store.put(codec_invoice(3, 1)); // lands while the snapshot is written
+    store.erase(2);                // erases a record the snapshot contains
+    Store::write(path, frozen);
+    store.install(path, frozen);
+    ASSERT_EQ(store.size(), 2u);
+    ASSERT_TRUE(store.contains(1));
+    ASSERT_FALSE(store.contains(2));
+    ASSERT_TRUE(store.contains(3));
+    ASSERT_EQ(store.snapshot_size(), 2u);
+  });
+
+  suite.run("Snapshot: Corrupt header is rejected", [] {
+    auto path = scratch_dir("snap", "corrupt") + "/invoices.bin";
+    {
+      std::ofstream f(path, std::ios::binary);
+      f.write(repository::snapshot::MAGIC, sizeof(repository::snapshot::MAGIC));
+      f.write("truncated", 9);
+    }
+    Store store;
+    ASSERT_THROWS(store.open(path));
+  });
+
+  suite.run("CustomerRepository: Legacy file is migrated on open", [] {
+    auto dir = scratch_dir("snap", "legacy");
+    {
+      std::ofstream f(dir + "/customers.bin", std::ios::binary);
+      std::size_t count = 1;
+      f.write(reinterpret_cast<const char *>(&count), sizeof(count));
+      models::Customer c{};
+      c.id = 42;
+      c.tier = models::CustomerTier::GOLD;
+      f.write(reinterpret_cast<const char *>(&c.id), sizeof(c.id));
+      for (const char *s : {"Legacy Ltd", "legacy@example.com", "555-0100",
+                            "1 Old Road", "US", "CA"})
+        write_legacy_string(f, s);
+      f.write(reinterpret_cast<const char *>(&c.tier), sizeof(c.tier));
+      f.write(reinterpret_cast<const char *>(&c.status), sizeof(c.status));
+      f.write(reinterpret_cast<const char *>(&c.credit_score),
+              sizeof(c.credit_score));
+      f.write(reinterpret_cast<const char *>(&c.credit_limit),
+              sizeof(c.credit_limit));
+      f.write(reinterpret_cast<const char *>(&c.current_balance),
+              sizeof(c.current_balance));
+      f.write(reinterpret_cast<const char *>(&c.total_spent),
+              sizeof(c.total_spent));
+      f.write(reinterpret_cast<const char *>(&c.created_at),
+              sizeof(c.created_at));
+      f.write(reinterpret_cast<const char *>(&c.updated_at),
+              sizeof(c.updated_at));
+    }
+    {
+      repository::CustomerRepository repo(dir);
+      ASSERT_EQ(repo.count(), 1u);
+      ASSERT_TRUE(repo.find_by_email("legacy@example.com").has_value());
+    }
+    using Snap = repository::SnapshotFile<repository::CustomerCodec>;
+    ASSERT_TRUE(Snap::is_snapshot(dir + "/customers.bin"));
+    repository::CustomerRepository repo(dir);
+    auto c = repo.find_by_id(42);
+    ASSERT_TRUE(c.has_value());
+    ASSERT_EQ(c->state, "CA");
+    ASSERT_TRUE(c->tier == models::CustomerTier::GOLD);
+  });
+
+  suite.run("Repositories: Reopen serves queries from the mapped file", [] {
+    auto dir = scratch_dir("snap", "reopen");
+    {
+      repository::InvoiceRepository invoices(dir);
+      repository::PaymentRepository payments(dir);
+      for (int64_t id = 1; id <= 50; ++id) {
+        invoices.save(codec_invoice(id, id % 5));
+        models::Payment p{};
+        p.id = 1000 + id;
+        p.invoice_id = id;
+        p.customer_id = id % 5;
+        p.gateway_ref = "GW-" + std::to_string(id);
+        payments.save(p);
+      }
+      invoices.checkpoint();
+    }
+    repository::InvoiceRepository invoices(dir);
+    repository::PaymentRepository payments(dir);
+    ASSERT_EQ(invoices.count(), 50u);
+    ASSERT_EQ(invoices.find_by_customer(3).size(), 10u);
+    ASSERT_EQ(invoices.find_by_id(7)->line_items.size(), 2u);
+    ASSERT_EQ(payments.count(), 50u);
+    auto paid = payments.find_by_invoice(7);
+    ASSERT_EQ(paid.size(), 1u);
+    ASSERT_EQ(paid[0].gateway_ref, "GW-7");
+  });
+}
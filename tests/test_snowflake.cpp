@@ -1,10 +1,20 @@
 // test_snowflake.cpp
 #include "../src/core/snowflake.hpp"
 #include "test_harness.hpp"
+#include <atomic>
+#include <chrono>
+#include <mutex>
 #include <thread>
 #include <unordered_set>
 #include <vector>
 
+namespace {
+
+std::atomic<int64_t> fake_now_ms{1750000000000LL};
+int64_t fake_clock() { return fake_now_ms.load(); }
+
+} // namespace
+
 void run_snowflake_tests(billing::test::TestSuite &suite) {
   using billing::core::SnowflakeGenerator;
 
@@ -63,4 +73,122 @@ void run_snowflake_tests(billing::test::TestSuite &suite) {
     ASSERT_THROWS(SnowflakeGenerator bad(1024));
     ASSERT_THROWS(SnowflakeGenerator bad2(-1));
   });
+
+  suite.run("Snowflake: Reserved block is contiguous and unique", [] {
+    SnowflakeGenerator gen(3);
+    auto before = gen.next();
+    auto block = gen.reserve(10000); // spans several milliseconds' worth
+    auto after = gen.next();
+    ASSERT_EQ(block.size(), 10000u);
+    int64_t prev = before;
+    for (std::size_t i = 0; i < block.size(); ++i) {
+      int64_t id = block.at(i);
+      ASSERT_GT(id, prev);
+      ASSERT_EQ(SnowflakeGenerator::decode(id).worker_id, 3LL);
+      prev = id;
+    }
+    ASSERT_GT(after, prev);
+    ASSERT_EQ(block.next(), block.at(0));
+    ASSERT_EQ(block.remaining(), 9999u);
+    ASSERT_THROWS(block.at(10000));
+    ASSERT_THROWS(gen.reserve(0));
+  });
+
+  suite.run("Snowflake: Exhausted sequence borrows the next ms", [] {
+    SnowflakeGenerator gen(1);
+    std::vector<int64_t> ids(20000);
+    for (auto &id : ids)
+      id = gen.next();
+    for (std::size_t i = 1; i < ids.size(); ++i)
+      ASSERT_GT(ids[i], ids[i - 1]);
+    // Never more than 4096 IDs per timestamp
+    auto first = SnowflakeGenerator::decode(ids.front()).timestamp_ms;
+    auto last = SnowflakeGenerator::decode(ids.back()).timestamp_ms;
+    ASSERT_GE(last - first, 4LL);
+  });
+
+  suite.run("Snowflake: Blocks and single IDs never collide", [] {
+    SnowflakeGenerator gen(5);
+    std::vector<std::vector<int64_t>> made(4);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t)
+      threads.emplace_back([&, t] {
+        for (int round = 0; round < 50; ++round) {
+          auto block = gen.reserve(64);
+          while (!block.empty())
+            made[t].push_back(block.next());
+          for (int i = 0; i < 64; ++i)
+            made[t].push_back(gen.next());
+        }
+      });
+    for (auto &th : threads)
+      th.join();
+    std::unordered_set<int64_t> unique;
+    for (auto &v : made)
+      unique.insert(v.begin(), v.end());
+    ASSERT_EQ(unique.size(), 4u * 50 * 128);
+  });
+
+  suite.run("Snowflake: Worker id is configurable", [] {
+    SnowflakeGenerator gen(1);
+    gen.set_worker_id(900);
+    ASSERT_EQ(gen.worker_id(), 900LL);
+    ASSERT_EQ(SnowflakeGenerator::decode(gen.next()).worker_id, 900LL);
+    ASSERT_THROWS(gen.set_worker_id(SnowflakeGenerator::MAX_WORKER + 1));
+  });
+
+  suite.run("Snowflake: Clock step back falls back to logical time", [] {
+    fake_now_ms = 1750000000000LL;
+    SnowflakeGenerator gen(1, &fake_clock);
+    int64_t prev = gen.next();
+    fake_now_ms -= 5000; // NTP step
+    for (int i = 0; i < 10000; ++i) {
+      int64_t id = gen.next();
+      ASSERT_GT(id, prev);
+      prev = id;
+    }
+    ASSERT_EQ(gen.skew_events(), 1u); // one step, counted once
+    ASSERT_EQ(gen.max_skew_ms(), 5000LL);
+    ASSERT_GE(gen.logical_lead_ms(), 5000LL);
+    fake_now_ms -= 10;
+    gen.next();
+    ASSERT_EQ(gen.skew_events(), 2u);
+    ASSERT_EQ(gen.max_skew_ms(), 5000LL);
+    fake_now_ms += 60000; // wall clock passes the logical one again
+    int64_t id = gen.next();
+    ASSERT_GT(id, prev);
+    ASSERT_EQ(gen.logical_lead_ms(), 0LL);
+    ASSERT_EQ(SnowflakeGenerator::decode(id).timestamp_ms, fake_now_ms.load());
+  });
+
+  suite.run("Snowflake: Borrowing waits past the lead cap", [] {
+    fake_now_ms = 1750000000000LL;
+    SnowflakeGenerator gen(2, &fake_clock);
+    // Fill the sequences up to the cap while the clock stands still
+    const std::size_t room = 4096 * (SnowflakeGenerator::MAX_LEAD_MS + 1);
+    auto block = gen.reserve(room);
+    ASSERT_EQ(gen.logical_lead_ms(), SnowflakeGenerator::MAX_LEAD_MS);
+    std::atomic<int64_t> got{0};
+    std::thread waiter([&] { got = gen.next(); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    ASSERT_EQ(got.load(), 0LL); // still waiting for the clock
+    fake_now_ms += 1;
+    waiter.join();
+    ASSERT_GT(got.load(), block.at(room - 1));
+    ASSERT_TRUE(gen.logical_lead_ms() <= SnowflakeGenerator::MAX_LEAD_MS);
+  });
+
+  suite.run("Snowflake: next_n fills consecutive IDs", [] {
+    fake_now_ms = 1750000000000LL;
+    SnowflakeGenerator gen(7, &fake_clock);
+    int64_t before = gen.next();
+    std::vector<int64_t> ids(10000);
+    gen.next_n(ids.size(), ids.data());
+    ASSERT_GT(ids[0], before);
+    for (std::size_t i = 1; i < ids.size(); ++i)
+      ASSERT_GT(ids[i], ids[i - 1]);
+    ASSERT_GT(gen.next(), ids.back());
+    ASSERT_EQ(gen.skew_events(), 0u);
+    gen.next_n(0, nullptr);
+  });
 }
@@ -0,0 +1,90 @@
+// test_thread_pool.cpp
+#include "../src/core/thread_pool.hpp"
+#include "test_harness.hpp"
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+void run_thread_pool_tests(billing::test::TestSuite &suite) {
+  using billing::core::CancellationToken;
+  using billing::core::TaskCancelled;
+  using billing::core::ThreadPool;
+
+  suite.run("ThreadPool: Futures carry results and exceptions", [] {
+    ThreadPool pool(3);
+    std::vector<std::future<int>> futs;
+    for (int i = 0; i < 100; ++i)
+      futs.push_back(pool.submit([i] { return i * i; }));
+    long sum = 0;
+    for (auto &f : futs)
+      sum += pool.get(f);
+    ASSERT_EQ(sum, 328350L);
+    auto bad = pool.submit([]() -> int { throw std::runtime_error("boom"); });
+    ASSERT_THROWS(bad.get());
+    ASSERT_THROWS(ThreadPool(0));
+  });
+
+  suite.run("ThreadPool: Cancelled tasks are skipped", [] {
+    ThreadPool pool(1);
+    std::promise<void> gate;
+    auto opened = gate.get_future().share();
+    auto blocker = pool.submit([opened] { opened.wait(); });
+    CancellationToken token;
+    std::atomic<bool> ran{false};
+    auto skipped = pool.submit(token, [&] { ran = true; });
+    auto other = pool.submit([] { return 7; });
+    token.cancel(); // while both are still queued behind the blocker
+    gate.set_value();
+    bool cancelled = false;
+    try {
+      skipped.get();
+    } catch (const TaskCancelled &) {
+      cancelled = true;
+    }
+    ASSERT_TRUE(cancelled);
+    ASSERT_FALSE(ran.load());
+    ASSERT_EQ(other.get(), 7); // other tasks are unaffected
+    blocker.get();
+  });
+
+  suite.run("ThreadPool: Nested waits do not deadlock one thread", [] {
+    ThreadPool pool(1);
+    auto outer = pool.submit([&pool] {
+      std::vector<std::future<int>> inner;
+      for (int i = 1; i <= 10; ++i)
+        inner.push_back(pool.submit([i] { return i; }));
+      int sum = 0;
+      for (auto &f : inner)
+        sum += pool.get(f);
+      return sum;
+    });
+    ASSERT_EQ(pool.get(outer), 55);
+  });
+
+  suite.run("ThreadPool: Idle workers steal; destructor drains", [] {
+    std::atomic<int> done{0};
+    std::size_t steals = 0;
+    {
+      ThreadPool pool(4);
+      // Every subtask lands on the parent's own deque; the others must steal
+      auto parent = pool.submit([&] {
+        std::vector<std::future<void>> subs;
+        for (int i = 0; i < 64; ++i)
+          subs.push_back(pool.submit([&] {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            done++;
+          }));
+        pool.wait_all(subs);
+      });
+      pool.get(parent);
+      steals = pool.steals();
+      for (int i = 0; i < 100; ++i)
+        pool.execute([&] { done++; });
+    }
+    ASSERT_EQ(done.load(), 164);
+    ASSERT_GT(steals, 0u);
+  });
+}
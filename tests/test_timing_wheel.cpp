@@ -0,0 +1,99 @@
+// test_timing_wheel.cpp
+#include "../src/core/timing_wheel.hpp"
+#include "test_harness.hpp"
+#include <map>
+#include <random>
+#include <vector>
+
+void run_timing_wheel_tests(billing::test::TestSuite &suite) {
+  using billing::core::TimingWheel;
+
+  suite.run("TimingWheel: Expires in due order across levels", [] {
+    const std::time_t start = 1700000000;
+    TimingWheel<int64_t> wheel(start);
+    std::map<int64_t, std::time_t> pending; // id -> deadline
+    std::mt19937_64 rng(42);
+    for (int64_t id = 1; id <= 5000; ++id) {
+      // Spread from seconds to years ahead so every level is used
+      std::time_t ahead = static_cast<std::time_t>(rng() % (1u << (id % 30)));
+      wheel.schedule(id, start + ahead);
+      pending[id] = start + ahead;
+    }
+    std::time_t now = start, last_deadline = 0;
+    while (!pending.empty()) {
+      now += static_cast<std::time_t>(rng() % (1u << (rng() % 28)));
+      wheel.advance(now, [&](int64_t id, std::time_t deadline) {
+        ASSERT_EQ(pending.count(id), 1u);
+        ASSERT_EQ(pending[id], deadline);
+        ASSERT_TRUE(deadline <= now);
+        ASSERT_TRUE(deadline >= last_deadline);
+        last_deadline = deadline;
+        pending.erase(id);
+      });
+      for (auto &[id, deadline] : pending)
+        ASSERT_TRUE(deadline > now);
+      ASSERT_EQ(wheel.size(), pending.size());
+    }
+    ASSERT_TRUE(wheel.empty());
+  });
+
+  suite.run("TimingWheel: Cancel and reschedule", [] {
+    TimingWheel<int64_t> wheel(1000);
+    ASSERT_TRUE(wheel.schedule(1, 1010));
+    ASSERT_TRUE(wheel.schedule(2, 5000));
+    ASSERT_TRUE(wheel.schedule(3, 90000));
+    ASSERT_FALSE(wheel.schedule(3, 1020)); // moved, not added
+    ASSERT_EQ(*wheel.deadline_of(3), 1020);
+    ASSERT_TRUE(wheel.cancel(1));
+    ASSERT_FALSE(wheel.cancel(1));
+    ASSERT_FALSE(wheel.contains(1));
+    std::vector<int64_t> fired;
+    auto collect = [&](int64_t id, std::time_t) { fired.push_back(id); };
+    ASSERT_EQ(wheel.advance(2000, collect), 1u);
+    ASSERT_EQ(fired.size(), 1u);
+    ASSERT_EQ(fired[0], 3);
+    ASSERT_EQ(wheel.size(), 1u);
+    // The clock never goes back; late entries expire on the next advance
+    ASSERT_EQ(wheel.advance(1500, collect), 0u);
+    wheel.schedule(4, 10);
+    ASSERT_EQ(wheel.advance(2000, collect), 1u);
+    ASSERT_EQ(fired.back(), 4);
+  });
+
+  suite.run("TimingWheel: Earliest tracks the minimum", [] {
+    const std::time_t start = 1700000000;
+    TimingWheel<int64_t> wheel(start);
+    ASSERT_FALSE(wheel.earliest().has_value());
+    std::multimap<std::time_t, int64_t> by_due;
+    std::mt19937_64 rng(7);
+    for (int64_t id = 1; id <= 2000; ++id) {
+      std::time_t due = start + static_cast<std::time_t>(rng() % 86400000);
+      wheel.schedule(id, due);
+      by_due.emplace(due, id);
+    }
+    while (!by_due.empty()) {
+      auto e = wheel.earliest();
+      ASSERT_TRUE(e.has_value());
+      ASSERT_EQ(e->deadline, by_due.begin()->first);
+      wheel.cancel(e->id);
+      by_due.erase(by_due.begin());
+      if (by_due.size() % 500 == 0)
+        wheel.advance(start + 86400 * static_cast<std::time_t>(by_due.size()),
+                      [&](int64_t, std::time_t deadline) {
+                        by_due.erase(by_due.find(deadline));
+                      });
+    }
+    ASSERT_TRUE(wheel.empty());
+  });
+
+  suite.run("TimingWheel: Coarse ticks expire whole buckets", [] {
+    TimingWheel<int64_t> wheel(0, 3600);
+    wheel.schedule(1, 3600 * 5 + 10);
+    wheel.schedule(2, 3600 * 5 + 3500);
+    wheel.schedule(3, 3600 * 6);
+    std::size_t n = wheel.advance(3600 * 5, [](int64_t, std::time_t) {});
+    ASSERT_EQ(n, 2u); // both share the hour-5 bucket
+    ASSERT_EQ(wheel.now(), 3600 * 5);
+    ASSERT_EQ(wheel.size(), 1u);
+  });
+}
@@ -0,0 +1,254 @@
+// test_write_ahead_log.cpp
+#include "../src/core/write_ahead_log.hpp"
+#include "../src/repository/customer_repository.hpp"
+#include "../src/repository/invoice_repository.hpp"
+#include "../src/repository/write_batch.hpp"
+#include "test_harness.hpp"
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+void run_write_ahead_log_tests(billing::test::TestSuite &suite) {
+  using namespace billing;
+  using core::SyncPolicy;
+  using core::WALOptions;
+  using core::WriteAheadLog;
+  using test::make_invoice;
+  using test::scratch_dir;
+
+  suite.run("WAL: Appended records replay in order", [] {
+    auto path = scratch_dir("wal", "order") + "/log.wal";
+    {
+      WriteAheadLog wal(path);
+      wal.recover([](const char *, std::size_t) {});
+      for (int i = 0; i < 10; ++i)
+        wal.commit(wal.append("rec" + std::to_string(i)));
+    }
+    std::vector<std::string> seen;
+    auto n = WriteAheadLog::replay_file(
+        path, [&](const char *d, std::size_t len) { seen.emplace_back(d, len); });
+    ASSERT_EQ(n, 10u);
+    ASSERT_EQ(seen.front(), "rec0");
+    ASSERT_EQ(seen.back(), "rec9");
+  });
+
+  suite.run("WAL: Torn tail is dropped on recovery", [] {
+    auto path = scratch_dir("wal", "torn") + "/log.wal";
+    {
+      WriteAheadLog wal(path);
+      wal.recover([](const char *, std::size_t) {});
+      wal.commit(wal.append("good"));
+    }
+    {
+      std::ofstream f(path, std::ios::binary | std::ios::app);
+      f.write("\x40\x00\x00\x00garbage", 11); // header claims 64 bytes
+    }
+    WriteAheadLog wal(path);
+    int replayed = 0;
+    wal.recover([&](const char *, std::size_t) { replayed++; });
+    ASSERT_EQ(replayed, 1);
+    wal.commit(wal.append("after"));
+    wal.close();
+    ASSERT_EQ(WriteAheadLog::replay_file(path, [](const char *, std::size_t) {}),
+              2u);
+  });
+
+  suite.run("WAL: Group commit shares fsyncs across writers", [] {
+    auto path = scratch_dir("wal", "group") + "/log.wal";
+    WriteAheadLog wal(path, WALOptions{SyncPolicy::GROUP_COMMIT});
+    wal.recover([](const char *, std::size_t) {});
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t)
+      threads.emplace_back([&] {
+        for (int i = 0; i < 50; ++i)
+          wal.commit(wal.append("x"));
+      });
+    for (auto &th : threads)
+      th.join();
+    ASSERT_EQ(wal.durable_lsn(), wal.written_lsn());
+    ASSERT_TRUE(wal.fsync_count() <= 200u);
+  });
+
+  suite.run("InvoiceRepository: Mutations survive reopen via WAL replay", [] {
+    auto dir = scratch_dir("wal", "repo");
+    {
+      repository::InvoiceRepository repo(dir);
+      repo.save(make_invoice(1, 7, 100.0));
+      repo.save(make_invoice(2, 7, 200.0));
+      auto inv = make_invoice(1, 7, 150.0);
+      inv.status = models::InvoiceStatus::PAID;
+      repo.update(inv);
+      repo.remove(2);
+    }
+    repository::InvoiceRepository repo(dir);
+    ASSERT_EQ(repo.count(), 1u);
+    auto inv = repo.find_by_id(1);
+    ASSERT_TRUE(inv.has_value());
+    ASSERT_NEAR(inv->total_amount, 150.0, 0.001);
+    ASSERT_TRUE(inv->status == models::InvoiceStatus::PAID);
+    ASSERT_EQ(inv->line_items.size(), 1u);
+  });
+
+  suite.run("InvoiceRepository: Checkpoint compacts log into snapshot", [] {
+    auto dir = scratch_dir("wal", "checkpoint");
+    {
+      repository::InvoiceRepository repo(dir);
+      for (int i = 1; i <= 20; ++i)
+        repo.save(make_invoice(i, 7, i * 10.0));
+      ASSERT_GT(repo.wal_bytes(), 0u);
+      repo.checkpoint();
+      ASSERT_EQ(repo.wal_bytes(), 0u);
+      repo.save(make_invoice(21, 7, 210.0));
+    }
+    repository::InvoiceRepository repo(dir);
+    ASSERT_EQ(repo.count(), 21u);
+    ASSERT_TRUE(repo.find_by_id(21).has_value());
+    ASSERT_FALSE(std::filesystem::exists(dir + "/invoices.wal.1"));
+  });
+
+  suite.run("WAL: Failed write is cut back, later frames replay", [] {
+    auto path = scratch_dir("wal", "short_write") + "/log.wal";
+    {
+      WriteAheadLog wal(path);
+      wal.recover([](const char *, std::size_t) {});
+      wal.commit(wal.append("first"));
+      auto good = std::filesystem::file_size(path);
+      {
+        test::FileSizeLimit cap(good + 4); // a short write, then EFBIG
+        ASSERT_THROWS(wal.append(std::string(100, 'x')));
+      }
+      ASSERT_EQ(std::filesystem::file_size(path), good);
+      ASSERT_FALSE(wal.failed());
+      wal.commit(wal.append("second"));
+    }
+    std::vector<std::string> seen;
+    WriteAheadLog::replay_file(path, [&](const char *d, std::size_t n) {
+      seen.emplace_back(d, n);
+    });
+    ASSERT_EQ(seen.size(), 2u);
+    ASSERT_EQ(seen.back(), "second");
+  });
+
+  suite.run("InvoiceRepository: Failed log append changes nothing", [] {
+    auto dir = scratch_dir("wal", "append_fail");
+    {
+      repository::InvoiceRepository repo(dir);
+      repo.save(make_invoice(1, 7, 100.0));
+      {
+        test::FileSizeLimit cap(
+            std::filesystem::file_size(dir + "/invoices.wal"));
+        ASSERT_THROWS(repo.update(make_invoice(1, 7, 999.0)));
+        ASSERT_THROWS(repo.save(make_invoice(2, 7, 5.0)));
+        ASSERT_THROWS(repo.remove(1));
+      }
+      ASSERT_NEAR(repo.find_by_id(1)->total_amount, 100.0, 0.001);
+      ASSERT_FALSE(repo.find_by_id(2).has_value());
+      ASSERT_EQ(repo.count(), 1u);
+      ASSERT_TRUE(repo.verify_indexes());
+      repo.save(make_invoice(3, 7, 30.0));
+    }
+    repository::InvoiceRepository repo(dir);
+    ASSERT_EQ(repo.count(), 2u);
+    ASSERT_NEAR(repo.find_by_id(1)->total_amount, 100.0, 0.001);
+  });
+
+  suite.run("WriteBatch: Commit spans repositories with one log frame", [] {
+    auto dir = scratch_dir("wal", "batch");
+    {
+      repository::CustomerRepository customers(dir);
+      repository::InvoiceRepository invoices(dir);
+      repository::WriteBatch batch;
+      models::Customer c{};
+      c.id = 99;
+      c.name = "Batch Customer";
+      c.email = "batch@example.com";
+      batch.save(c);
+      for (int i = 1; i <= 100; ++i)
+        batch.save(make_invoice(i, 7, i * 1.0));
+      batch.update(make_invoice(500, 7, 1.0)); // missing — skipped
+      ASSERT_EQ(batch.commit(customers, invoices), 101u);
+      ASSERT_TRUE(batch.empty());
+      ASSERT_EQ(invoices.count(), 100u);
+      ASSERT_TRUE(customers.find_by_id(99).has_value());
+    }
+    std::size_t frames = core::WriteAheadLog::replay_file(
+        dir + "/invoices.wal", [](const char *, std::size_t) {});
+    ASSERT_EQ(frames, 1u);
+    repository::InvoiceRepository reopened(dir);
+    ASSERT_EQ(reopened.count(), 100u);
+  });
+
+  suite.run("WriteBatch: Failed log append shows none of the batch", [] {
+    auto dir = scratch_dir("wal", "batch_fail");
+    repository::InvoiceRepository invoices(dir);
+    invoices.save(make_invoice(1, 7, 10.0));
+    invoices.save(make_invoice(2, 7, 20.0));
+    repository::WriteBatch batch;
+    batch.save(make_invoice(3, 7, 30.0));
+    batch.update(make_invoice(1, 7, 99.0));
+    batch.remove_invoice(2);
+    batch.remove_invoice(3); // removes what the batch itself saved
+    {
+      test::FileSizeLimit cap(
+          std::filesystem::file_size(dir + "/invoices.wal"));
+      ASSERT_THROWS(batch.commit(invoices));
+    }
+    ASSERT_EQ(invoices.count(), 2u);
+    ASSERT_NEAR(invoices.find_by_id(1)->total_amount, 10.0, 0.001);
+    ASSERT_TRUE(invoices.find_by_id(2).has_value());
+    ASSERT_FALSE(invoices.find_by_id(3).has_value());
+    ASSERT_TRUE(invoices.verify_indexes());
+  });
+
+  suite.run("WriteBatch: Modify edits the record as of commit", [] {
+    auto dir = scratch_dir("wal", "batch_modify");
+    {
+      repository::InvoiceRepository invoices(dir);
+      invoices.save(make_invoice(1, 7, 10.0, 100));
+      invoices.save(make_invoice(2, 7, 20.0, 100));
+      repository::WriteBatch batch;
+      auto set_due = [](std::time_t from, std::time_t to) {
+        return [from, to](models::Invoice &inv) {
+          if (inv.due_date != from)
+            return false;
+          inv.due_date = to;
+          return true;
+        };
+      };
+      batch.modify_invoice(1, set_due(100, 200));
+      batch.modify_invoice(2, set_due(999, 200)); // no longer matches
+      batch.modify_invoice(3, set_due(100, 200)); // missing — skipped
+      batch.save(make_invoice(4, 7, 40.0, 100));
+      batch.modify_invoice(4, set_due(100, 300)); // sees the staged save
+
+      // Written after staging: the modify must not overwrite it
+      invoices.modify(1, [](models::Invoice &inv) {
+        inv.status = models::InvoiceStatus::PAID;
+      });
+      ASSERT_EQ(batch.commit(invoices), 3u);
+      auto one = invoices.find_by_id(1);
+      ASSERT_EQ(one->due_date, 200);
+      ASSERT_TRUE(one->status == models::InvoiceStatus::PAID);
+      ASSERT_EQ(invoices.find_by_id(2)->due_date, 100);
+      ASSERT_FALSE(invoices.find_by_id(3).has_value());
+      ASSERT_EQ(invoices.find_by_id(4)->due_date, 300);
+      ASSERT_TRUE(invoices.verify_indexes());
+    }
+    repository::InvoiceRepository reopened(dir);
+    ASSERT_EQ(reopened.find_by_id(1)->due_date, 200);
+    ASSERT_TRUE(reopened.find_by_id(1)->status ==
+                models::InvoiceStatus::PAID);
+    ASSERT_EQ(reopened.find_by_id(4)->due_date, 300);
+  });
+
+  suite.run("WriteBatch: Commit without the owning repository throws", [] {
+    auto dir = scratch_dir("wal", "batch_missing");
+    repository::InvoiceRepository invoices(dir);
+    repository::WriteBatch batch;
+    models::Customer c{};
+    c.id = 1;
+    batch.save(c);
+    ASSERT_THROWS(batch.commit(invoices));
+  });
+}